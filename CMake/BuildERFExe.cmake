@@ -66,6 +66,7 @@ function(build_erf_lib erf_lib_name)
                    ${SRC_DIR}/IO/ERF_NCMultiFabFile.cpp
                    ${SRC_DIR}/IO/ERF_ReadFromMetgrid.cpp
                    ${SRC_DIR}/IO/ERF_ReadFromWRFBdy.cpp
+                   ${SRC_DIR}/IO/ERF_WRFBdyStream.cpp
                    ${SRC_DIR}/IO/ERF_ReadFromWRFInput.cpp
                    ${SRC_DIR}/IO/ERF_NCColumnFile.cpp)
     target_compile_definitions(${erf_lib_name} PUBLIC ERF_USE_NETCDF)
@@ -144,10 +145,13 @@ function(build_erf_lib erf_lib_name)
        ${SRC_DIR}/IO/ERF_Checkpoint.cpp
        ${SRC_DIR}/IO/ERF_ReadBndryPlanes.cpp
        ${SRC_DIR}/IO/ERF_WriteBndryPlanes.cpp
+       ${SRC_DIR}/IO/ERF_SliceOutput.cpp
+       ${SRC_DIR}/IO/ERF_ProbeSampler.cpp
        ${SRC_DIR}/IO/ERF_Write1DProfiles.cpp
        ${SRC_DIR}/IO/ERF_Write1DProfiles_stag.cpp
        ${SRC_DIR}/IO/ERF_WriteScalarProfiles.cpp
        ${SRC_DIR}/IO/ERF_Plotfile.cpp
+       ${SRC_DIR}/IO/ERF_ZPlotfile.cpp
        ${SRC_DIR}/IO/ERF_writeJobInfo.cpp
        ${SRC_DIR}/IO/ERF_console_io.cpp
        ${SRC_DIR}/PBL/ERF_ComputeDiffusivityMYNN25.cpp
@@ -189,6 +193,8 @@ function(build_erf_lib erf_lib_name)
        ${SRC_DIR}/Microphysics/Kessler/ERF_Init_Kessler.cpp
        ${SRC_DIR}/Microphysics/Kessler/ERF_Kessler.cpp
        ${SRC_DIR}/Microphysics/Kessler/ERF_Update_Kessler.cpp
+	   ${SRC_DIR}/WindFarmParametrization/ERF_TurbineIndex.cpp
+	   ${SRC_DIR}/WindFarmParametrization/ERF_WindFarmTagging.cpp
 	   ${SRC_DIR}/WindFarmParametrization/Fitch/ERF_AdvanceFitch.cpp
 	   ${SRC_DIR}/WindFarmParametrization/EWP/ERF_AdvanceEWP.cpp
 	   ${SRC_DIR}/WindFarmParametrization/SimpleActuatorDisk/ERF_AdvanceSimpleAD.cpp
@@ -0,0 +1,217 @@
+/**
+ * \file main_zplt.cpp
+ *
+ * Reader / checker for compressed ERF plotfiles (erf.plotfile_type = compressed)
+ *
+ *   erf_zplt --to plt00010 zplt00010        decompress into a native AMReX plotfile
+ *   erf_zplt --compare plt00010 zplt00010   fcompare-style check against a native plotfile;
+ *                                           returns nonzero if any error bound is exceeded
+ */
+
+#include <AMReX.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_PlotFileUtil.H>
+#include <AMReX_ParallelDescriptor.H>
+
+#include "ERF_ZPlotfile.H"
+
+#include <iomanip>
+#include <limits>
+
+using namespace amrex;
+
+namespace {
+
+void print_usage ()
+{
+    Print() << "\n"
+            << " Read a compressed ERF plotfile and either write it as a native plotfile\n"
+            << " or compare it against a native plotfile.\n\n"
+            << " usage:\n"
+            << "    erf_zplt [--to pltfile] [--compare pltfile] zpltfile\n\n"
+            << " optional arguments:\n"
+            << "    --to pltfile      : write the decompressed data to a native plotfile\n"
+            << "    --compare pltfile : report the max abs difference per variable and level\n"
+            << "                        against a native plotfile and check the stored bounds\n"
+            << std::endl;
+}
+
+struct ZPltMeta
+{
+    Vector<std::string> varnames;
+    Real time;
+    int finest_level;
+    Vector<Geometry> geom;
+    Vector<int> level_steps;
+    Vector<IntVect> ref_ratio;
+    Vector<std::string> level_path;
+};
+
+// Parse the generic plotfile Header written by ERF::WriteCompressedPlotfile
+ZPltMeta read_header (const std::string& dir)
+{
+    ZPltMeta meta;
+
+    Vector<char> fileCharPtr;
+    ParallelDescriptor::ReadAndBcastFile(dir + "/Header", fileCharPtr);
+    std::string fileCharPtrString(fileCharPtr.dataPtr());
+    std::istringstream is(fileCharPtrString, std::istringstream::in);
+
+    std::string version;
+    std::getline(is, version);
+    if (version != ZPlotfile::version_string) {
+        Abort(dir + " is not a compressed ERF plotfile");
+    }
+
+    int nvars;
+    is >> nvars;
+    meta.varnames.resize(nvars);
+    for (int n = 0; n < nvars; ++n) {
+        is >> meta.varnames[n];
+    }
+
+    int dim;
+    is >> dim;
+    AMREX_ALWAYS_ASSERT(dim == AMREX_SPACEDIM);
+    is >> meta.time;
+    is >> meta.finest_level;
+
+    const int nlevels = meta.finest_level + 1;
+
+    Array<Real,AMREX_SPACEDIM> problo, probhi;
+    for (int i = 0; i < AMREX_SPACEDIM; ++i) is >> problo[i];
+    for (int i = 0; i < AMREX_SPACEDIM; ++i) is >> probhi[i];
+
+    Vector<int> rr(meta.finest_level);
+    for (int i = 0; i < meta.finest_level; ++i) is >> rr[i];
+
+    Vector<Box> domain(nlevels);
+    for (int i = 0; i < nlevels; ++i) is >> domain[i];
+
+    meta.level_steps.resize(nlevels);
+    for (int i = 0; i < nlevels; ++i) is >> meta.level_steps[i];
+
+    Real dx;
+    for (int i = 0; i < nlevels; ++i) {
+        for (int k = 0; k < AMREX_SPACEDIM; ++k) is >> dx;
+    }
+
+    int coord, dummy;
+    is >> coord;
+    is >> dummy;
+
+    RealBox rb(problo.data(), probhi.data());
+    Array<int,AMREX_SPACEDIM> is_per = {AMREX_D_DECL(0,0,0)};
+    meta.geom.resize(nlevels);
+    for (int i = 0; i < nlevels; ++i) {
+        meta.geom[i].define(domain[i], rb, coord, is_per);
+    }
+
+    // Possibly anisotropic ratios follow from the level domains
+    meta.ref_ratio.resize(meta.finest_level);
+    for (int i = 0; i < meta.finest_level; ++i) {
+        meta.ref_ratio[i] = domain[i+1].length() / domain[i].length();
+    }
+
+    meta.level_path.resize(nlevels);
+    for (int i = 0; i < nlevels; ++i) {
+        int lev, nboxes, step;
+        Real lev_time, x;
+        is >> lev >> nboxes >> lev_time;
+        is >> step;
+        for (int b = 0; b < nboxes*AMREX_SPACEDIM*2; ++b) is >> x;
+        is >> meta.level_path[i];
+    }
+
+    return meta;
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc, argv, false);
+    int status = 0;
+    {
+        std::string zpltfile, to_file, cmp_file;
+
+        int farg = 1;
+        while (farg < argc) {
+            std::string name = argv[farg];
+            if (name == "--to" && farg+1 < argc) {
+                to_file = argv[++farg];
+            } else if (name == "--compare" && farg+1 < argc) {
+                cmp_file = argv[++farg];
+            } else if (name[0] == '-') {
+                print_usage();
+                Abort("Unknown option " + name);
+            } else {
+                zpltfile = name;
+            }
+            ++farg;
+        }
+
+        if (zpltfile.empty() || (to_file.empty() && cmp_file.empty())) {
+            print_usage();
+            Abort("Missing arguments");
+        }
+
+        ZPltMeta meta = read_header(zpltfile);
+        const int nlevels = meta.finest_level + 1;
+        const int nvars   = meta.varnames.size();
+
+        Vector<MultiFab> mf(nlevels);
+        Vector<Vector<Real>> abs_err(nlevels);
+        for (int lev = 0; lev < nlevels; ++lev) {
+            ZPlotfile::ReadLevel(zpltfile + "/" + meta.level_path[lev], mf[lev], abs_err[lev]);
+            AMREX_ALWAYS_ASSERT(mf[lev].nComp() == nvars);
+        }
+
+        if (!to_file.empty()) {
+            Print() << "Writing native plotfile " << to_file << "\n";
+            WriteMultiLevelPlotfile(to_file, nlevels, GetVecOfConstPtrs(mf), meta.varnames,
+                                    meta.geom, meta.time, meta.level_steps, meta.ref_ratio);
+        }
+
+        if (!cmp_file.empty()) {
+            PlotFileData pf(cmp_file);
+            AMREX_ALWAYS_ASSERT(pf.finestLevel() >= meta.finest_level);
+
+            Print() << std::setw(24) << std::left << " variable name"
+                    << std::setw(6) << "level"
+                    << std::setw(24) << "max abs error"
+                    << std::setw(24) << "stored bound" << "\n";
+
+            for (int lev = 0; lev < nlevels; ++lev) {
+                for (int n = 0; n < nvars; ++n) {
+                    const MultiFab& ref = pf.get(lev, meta.varnames[n]);
+
+                    MultiFab diff(mf[lev].boxArray(), mf[lev].DistributionMap(), 1, 0);
+                    diff.ParallelCopy(ref, 0, 0, 1);
+                    MultiFab::Subtract(diff, mf[lev], n, 0, 1, 0);
+
+                    const Real err   = diff.norminf(0);
+                    const Real scale = ref.norminf(0);
+
+                    // Lossless components are checked to round-off only
+                    const Real allowed = abs_err[lev][n] * (1.0 + 1.0e-6)
+                                       + 10.0 * std::numeric_limits<Real>::epsilon() * scale;
+                    const bool ok = (err <= allowed);
+                    if (!ok) status = 1;
+
+                    Print() << " " << std::setw(23) << std::left << meta.varnames[n]
+                            << std::setw(6) << lev
+                            << std::setw(24) << std::setprecision(10) << err
+                            << std::setw(24) << std::setprecision(10) << abs_err[lev][n]
+                            << (ok ? "" : "  <-- bound exceeded") << "\n";
+                }
+            }
+
+            if (status == 0) {
+                Print() << " all variables within their error bounds\n";
+            }
+        }
+    }
+    amrex::Finalize();
+    return status;
+}
@@ -1,7 +1,43 @@
 #include <ERF_ABLMost.H>
+#include <ERF_ParFunctions.H>
 
 using namespace amrex;
 
+/**
+ * Move the surface fields of a level onto a new DistributionMapping of its grids.
+ * The SST, land mask and LSM data are moved in place by the caller, so only the
+ * pointers to data that are remade with the level are reset here.
+ *
+ * @param[in] lev Current level
+ * @param[in] dm New DistributionMapping of the level
+ * @param[in] z_phys_nd Terrain height coords at each level
+ * @param[in] Hwave Wave heights at each level
+ * @param[in] Lwave Wave lengths at each level
+ * @param[in] eddyDiffs Eddy diffusivities at each level
+ */
+void
+ABLMost::redistribute_level (const int& lev,
+                             const DistributionMapping& dm,
+                             Vector<std::unique_ptr<MultiFab>>& z_phys_nd,
+                             Vector<std::unique_ptr<MultiFab>>& Hwave,
+                             Vector<std::unique_ptr<MultiFab>>& Lwave,
+                             Vector<std::unique_ptr<MultiFab>>& eddyDiffs)
+{
+    redistribute_in_place(*u_star[lev], dm);
+    redistribute_in_place(*w_star[lev], dm);
+    redistribute_in_place(*t_star[lev], dm);
+    redistribute_in_place(*q_star[lev], dm);
+    redistribute_in_place(*olen[lev]  , dm);
+    redistribute_in_place(*pblh[lev]  , dm);
+    redistribute_in_place(*t_surf[lev], dm);
+
+    m_Hwave_lev[lev]     = Hwave[lev].get();
+    m_Lwave_lev[lev]     = Lwave[lev].get();
+    m_eddyDiffs_lev[lev] = eddyDiffs[lev].get();
+
+    m_ma.redistribute_level(lev, dm, z_phys_nd);
+}
+
 /**
  * Wrapper to update ustar and tstar for Monin Obukhov similarity theory.
  *
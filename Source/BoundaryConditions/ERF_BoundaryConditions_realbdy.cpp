@@ -50,6 +50,14 @@ ERF::fill_from_realbdy (const Vector<MultiFab*>& mfs,
     // End of vars loop
     int var_idx_end = (cons_only) ? Vars::cons + 1 : Vars::NumTypes;
 
+    // When streaming, this rank only holds the sides its grids need (xlo, xhi, ylo, yhi)
+    bool held[4] = {true, true, true, true};
+    if (m_bdy_stream) {
+        for (int side = 0; side < 4; ++side) {
+            held[side] = m_bdy_stream->held(side);
+        }
+    }
+
     // Loop over all variable types
     for (int var_idx = Vars::cons; var_idx < var_idx_end; ++var_idx)
     {
@@ -82,14 +90,24 @@ ERF::fill_from_realbdy (const Vector<MultiFab*>& mfs,
                 // Then to interpolate, given time, we can define n = (time/dT)
                 // and alpha = (time - n*dT) / dT, then we define the data at time
                 // as  alpha * (data at time n+1) + (1 - alpha) * (data at time n)
-                const auto& bdatxlo_n   = bdy_data_xlo[n_time  ][ivar].const_array();
-                const auto& bdatxlo_np1 = bdy_data_xlo[n_time+1][ivar].const_array();
-                const auto& bdatxhi_n   = bdy_data_xhi[n_time  ][ivar].const_array();
-                const auto& bdatxhi_np1 = bdy_data_xhi[n_time+1][ivar].const_array();
-                const auto& bdatylo_n   = bdy_data_ylo[n_time  ][ivar].const_array();
-                const auto& bdatylo_np1 = bdy_data_ylo[n_time+1][ivar].const_array();
-                const auto& bdatyhi_n   = bdy_data_yhi[n_time  ][ivar].const_array();
-                const auto& bdatyhi_np1 = bdy_data_yhi[n_time+1][ivar].const_array();
+                Array4<const Real> bdatxlo_n, bdatxlo_np1, bdatxhi_n, bdatxhi_np1;
+                Array4<const Real> bdatylo_n, bdatylo_np1, bdatyhi_n, bdatyhi_np1;
+                if (held[0]) {
+                    bdatxlo_n   = bdy_data_xlo[n_time  ][ivar].const_array();
+                    bdatxlo_np1 = bdy_data_xlo[n_time+1][ivar].const_array();
+                }
+                if (held[1]) {
+                    bdatxhi_n   = bdy_data_xhi[n_time  ][ivar].const_array();
+                    bdatxhi_np1 = bdy_data_xhi[n_time+1][ivar].const_array();
+                }
+                if (held[2]) {
+                    bdatylo_n   = bdy_data_ylo[n_time  ][ivar].const_array();
+                    bdatylo_np1 = bdy_data_ylo[n_time+1][ivar].const_array();
+                }
+                if (held[3]) {
+                    bdatyhi_n   = bdy_data_yhi[n_time  ][ivar].const_array();
+                    bdatyhi_np1 = bdy_data_yhi[n_time+1][ivar].const_array();
+                }
 
 #ifdef AMREX_USE_OMP
 #pragma omp parallel if (Gpu::notInLaunchRegion())
@@ -104,6 +122,12 @@ ERF::fill_from_realbdy (const Vector<MultiFab*>& mfs,
                                                   bx_xlo, bx_xhi,
                                                   bx_ylo, bx_yhi, ng_vect);
 
+                    // Only fill the sides this box touches and this rank holds
+                    if (!held[0]) { AMREX_ASSERT(!bx_xlo.ok()); bx_xlo = Box(); }
+                    if (!held[1]) { AMREX_ASSERT(!bx_xhi.ok()); bx_xhi = Box(); }
+                    if (!held[2]) { AMREX_ASSERT(!bx_ylo.ok()); bx_ylo = Box(); }
+                    if (!held[3]) { AMREX_ASSERT(!bx_yhi.ok()); bx_yhi = Box(); }
+
                     // x-faces (includes exterior y ghost cells)
                     ParallelFor(bx_xlo, bx_xhi,
                     [=] AMREX_GPU_DEVICE (int i, int j, int k)
@@ -1,6 +1,7 @@
 #include <ERF_MOSTAverage.H>
 #include <utility>
 #include <ERF_TileNoZ.H>
+#include <ERF_ParFunctions.H>
 
 using namespace amrex;
 
@@ -239,6 +240,32 @@ MOSTAverage::update_field_ptrs (int lev,
     m_fields[lev][5] = &vars_old[lev][Vars::zvel];
 }
 
+/**
+ * Function to move the data of a level onto a new DistributionMapping
+ * of the same grids. The field pointers are reset by update_field_ptrs.
+ *
+ * @param[in] lev Current level
+ * @param[in] dm New DistributionMapping of the level
+ * @param[in] z_phys_nd Terrain height coords at each level
+ */
+void
+MOSTAverage::redistribute_level (int lev,
+                                 const DistributionMapping& dm,
+                                 Vector<std::unique_ptr<MultiFab>>& z_phys_nd)
+{
+    m_z_phys_nd[lev] = z_phys_nd[lev].get();
+
+    for (auto& mf : m_averages[lev])   { if (mf) redistribute_in_place(*mf, dm); }
+    for (auto& mf : m_rot_fields[lev]) { if (mf) redistribute_in_place(*mf, dm); }
+
+    if (m_x_pos[lev])  redistribute_in_place(*m_x_pos[lev] , dm);
+    if (m_y_pos[lev])  redistribute_in_place(*m_y_pos[lev] , dm);
+    if (m_z_pos[lev])  redistribute_in_place(*m_z_pos[lev] , dm);
+    if (m_i_indx[lev]) redistribute_in_place(*m_i_indx[lev], dm);
+    if (m_j_indx[lev]) redistribute_in_place(*m_j_indx[lev], dm);
+    if (m_k_indx[lev]) redistribute_in_place(*m_k_indx[lev], dm);
+}
+
 /**
  * Function to set the rotated velocities.
  *
@@ -10,6 +10,7 @@
 #include <ERF.H>
 
 #include <AMReX_buildInfo.H>
+#include <AMReX_AsyncOut.H>
 
 #include <ERF_Utils.H>
 #include <ERF_TerrainMetrics.H>
@@ -25,6 +26,7 @@ Real ERF::startCPUTime        = 0.0;
 Real ERF::previousCPUTimeUsed = 0.0;
 
 Vector<AMRErrorTag> ERF::ref_tags;
+Vector<StateTag>    ERF::state_tags;
 
 SolverChoice ERF::solverChoice;
 
@@ -61,6 +63,8 @@ Vector<Vector<std::string>> ERF::nc_init_file = {{""}}; // Must provide via inpu
 
 // NetCDF wrfbdy (lateral boundary) file
 std::string ERF::nc_bdy_file; // Must provide via input
+bool ERF::nc_read_local = false;
+bool ERF::real_bdy_stream = false;
 
 // Flag to trigger initialization from input_sounding like WRF's ideal.exe
 bool ERF::init_sounding_ideal = false;
@@ -124,6 +128,8 @@ ERF::ERF_shared ()
 #endif
 
 #if defined(ERF_USE_RRTMGP)
+    rad.resize(nlevs_max);
+    rad_check.resize(nlevs_max);
     qheating_rates.resize(nlevs_max);
     sw_lw_fluxes.resize(nlevs_max);
     solar_zenith.resize(nlevs_max);
@@ -144,6 +150,9 @@ ERF::ERF_shared ()
     const std::string& pv1 = "plot_vars_1"; setPlotVariables(pv1,plot_var_names_1);
     const std::string& pv2 = "plot_vars_2"; setPlotVariables(pv2,plot_var_names_2);
 
+    setPlotErrorBounds(pv1, "plot_err_bound_1", plot_err_bounds_1);
+    setPlotErrorBounds(pv2, "plot_err_bound_2", plot_err_bounds_2);
+
     // Initialize staggered vertical levels for grid stretching or terrain, and
     // to simplify Rayleigh damping layer calculations.
     zlevels_stag.resize(max_level+1);
@@ -356,8 +365,17 @@ ERF::Evolve ()
         // Make sure we have read enough of the boundary plane data to make it through this timestep
         if (input_bndry_planes)
         {
-            m_r2d->read_input_files(cur_time,dt[0],m_bc_extdir_vals);
+            m_r2d->read_input_files(cur_time,dt[0],m_bc_extdir_vals,vars_new[0]);
+        }
+
+#ifdef ERF_USE_NETCDF
+        // Make sure we hold the lateral boundary data needed through this timestep
+        if (m_bdy_stream)
+        {
+            m_bdy_stream->update(cur_time,dt[0],vars_new[0][Vars::cons],
+                                 bdy_data_xlo,bdy_data_xhi,bdy_data_ylo,bdy_data_yhi);
         }
+#endif
 
         int lev = 0;
         int iteration = 1;
@@ -368,6 +386,13 @@ ERF::Evolve ()
         Print() << "Coarse STEP " << step+1 << " ends." << " TIME = " << cur_time
                 << " DT = " << dt[0]  << std::endl;
 
+#ifdef ERF_USE_NETCDF
+        // The next boundary slice was read while we advanced; join before any other output
+        if (m_bdy_stream) {
+            m_bdy_stream->finish_reads();
+        }
+#endif
+
         post_timestep(step, cur_time, dt[0]);
 
         if (writeNow(cur_time, dt[0], step+1, m_plot_int_1, m_plot_per_1)) {
@@ -421,6 +446,19 @@ ERF::Evolve ()
         }
     }
 
+    if (input_bndry_planes) {
+        m_r2d->print_prefetch_stats();
+    }
+
+    if (output_bndry_planes) {
+        m_w2d->flush(true);
+    }
+
+    // Don't leave until any checkpoint/plotfile data handed to the async writer is on disk
+    if (AsyncOut::UseAsyncOut()) {
+        AsyncOut::Finish();
+    }
+
     BL_PROFILE_VAR_STOP(evolve);
 }
 
@@ -430,9 +468,9 @@ ERF::post_timestep (int nstep, Real time, Real dt_lev0)
 {
     BL_PROFILE("ERF::post_timestep()");
 
-#ifdef ERF_USE_PARTICLES
-    particleData.Redistribute();
-#endif
+    // No global particle Redistribute here: EvolveParticles redistributes once particles
+    // stray beyond redistribute_halo cells, and tagging, plotfile deposition and regridding
+    // redistribute when they need particles in their grids; restart redistributes on read
 
     if (solverChoice.coupling_type == CouplingType::TwoWay)
     {
@@ -541,6 +579,21 @@ ERF::post_timestep (int nstep, Real time, Real dt_lev0)
       }
     }
 
+    if (m_slices)
+    {
+        for (int n = 0; n < m_slices->size(); ++n) {
+            if (is_it_time_for_action(nstep, time, dt_lev0, m_slices->interval(n), m_slices->per(n))) {
+                m_slices->write(n, nstep+1, time, vars_new, finest_level);
+            }
+        }
+    }
+
+    if (m_probes && is_it_time_for_action(nstep, time, dt_lev0, m_probes->interval(), m_probes->per()))
+    {
+        bool terrain_moved = (solverChoice.use_terrain && solverChoice.terrain_type == TerrainType::Moving);
+        m_probes->write(nstep+1, time, geom, vars_new, z_phys_nd, finest_level, terrain_moved);
+    }
+
     // Moving terrain
     if ( solverChoice.use_terrain &&  (solverChoice.terrain_type == TerrainType::Moving) )
     {
@@ -738,7 +791,7 @@ ERF::InitData ()
 
         // We haven't populated dt yet, set to 0 to ensure assert doesn't crash
         Real dt_dummy = 0.0;
-        m_r2d->read_input_files(t_new[0],dt_dummy,m_bc_extdir_vals);
+        m_r2d->read_input_files(t_new[0],dt_dummy,m_bc_extdir_vals,vars_new[0]);
     }
 
     if (solverChoice.custom_rhotheta_forcing)
@@ -859,6 +912,30 @@ ERF::InitData ()
         }
     }
 
+    // Planes, cross-sections and sub-boxes written every few steps
+    if (ParmParse("erf").contains("slice_names"))
+    {
+        m_slices = std::make_unique<SliceOutput>(geom, cons_names, vars_new[0][Vars::cons].nComp());
+        m_slices->truncate(restart_chkfile.empty() ? -1 : istep[0]);
+
+        if (restart_chkfile.empty()) {
+            for (int n = 0; n < m_slices->size(); ++n) {
+                m_slices->write(n, 0, t_new[0], vars_new, finest_level);
+            }
+        }
+    }
+
+    // Probes at arbitrary locations, gathered into a single time series
+    if (ParmParse("erf").contains("probe_locations") || ParmParse("erf").contains("probe_file"))
+    {
+        m_probes = std::make_unique<ProbeSampler>(cons_names, vars_new[0][Vars::cons].nComp());
+        m_probes->truncate(restart_chkfile.empty() ? -1 : istep[0]);
+
+        if (restart_chkfile.empty()) {
+            m_probes->write(0, t_new[0], geom, vars_new, z_phys_nd, finest_level, false);
+        }
+    }
+
 #ifdef ERF_USE_POISSON_SOLVE
     if (restart_chkfile == "")
     {
@@ -1345,6 +1422,18 @@ ERF::ReadParameters ()
         pp.query("restart_type", restart_type);
 
         pp.query("regrid_int", regrid_int);
+
+        // Load balancing on measured costs
+        pp.query("load_balance_int", load_balance_int);
+        pp.query("load_balance_cost", load_balance_cost);
+        pp.query("load_balance_strategy", load_balance_strategy);
+        pp.query("load_balance_verbose", load_balance_verbose);
+        if (load_balance_cost != "cells" && load_balance_cost != "timers") {
+            Abort("erf.load_balance_cost must be cells or timers");
+        }
+        if (load_balance_strategy != "knapsack" && load_balance_strategy != "sfc") {
+            Abort("erf.load_balance_strategy must be knapsack or sfc");
+        }
         pp.query("check_file", check_file);
         pp.query("check_type", check_type);
 
@@ -1359,6 +1448,10 @@ ERF::ReadParameters ()
         pp.query("restart", restart_chkfile);
         pp_amr.query("restart", restart_chkfile);
 
+        // Whether to restart onto new grids, or onto a refined level 0 by interpolation
+        pp.query("restart_regrid", restart_regrid);
+        pp.query("restart_interp", restart_interp);
+
         // Verbosity
         pp.query("v", verbose);
 #ifdef ERF_USE_POISSON_SOLVE
@@ -1436,6 +1529,12 @@ ERF::ReadParameters ()
 
         // NetCDF wrfbdy lateral boundary file
         pp.query("nc_bdy_file", nc_bdy_file);
+
+        // Rank-local reading of the wrfinput/met_em files
+        pp.query("nc_read_local", nc_read_local);
+
+        // Streaming of the wrfbdy lateral boundary data
+        pp.query("real_bdy_stream", real_bdy_stream);
 #endif
 
         // Flag to trigger initialization from input_sounding like WRF's ideal.exe
@@ -1459,8 +1558,15 @@ ERF::ReadParameters ()
         pp.query("destag_profiles", destag_profiles);
 
         pp.query("plot_lsm", plot_lsm);
+
+        // Error bounds for compressed plotfiles
+        pp.query("plot_err_type" , m_plot_err_type);
+        pp.query("plot_err_bound", m_plot_err_bound);
 #ifdef ERF_USE_RRTMGP
         pp.query("plot_rad", plot_rad);
+        pp.query("radiation_coarsen", rad_coarsen);
+        pp.query("radiation_coarsen_check", rad_coarsen_check);
+        AMREX_ALWAYS_ASSERT(rad_coarsen >= 1);
 #endif
 
         pp.query("output_1d_column", output_1d_column);
@@ -1551,7 +1657,7 @@ ERF::ParameterSanityChecks ()
         }
     }
 
-    if (plotfile_type != "amrex" &&
+    if (plotfile_type != "amrex" && plotfile_type != "compressed" &&
         plotfile_type != "netcdf" && plotfile_type != "NetCDF" &&
         plotfile_type != "hdf5"   && plotfile_type != "HDF5" )
     {
@@ -1559,6 +1665,11 @@ ERF::ParameterSanityChecks ()
         Abort("Dont know this plotfile_type");
     }
 
+    if (m_plot_err_type != "relative" && m_plot_err_type != "absolute")
+    {
+        Abort("plot_err_type must be relative or absolute");
+    }
+
     // Enforce the init_type is one we know
     if (!init_type.empty() &&
         init_type != "uniform" &&
@@ -1629,6 +1740,8 @@ ERF::MakeHorizontalAverages ()
     bool use_moisture = (solverChoice.moisture_type != MoistureType::None);
     bool is_anelastic = (solverChoice.anelastic[lev] == 1);
 
+    if (use_moisture) micro->Update_Qmoist_Lev(lev, vars_new[lev][Vars::cons]);
+
     for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
         const Box& bx = mfi.validbox();
         auto  fab_arr = mf.array(mfi);
@@ -1971,8 +2084,17 @@ ERF::Evolve_MB (int MBstep, int max_block_step)
         // Make sure we have read enough of the boundary plane data to make it through this timestep
         if (input_bndry_planes)
         {
-            m_r2d->read_input_files(cur_time,dt[0],m_bc_extdir_vals);
+            m_r2d->read_input_files(cur_time,dt[0],m_bc_extdir_vals,vars_new[0]);
+        }
+
+#ifdef ERF_USE_NETCDF
+        // Make sure we hold the lateral boundary data needed through this timestep
+        if (m_bdy_stream)
+        {
+            m_bdy_stream->update(cur_time,dt[0],vars_new[0][Vars::cons],
+                                 bdy_data_xlo,bdy_data_xhi,bdy_data_ylo,bdy_data_yhi);
         }
+#endif
 
         int lev = 0;
         int iteration = 1;
@@ -1992,6 +2114,13 @@ ERF::Evolve_MB (int MBstep, int max_block_step)
         Print() << "Coarse STEP " << step+1 << " ends." << " TIME = " << cur_time
                        << " DT = " << dt[0]  << std::endl;
 
+#ifdef ERF_USE_NETCDF
+        // The next boundary slice was read while we advanced; join before any other output
+        if (m_bdy_stream) {
+            m_bdy_stream->finish_reads();
+        }
+#endif
+
         post_timestep(step, cur_time, dt[0]);
 
         if (writeNow(cur_time, dt[0], step+1, m_plot_int_1, m_plot_per_1)) {
@@ -1,11 +1,15 @@
 #include <ERF.H>
-#include <ERF_Derive.H>
+#include <ERF_EOS.H>
 
 using namespace amrex;
 
 /**
  * Function to tag cells for refinement -- this overrides the pure virtual function in AmrCore
  *
+ * The criteria on fields of the state (state_tags) are all tested in one pass over each
+ * box, evaluating the fields from the state arrays as they go; the other criteria
+ * (ref_tags) are tested by AMRErrorTag on a MultiFab filled for each of them.
+ *
  * @param[in] levc level of refinement at which we tag cells (0 is coarsest level)
  * @param[out] tags array of tagged cells
  * @param[in] time current time
@@ -17,45 +21,189 @@ ERF::ErrorEst (int levc, TagBoxArray& tags, Real time, int /*ngrow*/)
     const int clearval = TagBox::CLEAR;
     const int   tagval = TagBox::SET;
 
-    for (int j=0; j < ref_tags.size(); ++j)
+    // Criteria on fields of the state that are active at this level and time
+    Vector<StateTagDevice> h_state_tags;
+    bool need_nbrs = false;
+    bool need_vort = false;
+    for (const auto& st : state_tags)
     {
-        std::unique_ptr<MultiFab> mf = std::make_unique<MultiFab>(grids[levc], dmap[levc], 1, 0);
+        if (levc >= st.max_level || time < st.min_time || time > st.max_time) continue;
+
+        StateTagDevice stag;
+        stag.field   = st.field;
+        stag.test    = st.test;
+        stag.value   = st.value[std::min(levc, static_cast<int>(st.value.size())-1)];
+        stag.use_box = st.realbox.ok();
+        for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+            stag.box_lo[d] = st.realbox.lo(d);
+            stag.box_hi[d] = st.realbox.hi(d);
+        }
+        h_state_tags.push_back(stag);
 
-        // This allows dynamic refinement based on the value of the density
-        if (ref_tags[j].Field() == "density")
-        {
-            MultiFab::Copy(*mf,vars_new[levc][Vars::cons],Rho_comp,0,1,0);
+        need_nbrs |= (st.test  == StateTag::grad);
+        need_vort |= (st.field == StateTag::vorticity);
+    }
+
+    if (!h_state_tags.empty())
+    {
+        MultiFab& cons = vars_new[levc][Vars::cons];
+        const int ncomp = cons.nComp();
+        for (const auto& stag : h_state_tags) {
+            if ( (stag.field == StateTag::qv && ncomp <= RhoQ1_comp) ||
+                 (stag.field == StateTag::qc && ncomp <= RhoQ2_comp) ) {
+                Abort("Refining on qv or qc needs a moisture model");
+            }
+        }
 
-        // This allows dynamic refinement based on the value of qv
-        } else if ( ref_tags[j].Field() == "qv" ) {
-            MultiFab::Copy(  *mf, vars_new[levc][Vars::cons], RhoQ1_comp, 0, 1, 0);
-            MultiFab::Divide(*mf, vars_new[levc][Vars::cons],   Rho_comp, 0, 1, 0);
+        // The differences with the neighbors and the vorticity use the ghost cells inside the domain
+        if (need_nbrs) {
+            cons.FillBoundary(geom[levc].periodicity());
+        }
+        if (need_vort) {
+            vars_new[levc][Vars::xvel].FillBoundary(geom[levc].periodicity());
+            vars_new[levc][Vars::yvel].FillBoundary(geom[levc].periodicity());
+            vars_new[levc][Vars::zvel].FillBoundary(geom[levc].periodicity());
+        }
 
+        const int nstag = h_state_tags.size();
+        Gpu::DeviceVector<StateTagDevice> d_state_tags(nstag);
+        Gpu::copy(Gpu::hostToDevice, h_state_tags.begin(), h_state_tags.end(), d_state_tags.begin());
+        const StateTagDevice* stag_ptr = d_state_tags.data();
 
-        // This allows dynamic refinement based on the value of qc
-        } else if (ref_tags[j].Field() == "qc" ) {
-            MultiFab::Copy(  *mf, vars_new[levc][Vars::cons], RhoQ2_comp, 0, 1, 0);
-            MultiFab::Divide(*mf, vars_new[levc][Vars::cons],   Rho_comp, 0, 1, 0);
+        const bool l_anelastic = (solverChoice.anelastic[levc] == 1);
+        const bool l_moist     = (ncomp > RhoQ1_comp);
+        const char l_tagval    = tagval;
 
+        const Box& domain = geom[levc].Domain();
+        const auto dom_lo = lbound(domain);
+        const auto dom_hi = ubound(domain);
+        const auto is_per = geom[levc].isPeriodicArray();
+        const auto plo    = geom[levc].ProbLoArray();
+        const auto dx     = geom[levc].CellSizeArray();
 
-        // This allows dynamic refinement based on the value of the scalar/pressure/theta
-        } else if ( (ref_tags[j].Field() == "scalar"  ) ||
-                    (ref_tags[j].Field() == "pressure") ||
-                    (ref_tags[j].Field() == "theta"   ) )
+#ifdef _OPENMP
+#pragma omp parallel if (Gpu::notInLaunchRegion())
+#endif
+        for (MFIter mfi(tags,TilingIfNotGPU()); mfi.isValid(); ++mfi)
         {
-            for (MFIter mfi(*mf, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+            const Box& bx = mfi.tilebox();
+            auto const& tag_arr = tags.array(mfi);
+            auto const& S_arr   = cons.const_array(mfi);
+
+            // p_0 is the second component of the base state
+            Array4<Real const> p0_arr = (l_anelastic) ? base_state[levc].const_array(mfi,1) : Array4<Real const>{};
+
+            Array4<Real const> u_arr, v_arr, w_arr;
+            if (need_vort) {
+                u_arr = vars_new[levc][Vars::xvel].const_array(mfi);
+                v_arr = vars_new[levc][Vars::yvel].const_array(mfi);
+                w_arr = vars_new[levc][Vars::zvel].const_array(mfi);
+            }
+
+            ParallelFor(bx, [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
             {
-                const Box& bx = mfi.tilebox();
-                auto& dfab = (*mf)[mfi];
-                auto& sfab = vars_new[levc][Vars::cons][mfi];
-                if (ref_tags[j].Field() == "scalar") {
-                    derived::erf_derscalar(bx, dfab, 0, 1, sfab, Geom(levc), time, nullptr, levc);
-                } else if (ref_tags[j].Field() == "theta") {
-                    derived::erf_dertheta(bx, dfab, 0, 1, sfab, Geom(levc), time, nullptr, levc);
+                auto field_at = [=] (int field, int ii, int jj, int kk) -> Real
+                {
+                    const Real rho = S_arr(ii,jj,kk,Rho_comp);
+                    switch (field) {
+                    case StateTag::density:
+                        return rho;
+                    case StateTag::theta:
+                        return S_arr(ii,jj,kk,RhoTheta_comp) / rho;
+                    case StateTag::pressure:
+                        if (l_anelastic) { return p0_arr(ii,jj,kk); }
+                        return getPgivenRTh(S_arr(ii,jj,kk,RhoTheta_comp),
+                                            (l_moist) ? S_arr(ii,jj,kk,RhoQ1_comp)/rho : 0.0);
+                    case StateTag::scalar:
+                        return S_arr(ii,jj,kk,RhoScalar_comp) / rho;
+                    case StateTag::qv:
+                        return S_arr(ii,jj,kk,RhoQ1_comp) / rho;
+                    default:
+                        return S_arr(ii,jj,kk,RhoQ2_comp) / rho;
+                    }
+                };
+
+                // Neighbors used for differences, one-sided at the non-periodic domain boundaries
+                const int im = (is_per[0] || i > dom_lo.x) ? i-1 : i;
+                const int ip = (is_per[0] || i < dom_hi.x) ? i+1 : i;
+                const int jm = (is_per[1] || j > dom_lo.y) ? j-1 : j;
+                const int jp = (is_per[1] || j < dom_hi.y) ? j+1 : j;
+                const int km = (is_per[2] || k > dom_lo.z) ? k-1 : k;
+                const int kp = (is_per[2] || k < dom_hi.z) ? k+1 : k;
+
+                Real vort = 0.0;
+                if (need_vort) {
+                    auto uc = [=] (int ii, int jj, int kk) { return 0.5*(u_arr(ii,jj,kk) + u_arr(ii+1,jj,kk)); };
+                    auto vc = [=] (int ii, int jj, int kk) { return 0.5*(v_arr(ii,jj,kk) + v_arr(ii,jj+1,kk)); };
+                    auto wc = [=] (int ii, int jj, int kk) { return 0.5*(w_arr(ii,jj,kk) + w_arr(ii,jj,kk+1)); };
+                    const Real dxi = 1.0 / (amrex::max(ip-im,1) * dx[0]);
+                    const Real dyi = 1.0 / (amrex::max(jp-jm,1) * dx[1]);
+                    const Real dzi = 1.0 / (amrex::max(kp-km,1) * dx[2]);
+                    const Real om_x = (wc(i,jp,k) - wc(i,jm,k)) * dyi - (vc(i,j,kp) - vc(i,j,km)) * dzi;
+                    const Real om_y = (uc(i,j,kp) - uc(i,j,km)) * dzi - (wc(ip,j,k) - wc(im,j,k)) * dxi;
+                    const Real om_z = (vc(ip,j,k) - vc(im,j,k)) * dxi - (uc(i,jp,k) - uc(i,jm,k)) * dyi;
+                    vort = std::sqrt(om_x*om_x + om_y*om_y + om_z*om_z);
+                }
+
+                const Real x = plo[0] + (i+0.5)*dx[0];
+                const Real y = plo[1] + (j+0.5)*dx[1];
+                const Real z = plo[2] + (k+0.5)*dx[2];
+
+                for (int n = 0; n < nstag; ++n)
+                {
+                    const StateTagDevice& st = stag_ptr[n];
+                    if (st.use_box && (x < st.box_lo[0] || x > st.box_hi[0] ||
+                                       y < st.box_lo[1] || y > st.box_hi[1] ||
+                                       z < st.box_lo[2] || z > st.box_hi[2])) {
+                        continue;
+                    }
+
+                    bool tag_it;
+                    if (st.test == StateTag::grad) {
+                        const Real f = field_at(st.field,i,j,k);
+                        Real ax = amrex::Math::abs(field_at(st.field,ip,j,k) - f);
+                        ax = amrex::max(ax, amrex::Math::abs(f - field_at(st.field,im,j,k)));
+                        ax = amrex::max(ax, amrex::Math::abs(field_at(st.field,i,jp,k) - f));
+                        ax = amrex::max(ax, amrex::Math::abs(f - field_at(st.field,i,jm,k)));
+                        ax = amrex::max(ax, amrex::Math::abs(field_at(st.field,i,j,kp) - f));
+                        ax = amrex::max(ax, amrex::Math::abs(f - field_at(st.field,i,j,km)));
+                        tag_it = (ax >= st.value);
+                    } else {
+                        const Real f = (st.field == StateTag::vorticity) ? vort : field_at(st.field,i,j,k);
+                        tag_it = (st.test == StateTag::greater) ? (f >= st.value) : (f <= st.value);
+                    }
+
+                    if (tag_it) {
+                        tag_arr(i,j,k) = l_tagval;
+                        break;
+                    }
                 }
-            } // mfi
+            });
+        } // mfi
+    }
+
+    for (int j=0; j < ref_tags.size(); ++j)
+    {
+        // Tags by box need no field; only the criteria below fill one
+        std::unique_ptr<MultiFab> mf;
+
+        // This allows refinement of the rotor-swept columns and wakes of the turbines
+        if (ref_tags[j].Field() == "turbine_wake") {
+#ifdef ERF_USE_WINDFARM
+            if (solverChoice.windfarm_type == WindFarmType::None) {
+                amrex::Abort("Refining on turbine_wake needs a wind farm model");
+            }
+            mf = std::make_unique<MultiFab>(grids[levc], dmap[levc], 1, 0);
+            windfarm->fill_wake_tags(geom[levc], *mf,
+                                     vars_new[levc][Vars::xvel], vars_new[levc][Vars::yvel],
+                                     solverChoice.windfarm_wake_length_by_D,
+                                     solverChoice.windfarm_wake_width_by_D);
+#else
+            amrex::Abort("Refining on turbine_wake needs a build with the wind farm models");
+#endif
+        }
+        else if (!ref_tags[j].Field().empty()) {
 #ifdef ERF_USE_PARTICLES
-        } else {
             //
             // This allows dynamic refinement based on the number of particles per cell
             //
@@ -64,13 +212,18 @@ ERF::ErrorEst (int levc, TagBoxArray& tags, Real time, int /*ngrow*/)
             //      level 0 will not trigger refinement when regridding so level 1 will disappear,
             //      then come back at the next regridding
             //
+            particleData.RedistributeIfNotInPlace();
+
             const auto& particles_namelist( particleData.getNames() );
+            mf = std::make_unique<MultiFab>(grids[levc], dmap[levc], 1, 0);
             mf->setVal(0.0);
+            bool found = false;
             for (ParticlesNamesVector::size_type i = 0; i < particles_namelist.size(); i++)
             {
                 std::string tmp_string(particles_namelist[i]+"_count");
                 IntVect rr = IntVect::TheUnitVector();
                 if (ref_tags[j].Field() == tmp_string) {
+                    found = true;
                     for (int lev = levc; lev <= finest_level; lev++)
                     {
                         MultiFab temp_dat(grids[lev], dmap[lev], 1, 0); temp_dat.setVal(0);
@@ -90,6 +243,11 @@ ERF::ErrorEst (int levc, TagBoxArray& tags, Real time, int /*ngrow*/)
                     }
                 }
             }
+            if (!found) {
+                Abort(std::string("Unknown field_name for refinement: " + ref_tags[j].Field()).c_str());
+            }
+#else
+            Abort(std::string("Unknown field_name for refinement: " + ref_tags[j].Field()).c_str());
 #endif
         }
 
@@ -247,43 +405,63 @@ ERF::refinement_criteria_setup ()
             }
 
             AMRErrorTagInfo info;
+            StateTag state_tag;
 
             if (realbox.ok()) {
                 info.SetRealBox(realbox);
+                state_tag.realbox = realbox;
             }
             if (ppr.countval("start_time") > 0) {
                 Real ref_min_time; ppr.get("start_time",ref_min_time);
                 info.SetMinTime(ref_min_time);
+                state_tag.min_time = ref_min_time;
             }
             if (ppr.countval("end_time") > 0) {
                 Real ref_max_time; ppr.get("end_time",ref_max_time);
                 info.SetMaxTime(ref_max_time);
+                state_tag.max_time = ref_max_time;
             }
             if (ppr.countval("max_level") > 0) {
                 int ref_max_level; ppr.get("max_level",ref_max_level);
                 info.SetMaxLevel(ref_max_level);
+                state_tag.max_level = ref_max_level;
             }
 
-            if (ppr.countval("value_greater")) {
-                int num_val = ppr.countval("value_greater");
+            // Criteria on fields of the state are evaluated together in ErrorEst
+            auto add_tag = [&] (const char* test_name, AMRErrorTag::TEST test, int state_test)
+            {
+                int num_val = ppr.countval(test_name);
                 Vector<Real> value(num_val);
-                ppr.getarr("value_greater",value,0,num_val);
+                ppr.getarr(test_name,value,0,num_val);
                 std::string field; ppr.get("field_name",field);
-                ref_tags.push_back(AMRErrorTag(value,AMRErrorTag::GREATER,field,info));
+
+                state_tag.field = StateTag::field_of(field);
+                if (state_tag.field >= 0) {
+                    if (state_tag.field == StateTag::vorticity && state_test == StateTag::grad) {
+                        Abort("adjacent_difference_greater is not available for vorticity");
+                    }
+                    state_tag.test  = state_test;
+                    state_tag.value = value;
+                    state_tags.push_back(state_tag);
+                } else {
+#ifndef ERF_USE_PARTICLES
+                    // Without particles the only other field is the wind farm wake
+                    if (field != "turbine_wake") {
+                        Abort(std::string("Unknown field_name for " + refinement_indicators[i]).c_str());
+                    }
+#endif
+                    ref_tags.push_back(AMRErrorTag(value,test,field,info));
+                }
+            };
+
+            if (ppr.countval("value_greater")) {
+                add_tag("value_greater", AMRErrorTag::GREATER, StateTag::greater);
             }
             else if (ppr.countval("value_less")) {
-                int num_val = ppr.countval("value_less");
-                Vector<Real> value(num_val);
-                ppr.getarr("value_less",value,0,num_val);
-                std::string field; ppr.get("field_name",field);
-                ref_tags.push_back(AMRErrorTag(value,AMRErrorTag::LESS,field,info));
+                add_tag("value_less", AMRErrorTag::LESS, StateTag::less);
             }
             else if (ppr.countval("adjacent_difference_greater")) {
-                int num_val = ppr.countval("adjacent_difference_greater");
-                Vector<Real> value(num_val);
-                ppr.getarr("adjacent_difference_greater",value,0,num_val);
-                std::string field; ppr.get("field_name",field);
-                ref_tags.push_back(AMRErrorTag(value,AMRErrorTag::GRAD,field,info));
+                add_tag("adjacent_difference_greater", AMRErrorTag::GRAD, StateTag::grad);
             }
             else if (realbox.ok())
             {
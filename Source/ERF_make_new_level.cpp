@@ -11,6 +11,8 @@
 #include <ERF.H>
 #include <AMReX_buildInfo.H>
 #include <ERF_Utils.H>
+#include <ERF_TerrainMetrics.H>
+#include <ERF_ParFunctions.H>
 #include <memory>
 
 #ifdef ERF_USE_MULTIBLOCK
@@ -25,8 +27,12 @@ using namespace amrex;
 // main.cpp --> ERF::InitData --> InitFromScratch --> MakeNewGrids --> MakeNewLevelFromScratch
 //                                       restart  --> MakeNewGrids --> MakeNewLevelFromScratch
 void ERF::MakeNewLevelFromScratch (int lev, Real time, const BoxArray& ba,
-                                   const DistributionMapping& dm)
+                                   const DistributionMapping& dm_in)
 {
+    // Level 0 and the levels read from a checkpoint come distributed by cells; if the problem
+    // gives the cost of the cells they are distributed by it instead
+    DistributionMapping dm = (prob->has_cell_cost()) ? MakeDistributionMap(lev, ba) : dm_in;
+
     // Set BoxArray grids and DistributionMapping dmap in AMReX_AmrMesh.H class
     SetBoxArray(lev, ba);
     SetDistributionMap(lev, dm);
@@ -57,6 +63,20 @@ void ERF::MakeNewLevelFromScratch (int lev, Real time, const BoxArray& ba,
     // *******************************************************************************************
     init_stuff(lev, ba, dm, lev_new, lev_old, base_state[lev], z_phys_nd[lev]);
 
+    //*********************************************************
+    // Turbulent perturbation region initialization
+    // (only made here: a remade level 0 moves the perturbations it holds)
+    //*********************************************************
+    // TODO: Test perturbation on multiple levels
+    if (solverChoice.pert_type == PerturbationType::perturbSource ||
+        solverChoice.pert_type == PerturbationType::perturbDirect)
+    {
+        if (lev == 0) {
+            turbPert.init_tpi(lev, geom[lev].Domain().bigEnd(), geom[lev].CellSizeArray(), ba, dm,
+                              lev_new[Vars::cons].nGrow());
+        }
+    }
+
     //********************************************************************************************
     // Land Surface Model
     // *******************************************************************************************
@@ -250,6 +270,16 @@ void ERF::MakeNewLevelFromScratch (int lev, Real time, const BoxArray& ba,
     if (restart_chkfile.empty()) {
         if (lev == 0) {
             initializeTracers((ParGDBBase*)GetParGDB(),z_phys_nd);
+
+            // Now that level 0 holds its particles it can be distributed on them
+            if (particleData.loadBalance() != "none") {
+                DistributionMapping dm_part = MakeDistributionMap(lev, ba);
+                if (dm_part != dm) {
+                    RemakeLevel(lev, time, ba, dm_part);
+                    SetDistributionMap(lev, dm_part);
+                    particleData.Redistribute();
+                }
+            }
         } else {
             particleData.Redistribute();
         }
@@ -366,19 +396,42 @@ ERF::MakeNewLevelFromCoarse (int lev, Real time, const BoxArray& ba,
 
 // Remake an existing level using provided BoxArray and DistributionMapping and
 // fill with existing fine and coarse data (overrides the pure virtual function in AmrCore)
-// regrid  --> RemakeLevel            (if level already existed)
-// regrid  --> MakeNewLevelFromCoarse (if adding new level)
+// regrid    --> RemakeLevel            (if level already existed)
+// regrid    --> MakeNewLevelFromCoarse (if adding new level)
+// rebalance --> RemakeLevel            (same BoxArray, new DistributionMapping, any level)
+//
+// When neither the BoxArray nor the DistributionMapping has changed, only the structures that
+// also live on the coarser level are rebuilt. When only the DistributionMapping has changed the
+// data of each box, ghost cells included, are moved to their new owners as they are instead of
+// being refilled: nothing is interpolated, and the terrain, base state, time averages, map
+// factors, surface and land surface data, moisture variables, inflow perturbations and MOST
+// fields are kept. This is the only way level 0 is remade. When the BoxArray has changed, the
+// new boxes that are old boxes owned by the same rank get their state, terrain and base state
+// copied as they are, ghost cells included; FillPatch fills the other boxes by copying the old
+// data where they overlap the old boxes and interpolating from the coarser level elsewhere.
+//
 void
 ERF::RemakeLevel (int lev, Real time, const BoxArray& ba, const DistributionMapping& dm)
 {
     // amrex::Print() <<" REMAKING WITH NEW BA AT LEVEL " << lev << " " << ba << std::endl;
 
-    AMREX_ALWAYS_ASSERT(lev > 0);
     AMREX_ALWAYS_ASSERT(solverChoice.terrain_type != TerrainType::Moving);
 
     BoxArray            ba_old(vars_new[lev][Vars::cons].boxArray());
     DistributionMapping dm_old(vars_new[lev][Vars::cons].DistributionMap());
 
+    // Level 0 is only ever redistributed
+    AMREX_ALWAYS_ASSERT(lev > 0 || ba == ba_old);
+
+    // AmrCore also remakes a level whose grids are unchanged when the level below it has been
+    // regridded; its data are then kept as they are
+    if (ba == ba_old && dm == dm_old) {
+        if (lev > 0) {
+            remake_crse_fine_structures(lev);
+        }
+        return;
+    }
+
     // amrex::Print() <<"               OLD BA AT LEVEL " << lev << " " << ba_old << std::endl;
 
     int     ncomp_cons  = vars_new[lev][Vars::cons].nComp();
@@ -387,6 +440,66 @@ ERF::RemakeLevel (int lev, Real time, const BoxArray& ba, const DistributionMapp
     // int ngrow_state = ComputeGhostCells(solverChoice.advChoice, solverChoice.use_NumDiff) + 1;
     int ngrow_vels  = ComputeGhostCells(solverChoice.advChoice, solverChoice.use_NumDiff);
 
+    const bool same_ba = (ba == ba_old);
+
+    // When the grids change, the new boxes that are old boxes owned by the same rank keep
+    // their data (kept_from[i] is the old index of new box i); only the other boxes, made
+    // into ba_fill (fill_from[i] is the index of new box i in it), are filled from the old
+    // grids and the coarser level
+    Vector<int> kept_from(ba.size(), -1);
+    Vector<int> fill_from(ba.size(), -1);
+    BoxArray ba_fill;
+    DistributionMapping dm_fill;
+    bool keep_boxes = false;
+    if (!same_ba) {
+        BoxList bl_fill;
+        Vector<int> pmap_fill;
+        for (int i = 0; i < ba.size(); ++i) {
+            for (const auto& isect : ba_old.intersections(ba[i])) {
+                if (ba_old[isect.first] == ba[i] && dm_old[isect.first] == dm[i]) {
+                    kept_from[i] = isect.first;
+                }
+            }
+            if (kept_from[i] < 0) {
+                fill_from[i] = static_cast<int>(pmap_fill.size());
+                bl_fill.push_back(ba[i]);
+                pmap_fill.push_back(dm[i]);
+            }
+        }
+        keep_boxes = (static_cast<Long>(pmap_fill.size()) < ba.size());
+        if (keep_boxes && !pmap_fill.empty()) {
+            ba_fill = BoxArray(std::move(bl_fill));
+            dm_fill = DistributionMapping(std::move(pmap_fill));
+        }
+    }
+
+    // Time averages are restarted by init_stuff unless they can be moved as they are
+    std::unique_ptr<MultiFab> old_vel_t_avg;
+    Real old_t_avg_cnt = 0.0;
+    if (same_ba && vel_t_avg[lev]) {
+        old_vel_t_avg = std::move(vel_t_avg[lev]);
+        old_t_avg_cnt = t_avg_cnt[lev];
+    }
+
+    // init_stuff also remakes the map factors, the land mask and the radiation fields; when they
+    // can be moved as they are the old objects are kept, so that pointers to them stay valid
+    std::unique_ptr<MultiFab> keep_mapfac_m, keep_mapfac_u, keep_mapfac_v;
+    Vector<std::unique_ptr<iMultiFab>> keep_lmask;
+#if defined(ERF_USE_RRTMGP)
+    std::unique_ptr<MultiFab> keep_qheating, keep_sw_lw_fluxes, keep_solar_zenith;
+#endif
+    if (same_ba) {
+        keep_mapfac_m = std::move(mapfac_m[lev]);
+        keep_mapfac_u = std::move(mapfac_u[lev]);
+        keep_mapfac_v = std::move(mapfac_v[lev]);
+        keep_lmask    = std::move(lmask_lev[lev]);
+#if defined(ERF_USE_RRTMGP)
+        keep_qheating     = std::move(qheating_rates[lev]);
+        keep_sw_lw_fluxes = std::move(sw_lw_fluxes[lev]);
+        keep_solar_zenith = std::move(solar_zenith[lev]);
+#endif
+    }
+
     Vector<MultiFab> temp_lev_new(Vars::NumTypes);
     Vector<MultiFab> temp_lev_old(Vars::NumTypes);
     MultiFab temp_base_state;
@@ -399,16 +512,83 @@ ERF::RemakeLevel (int lev, Real time, const BoxArray& ba, const DistributionMapp
     // *******************************************************************************************
     init_stuff(lev, ba, dm, temp_lev_new, temp_lev_old, temp_base_state, temp_zphys_nd);
 
+    // ********************************************************************************************
+    // Move the data that are not recomputed from the state to their new owners
+    // ********************************************************************************************
+    if (same_ba) {
+        mapfac_m[lev]  = std::move(keep_mapfac_m);
+        mapfac_u[lev]  = std::move(keep_mapfac_u);
+        mapfac_v[lev]  = std::move(keep_mapfac_v);
+        lmask_lev[lev] = std::move(keep_lmask);
+        redistribute_in_place(*mapfac_m[lev], dm);
+        redistribute_in_place(*mapfac_u[lev], dm);
+        redistribute_in_place(*mapfac_v[lev], dm);
+        for (auto& lmask : lmask_lev[lev]) { if (lmask) redistribute_in_place(*lmask, dm); }
+        for (auto& sst   :   sst_lev[lev]) { if (sst)   redistribute_in_place(*sst  , dm); }
+
+        for (auto* mf : lsm_data[lev]) { if (mf) redistribute_in_place(*mf, dm); }
+        for (auto* mf : lsm_flux[lev]) { if (mf) redistribute_in_place(*mf, dm); }
+
+        if (thin_xforce[lev]) redistribute_in_place(*thin_xforce[lev], dm);
+        if (thin_yforce[lev]) redistribute_in_place(*thin_yforce[lev], dm);
+        if (thin_zforce[lev]) redistribute_in_place(*thin_zforce[lev], dm);
+        if (xflux_imask[lev]) redistribute_in_place(*xflux_imask[lev], dm);
+        if (yflux_imask[lev]) redistribute_in_place(*yflux_imask[lev], dm);
+        if (zflux_imask[lev]) redistribute_in_place(*zflux_imask[lev], dm);
+
+        if (lev == 0) {
+            redistribute_in_place(turbPert.pb_cell, dm);
+        }
+
+#ifdef ERF_USE_NETCDF
+        if (lat_m[lev]) redistribute_in_place(*lat_m[lev], dm);
+        if (lon_m[lev]) redistribute_in_place(*lon_m[lev], dm);
+#endif
+#if defined(ERF_USE_RRTMGP)
+        qheating_rates[lev] = std::move(keep_qheating);
+        sw_lw_fluxes[lev]   = std::move(keep_sw_lw_fluxes);
+        solar_zenith[lev]   = std::move(keep_solar_zenith);
+        redistribute_in_place(*qheating_rates[lev], dm);
+        if (sw_lw_fluxes[lev]) redistribute_in_place(*sw_lw_fluxes[lev], dm);
+        if (solar_zenith[lev]) redistribute_in_place(*solar_zenith[lev], dm);
+#endif
+    }
+
     // ********************************************************************************************
     // Build the data structures for terrain-related quantities
     // ********************************************************************************************
-    remake_zphys(lev, temp_zphys_nd);
+    if (same_ba) {
+        if (solverChoice.use_terrain) {
+            temp_zphys_nd->Redistribute(*z_phys_nd[lev], 0, 0, 1, z_phys_nd[lev]->nGrowVect());
+            std::swap(temp_zphys_nd, z_phys_nd[lev]);
+        }
+    } else if (keep_boxes) {
+        if (solverChoice.use_terrain) {
+            copy_boxes(*temp_zphys_nd, *z_phys_nd[lev], kept_from);
+            if (!ba_fill.empty()) {
+                MultiFab fill_zphys(convert(ba_fill, IntVect(1,1,1)), dm_fill, 1, temp_zphys_nd->nGrowVect());
+                InterpFromCoarseLevel(fill_zphys, fill_zphys.nGrowVect(),
+                                      IntVect(0,0,0), // do not fill ghost cells outside the domain
+                                      *z_phys_nd[lev-1], 0, 0, 1,
+                                      geom[lev-1], geom[lev],
+                                      refRatio(lev-1), &node_bilinear_interp,
+                                      domain_bcs_type, BCVars::cons_bc);
+                init_terrain_grid(lev,geom[lev],fill_zphys,zlevels_stag[lev],phys_bc_type);
+                copy_boxes(*temp_zphys_nd, fill_zphys, fill_from);
+            }
+            temp_zphys_nd->FillBoundary(geom[lev].periodicity());
+            std::swap(temp_zphys_nd, z_phys_nd[lev]);
+        }
+    } else {
+        remake_zphys(lev, temp_zphys_nd);
+    }
     update_terrain_arrays(lev);
 
     //
     // Make sure that detJ and z_phys_cc are the average of the data on a finer level if there is one
+    // (they are unchanged if the grids are)
     //
-    if (solverChoice.use_terrain != 0) {
+    if (solverChoice.use_terrain != 0 && !same_ba) {
         for (int crse_lev = lev-1; crse_lev >= 0; crse_lev--) {
             average_down(  *detJ_cc[crse_lev+1],   *detJ_cc[crse_lev], 0, 1, refRatio(crse_lev));
             average_down(*z_phys_cc[crse_lev+1], *z_phys_cc[crse_lev], 0, 1, refRatio(crse_lev));
@@ -423,16 +603,49 @@ ERF::RemakeLevel (int lev, Real time, const BoxArray& ba, const DistributionMapp
     // ********************************************************************************************
     // This will fill the temporary MultiFabs with data from vars_new
     // ********************************************************************************************
-    FillPatch(lev, time, {&temp_lev_new[Vars::cons],&temp_lev_new[Vars::xvel],
-                          &temp_lev_new[Vars::yvel],&temp_lev_new[Vars::zvel]},
-                         {&temp_lev_new[Vars::cons],&rU_new[lev],&rV_new[lev],&rW_new[lev]},
-                          false);
+    if (same_ba) {
+        for (int var_idx = 0; var_idx < Vars::NumTypes; ++var_idx) {
+            const MultiFab& src = vars_new[lev][var_idx];
+            temp_lev_new[var_idx].Redistribute(src, 0, 0, src.nComp(), src.nGrowVect());
+        }
+    } else if (keep_boxes) {
+        for (int var_idx = 0; var_idx < Vars::NumTypes; ++var_idx) {
+            copy_boxes(temp_lev_new[var_idx], vars_new[lev][var_idx], kept_from);
+        }
+        if (!ba_fill.empty()) {
+            Vector<MultiFab> fill_new(Vars::NumTypes);
+            for (int var_idx = 0; var_idx < Vars::NumTypes; ++var_idx) {
+                const MultiFab& dst = temp_lev_new[var_idx];
+                fill_new[var_idx].define(convert(ba_fill, dst.ixType()), dm_fill, dst.nComp(), dst.nGrowVect());
+            }
+            FillPatch(lev, time, {&fill_new[Vars::cons],&fill_new[Vars::xvel],
+                                  &fill_new[Vars::yvel],&fill_new[Vars::zvel]},
+                                 {&fill_new[Vars::cons],&rU_new[lev],&rV_new[lev],&rW_new[lev]},
+                                  false);
+            for (int var_idx = 0; var_idx < Vars::NumTypes; ++var_idx) {
+                copy_boxes(temp_lev_new[var_idx], fill_new[var_idx], fill_from);
+            }
+        }
+    } else {
+        FillPatch(lev, time, {&temp_lev_new[Vars::cons],&temp_lev_new[Vars::xvel],
+                              &temp_lev_new[Vars::yvel],&temp_lev_new[Vars::zvel]},
+                             {&temp_lev_new[Vars::cons],&rU_new[lev],&rV_new[lev],&rW_new[lev]},
+                              false);
+    }
 
     // ********************************************************************************************
     // Update the base state at this level by interpolation from coarser level AND copy
     //    from previous (pre-regrid) base_state array
     // ********************************************************************************************
-    if (lev > 0) {
+    if (same_ba) {
+        temp_base_state.Redistribute(base_state[lev], 0, 0, 3, base_state[lev].nGrowVect());
+        std::swap(temp_base_state, base_state[lev]);
+
+        if (old_vel_t_avg) {
+            vel_t_avg[lev]->Redistribute(*old_vel_t_avg, 0, 0, 4, IntVect(0));
+            t_avg_cnt[lev] = old_t_avg_cnt;
+        }
+    } else if (lev > 0) {
         // Interp all three components: rho, p, pi
         int  icomp = 0; int bccomp = 0; int  ncomp = 3;
 
@@ -443,11 +656,24 @@ ERF::RemakeLevel (int lev, Real time, const BoxArray& ba, const DistributionMapp
         Vector<MultiFab*> cmf = {&base_state[lev-1], &base_state[lev-1]};
         Vector<Real> ftime    = {time, time};
         Vector<Real> ctime    = {time, time};
-        FillPatchTwoLevels(temp_base_state, time,
-                           cmf, ctime, fmf, ftime,
-                           icomp, icomp, ncomp, geom[lev-1], geom[lev],
-                           null_bc, 0, null_bc, 0, refRatio(lev-1),
-                           mapper, domain_bcs_type, bccomp);
+        auto fill_base_state = [&] (MultiFab& mf)
+        {
+            FillPatchTwoLevels(mf, time,
+                               cmf, ctime, fmf, ftime,
+                               icomp, icomp, ncomp, geom[lev-1], geom[lev],
+                               null_bc, 0, null_bc, 0, refRatio(lev-1),
+                               mapper, domain_bcs_type, bccomp);
+        };
+        if (keep_boxes) {
+            copy_boxes(temp_base_state, base_state[lev], kept_from);
+            if (!ba_fill.empty()) {
+                MultiFab fill_base(ba_fill, dm_fill, ncomp, temp_base_state.nGrowVect());
+                fill_base_state(fill_base);
+                copy_boxes(temp_base_state, fill_base, fill_from);
+            }
+        } else {
+            fill_base_state(temp_base_state);
+        }
         std::swap(temp_base_state, base_state[lev]);
     }
 
@@ -478,6 +704,16 @@ ERF::RemakeLevel (int lev, Real time, const BoxArray& ba, const DistributionMapp
     //********************************************************************************************
     // Microphysics
     // *******************************************************************************************
+    // The moisture variables, which include the accumulated precipitation, are moved as they are
+    // if the grids are unchanged
+    Vector<MultiFab> old_qmoist;
+    if (same_ba) {
+        old_qmoist.resize(qmoist[lev].size());
+        for (int mvar(0); mvar<qmoist[lev].size(); ++mvar) {
+            if (qmoist[lev][mvar]) { old_qmoist[mvar] = std::move(*qmoist[lev][mvar]); }
+        }
+    }
+
     int q_size = micro->Get_Qmoist_Size(lev);
     qmoist[lev].resize(q_size);
     micro->Define(lev, solverChoice);
@@ -491,6 +727,21 @@ ERF::RemakeLevel (int lev, Real time, const BoxArray& ba, const DistributionMapp
         qmoist[lev][mvar] = micro->Get_Qmoist_Ptr(lev,mvar);
     }
 
+    for (int mvar(0); mvar<old_qmoist.size() && mvar<qmoist[lev].size(); ++mvar) {
+        if (old_qmoist[mvar].ok() && qmoist[lev][mvar]) {
+            qmoist[lev][mvar]->Redistribute(old_qmoist[mvar], 0, 0, old_qmoist[mvar].nComp(),
+                                            old_qmoist[mvar].nGrowVect());
+        }
+    }
+
+    // ********************************************************************************************
+    // MOST keeps its surface fields and pointers to the level data
+    // ********************************************************************************************
+    if (same_ba && m_most) {
+        m_most->redistribute_level(lev, dm, z_phys_nd, Hwave, Lwave, eddyDiffs_lev);
+        m_most->update_mac_ptrs(lev, vars_old, Theta_prim, Qv_prim, Qr_prim);
+    }
+
     // ********************************************************************************************
     // Initialize the integrator class
     // ********************************************************************************************
@@ -510,6 +761,204 @@ ERF::RemakeLevel (int lev, Real time, const BoxArray& ba, const DistributionMapp
 #endif
 }
 
+//
+// Distribution of a new BoxArray (overrides the virtual function in AmrMesh)
+// regrid    --> MakeDistributionMap --> RemakeLevel (if level already existed)
+// rebalance --> MakeDistributionMap --> RemakeLevel
+// MakeNewLevelFromScratch --> MakeDistributionMap
+//
+// The cost of a cell of the level is one, or the cost the problem gives in init_cell_cost
+// if has_cell_cost is true. Without any of these costs the map by cells is returned as is.
+// With erf.load_balance_cost = timers the cost of the cells of the old grids is the time
+// measured on their box since the last distribution divided by the cells of the box and scaled
+// to a mean of one. With particles.load_balance set, particles.load_balance_particle_cost times
+// the number of particles in the cell is added. The cost of a box of the new BoxArray is the
+// sum over its cells, and the map with the smaller imbalance of the one built from these costs
+// and the one by cells is returned. New levels hold no measurements or particles yet, so only
+// the problem's cost can distribute them otherwise than by cells.
+//
+DistributionMapping
+ERF::MakeDistributionMap (int lev, BoxArray const& ba)
+{
+    DistributionMapping dm_cells = AmrCore::MakeDistributionMap(lev, ba);
+
+    const bool new_level = (lev > finest_level || grids[lev].empty());
+
+    const bool use_user = prob->has_cell_cost();
+
+    // Time on each box of the old grids
+    Real total_time = 0.0;
+    LayoutData<Real>* times = (new_level) ? nullptr : getBoxCost(lev);
+    if (times) {
+        for (MFIter mfi(*times); mfi.isValid(); ++mfi) {
+            total_time += (*times)[mfi];
+        }
+        ParallelDescriptor::ReduceRealSum(total_time);
+    }
+    const bool use_times = (total_time > 0.0);
+
+    std::string strategy = load_balance_strategy;
+    bool use_particles = false;
+#ifdef ERF_USE_PARTICLES
+    use_particles = (!new_level && particleData.loadBalance() != "none" && !particleData.isEmpty());
+    if (use_particles && !use_times) {
+        strategy = particleData.loadBalance();
+    }
+#endif
+
+    if (!use_times && !use_particles && !use_user) {
+        return dm_cells;
+    }
+
+    BL_PROFILE("ERF::MakeDistributionMap()");
+
+    // Cost the problem gives to each cell of the new grids, if any
+    MultiFab cost_new(ba, dm_cells, 1, 0);
+    cost_new.setVal(1.0);
+    if (use_user) {
+        prob->init_cell_cost(cost_new, geom[lev]);
+    }
+
+    // Cost of each cell of the old grids
+    if (use_times || use_particles) {
+        MultiFab cost_old(grids[lev], dmap[lev], 1, 0);
+        cost_old.setVal(1.0);
+        if (use_user) {
+            prob->init_cell_cost(cost_old, geom[lev]);
+        }
+        if (use_times) {
+            const Real cells_per_time = static_cast<Real>(grids[lev].numPts()) / total_time;
+            for (MFIter mfi(cost_old); mfi.isValid(); ++mfi) {
+                const Box& vbx = mfi.validbox();
+                cost_old[mfi].setVal<RunOn::Device>((*times)[mfi] * cells_per_time / static_cast<Real>(vbx.numPts()), vbx, 0, 1);
+            }
+        }
+#ifdef ERF_USE_PARTICLES
+        if (use_particles) {
+            MultiFab count(grids[lev], dmap[lev], 1, 0);
+            count.setVal(0.0);
+            particleData.CountParticles(count, lev);
+            MultiFab::Saxpy(cost_old, particleData.particleCost(), count, 0, 0, 1, 0);
+        }
+#endif
+        cost_new.ParallelCopy(cost_old, 0, 0, 1);
+    }
+
+    const int nboxes = ba.size();
+    Vector<Real> cost(nboxes, 0.0);
+    for (MFIter mfi(cost_new); mfi.isValid(); ++mfi) {
+        cost[mfi.index()] = cost_new[mfi].sum<RunOn::Device>(mfi.validbox(), 0);
+    }
+    ParallelDescriptor::ReduceRealSum(cost.data(), nboxes);
+
+    DistributionMapping dm_cost = (strategy == "sfc") ? DistributionMapping::makeSFC(cost, ba)
+                                                      : DistributionMapping::makeKnapSack(cost);
+
+    // Largest over mean cost per rank
+    auto imbalance = [&] (const DistributionMapping& dm)
+    {
+        const int nprocs = ParallelDescriptor::NProcs();
+        Vector<Real> rank_cost(nprocs, 0.0);
+        for (int i = 0; i < nboxes; ++i) {
+            rank_cost[dm[i]] += cost[i];
+        }
+        Real max_cost = 0.0, sum_cost = 0.0;
+        for (int p = 0; p < nprocs; ++p) {
+            max_cost = std::max(max_cost, rank_cost[p]);
+            sum_cost += rank_cost[p];
+        }
+        return (sum_cost > 0.0) ? max_cost * nprocs / sum_cost : 1.0;
+    };
+
+    const Real imb_cells = imbalance(dm_cells);
+    const Real imb_cost  = imbalance(dm_cost);
+
+    if (load_balance_verbose > 0) {
+        std::string what = (use_times) ? "measured costs" : ((use_user) ? "problem costs" : "cells");
+        Print() << "Level " << lev << " load imbalance (max/mean cost per rank): "
+                << imb_cells << " distributed by cells, " << imb_cost << " by "
+                << what << (use_particles ? " and particles" : "")
+                << " (" << strategy << ")\n";
+    }
+
+    // Measure afresh for the next distribution
+    if (times) {
+        for (MFIter mfi(*times); mfi.isValid(); ++mfi) {
+            (*times)[mfi] = 0.0;
+        }
+    }
+
+    return (imb_cost < imb_cells) ? dm_cost : dm_cells;
+}
+
+//
+// Time spent on each box of a level, kept on the current grids of the level; it is
+// reset when they change. Returns nullptr unless erf.load_balance_cost = timers.
+//
+LayoutData<Real>*
+ERF::getBoxCost (int lev)
+{
+    if (load_balance_cost != "timers") {
+        return nullptr;
+    }
+    if (box_cost.size() <= lev) {
+        box_cost.resize(lev+1);
+    }
+    auto& bc = box_cost[lev];
+    if (!bc || bc->boxArray() != grids[lev] || bc->DistributionMap() != dmap[lev]) {
+        bc = std::make_unique<LayoutData<Real>>(grids[lev], dmap[lev]);
+        for (MFIter mfi(*bc); mfi.isValid(); ++mfi) {
+            (*bc)[mfi] = 0.0;
+        }
+    }
+    return bc.get();
+}
+
+//
+// Rebuild the FillPatchers and the flux register of a level whose own grids are unchanged
+// after the level below it has been remade
+//
+void
+ERF::remake_crse_fine_structures (int lev)
+{
+    AMREX_ALWAYS_ASSERT(lev > 0);
+
+    if (cf_width >= 0) {
+        Define_ERFFillPatchers(lev);
+    }
+    if (solverChoice.coupling_type == CouplingType::TwoWay) {
+        int ncomp_reflux = vars_new[0][Vars::cons].nComp();
+        delete advflux_reg[lev];
+        advflux_reg[lev] = new YAFluxRegister(grids[lev], grids[lev-1],
+                                              dmap[lev] ,  dmap[lev-1],
+                                              geom[lev],  geom[lev-1],
+                                              ref_ratio[lev-1], lev, ncomp_reflux);
+    }
+}
+
+//
+// Redistribute all levels, level 0 included, on their costs without regridding
+// timeStep --> rebalance --> MakeDistributionMap --> RemakeLevel
+//
+void
+ERF::rebalance (Real time)
+{
+    BL_PROFILE("ERF::rebalance()");
+
+    bool crse_moved = false;
+    for (int lev = 0; lev <= finest_level; ++lev) {
+        DistributionMapping dm = MakeDistributionMap(lev, grids[lev]);
+        const bool moved = (dm != dmap[lev]);
+        if (moved) {
+            RemakeLevel(lev, time, grids[lev], dm);
+            SetDistributionMap(lev, dm);
+        } else if (crse_moved) {
+            remake_crse_fine_structures(lev);
+        }
+        crse_moved = moved;
+    }
+}
+
 //
 // Delete level data (overrides the pure virtual function in AmrCore)
 //
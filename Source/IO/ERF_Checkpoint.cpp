@@ -1,8 +1,10 @@
 #include <ERF.H>
 #include "AMReX_PlotFileUtil.H"
+#include "AMReX_AsyncOut.H"
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 
 using namespace amrex;
 
@@ -16,6 +18,116 @@ ERF::GotoNextLine (std::istream& is)
     is.ignore(bl_ignore_max, '\n');
 }
 
+/**
+ * Utility to read a MultiFab of a checkpoint into dst, whose grids and distribution mapping
+ * may differ from those the checkpoint was written with, and whose resolution may be finer
+ * by ratio. Each FAB in the file is read by the rank that owns most of its overlap with dst,
+ * so that most of the data is read where it is needed; the rest is moved by a ParallelCopy.
+ * If ratio is not one the data is interpolated linearly from the checkpoint, holding it
+ * constant beyond the checkpoint data in non-periodic directions.
+ *
+ * @param dst MultiFab to fill
+ * @param name Name of the MultiFab in the checkpoint
+ * @param ng Number of ghost cells of dst to fill
+ * @param geom Geometry of dst
+ * @param ratio Refinement of dst relative to the checkpoint
+ */
+void
+read_restart_mf (MultiFab& dst, const std::string& name, const IntVect& ng,
+                 const Geometry& geom, const IntVect& ratio)
+{
+    BL_PROFILE("ERF::read_restart_mf()");
+
+    Vector<char> hdr_chars;
+    ParallelDescriptor::ReadAndBcastFile(name + "_H", hdr_chars);
+    std::istringstream hdr_is(std::string(hdr_chars.dataPtr()), std::istringstream::in);
+    VisMF::Header hdr;
+    hdr_is >> hdr;
+
+    const BoxArray& src_ba = hdr.m_ba;
+    const int ncomp        = dst.nComp();
+    AMREX_ALWAYS_ASSERT(hdr.m_ncomp >= ncomp);
+
+    const bool interp = (ratio != IntVect(1));
+
+    BoxArray target_ba = dst.boxArray();
+    if (interp) {
+        target_ba.coarsen(ratio);
+    }
+
+    Vector<int> pmap(src_ba.size());
+    for (int i = 0; i < src_ba.size(); ++i) {
+        Long max_pts = 0;
+        pmap[i] = i % ParallelDescriptor::NProcs();
+        for (const auto& is : target_ba.intersections(src_ba[i])) {
+            if (is.second.numPts() > max_pts) {
+                max_pts = is.second.numPts();
+                pmap[i] = dst.DistributionMap()[is.first];
+            }
+        }
+    }
+
+    MultiFab src(src_ba, DistributionMapping(pmap), hdr.m_ncomp, hdr.m_ngrow);
+    VisMF::Read(src, name);
+
+    if (!interp) {
+        dst.ParallelCopy(src, 0, 0, ncomp, hdr.m_ngrow, ng, geom.periodicity());
+        return;
+    }
+
+    // Periodicity of the checkpoint domain
+    IntVect period(0);
+    for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+        if (geom.isPeriodic(d)) period[d] = geom.Domain().length(d) / ratio[d];
+    }
+
+    const IntVect ng_crse = (ng + ratio - 1) / ratio + 1;
+    MultiFab crse(target_ba, dst.DistributionMap(), ncomp, ng_crse);
+    crse.setVal(0.0);
+    crse.ParallelCopy(src, 0, 0, ncomp, hdr.m_ngrow, ng_crse, Periodicity(period));
+
+    const Box src_box = src_ba.minimalBox();
+    const IntVect lo = src_box.smallEnd();
+    const IntVect hi = src_box.bigEnd();
+    const IntVect nodal = dst.ixType().toIntVect();
+    const GpuArray<int,AMREX_SPACEDIM> periodic = {AMREX_D_DECL(geom.isPeriodic(0),
+                                                                geom.isPeriodic(1),
+                                                                geom.isPeriodic(2))};
+
+    for (MFIter mfi(dst, TilingIfNotGPU()); mfi.isValid(); ++mfi)
+    {
+        const Box bx = mfi.growntilebox(ng);
+        auto const& c = crse.const_array(mfi);
+        auto const& f = dst.array(mfi);
+        ParallelFor(bx, ncomp, [=] AMREX_GPU_DEVICE (int i, int j, int k, int n) noexcept
+        {
+            const int idx[3] = {i, j, k};
+            int c0[3], c1[3];
+            Real w[3];
+            for (int d = 0; d < 3; ++d) {
+                const Real xc = (nodal[d]) ? Real(idx[d]) / ratio[d]
+                                           : (Real(idx[d]) + Real(0.5)) / ratio[d] - Real(0.5);
+                const int ic = static_cast<int>(amrex::Math::floor(xc));
+                w[d]  = xc - ic;
+                c0[d] = ic;
+                c1[d] = ic + 1;
+                if (!periodic[d]) {
+                    c0[d] = amrex::max(lo[d], amrex::min(c0[d], hi[d]));
+                    c1[d] = amrex::max(lo[d], amrex::min(c1[d], hi[d]));
+                }
+            }
+            f(i,j,k,n) = (1.-w[0])*(1.-w[1])*(1.-w[2]) * c(c0[0],c0[1],c0[2],n)
+                       +     w[0] *(1.-w[1])*(1.-w[2]) * c(c1[0],c0[1],c0[2],n)
+                       + (1.-w[0])*    w[1] *(1.-w[2]) * c(c0[0],c1[1],c0[2],n)
+                       +     w[0] *    w[1] *(1.-w[2]) * c(c1[0],c1[1],c0[2],n)
+                       + (1.-w[0])*(1.-w[1])*    w[2]  * c(c0[0],c0[1],c1[2],n)
+                       +     w[0] *(1.-w[1])*    w[2]  * c(c1[0],c0[1],c1[2],n)
+                       + (1.-w[0])*    w[1] *    w[2]  * c(c0[0],c1[1],c1[2],n)
+                       +     w[0] *    w[1] *    w[2]  * c(c1[0],c1[1],c1[2],n);
+        });
+    }
+}
+
 /**
  * ERF function for writing a checkpoint file.
  */
@@ -32,6 +144,21 @@ ERF::WriteCheckpointFile () const
     // checkpoint file name, e.g., chk00010
     const std::string& checkpointname = Concatenate(check_file,istep[0],5);
 
+    // If async output is enabled, each MultiFab below is a staging copy of the
+    // solution that is handed off to the AsyncOut background thread, so we return
+    // to the time loop as soon as the copies are made. Make sure any previous
+    // checkpoint has been fully drained before we start on this one.
+    const bool use_async = AsyncOut::UseAsyncOut();
+    if (use_async) {
+        BL_PROFILE("ERF::WriteCheckpointFile::wait");
+        AsyncOut::Finish();
+    }
+
+    // Boundary planes buffered for aggregated output must be on disk before a restart could need them
+    if (m_w2d) {
+        m_w2d->flush();
+    }
+
     Print() << "Writing native checkpoint " << checkpointname << "\n";
 
     const int nlevels = finest_level+1;
@@ -46,19 +173,20 @@ ERF::WriteCheckpointFile () const
 
     int ncomp_cons = vars_new[0][Vars::cons].nComp();
 
-    // write Header file
-    if (ParallelDescriptor::IOProcessor()) {
+    // Either write the MultiFab now or hand it (and ownership of its data) to the async writer
+    auto write_mf = [use_async] (MultiFab&& mf, const std::string& name)
+    {
+        if (use_async) {
+            VisMF::AsyncWrite(std::move(mf), name);
+        } else {
+            VisMF::Write(mf, name);
+        }
+    };
 
-       std::string HeaderFileName(checkpointname + "/Header");
-       VisMF::IO_Buffer io_buffer(VisMF::IO_Buffer_Size);
-       std::ofstream HeaderFile;
-       HeaderFile.rdbuf()->pubsetbuf(io_buffer.dataPtr(), io_buffer.size());
-       HeaderFile.open(HeaderFileName.c_str(), std::ofstream::out   |
-                                               std::ofstream::trunc |
-                                               std::ofstream::binary);
-       if( ! HeaderFile.good()) {
-           FileOpenFailed(HeaderFileName);
-       }
+    // Build the Header file contents; these are written out after the MultiFab data
+    // has been submitted so that a complete Header marks a complete checkpoint
+    std::ostringstream HeaderFile;
+    if (ParallelDescriptor::IOProcessor()) {
 
        HeaderFile.precision(17);
 
@@ -112,34 +240,38 @@ ERF::WriteCheckpointFile () const
     // Here we make copies of the MultiFab with no ghost cells
     for (int lev = 0; lev <= finest_level; ++lev)
     {
+        if (solverChoice.moisture_type != MoistureType::None) {
+            micro->Update_Qmoist_Lev(lev, vars_new[lev][Vars::cons]);
+        }
+
         MultiFab cons(grids[lev],dmap[lev],ncomp_cons,0);
         MultiFab::Copy(cons,vars_new[lev][Vars::cons],0,0,ncomp_cons,0);
-        VisMF::Write(cons, MultiFabFileFullPrefix(lev, checkpointname, "Level_", "Cell"));
+        write_mf(std::move(cons), MultiFabFileFullPrefix(lev, checkpointname, "Level_", "Cell"));
 
         MultiFab xvel(convert(grids[lev],IntVect(1,0,0)),dmap[lev],1,0);
         MultiFab::Copy(xvel,vars_new[lev][Vars::xvel],0,0,1,0);
-        VisMF::Write(xvel, MultiFabFileFullPrefix(lev, checkpointname, "Level_", "XFace"));
+        write_mf(std::move(xvel), MultiFabFileFullPrefix(lev, checkpointname, "Level_", "XFace"));
 
         MultiFab yvel(convert(grids[lev],IntVect(0,1,0)),dmap[lev],1,0);
         MultiFab::Copy(yvel,vars_new[lev][Vars::yvel],0,0,1,0);
-        VisMF::Write(yvel, MultiFabFileFullPrefix(lev, checkpointname, "Level_", "YFace"));
+        write_mf(std::move(yvel), MultiFabFileFullPrefix(lev, checkpointname, "Level_", "YFace"));
 
         MultiFab zvel(convert(grids[lev],IntVect(0,0,1)),dmap[lev],1,0);
         MultiFab::Copy(zvel,vars_new[lev][Vars::zvel],0,0,1,0);
-        VisMF::Write(zvel, MultiFabFileFullPrefix(lev, checkpointname, "Level_", "ZFace"));
+        write_mf(std::move(zvel), MultiFabFileFullPrefix(lev, checkpointname, "Level_", "ZFace"));
 
         // Note that we write the ghost cells of the base state (unlike above)
         IntVect ng = base_state[lev].nGrowVect();
         MultiFab base(grids[lev],dmap[lev],base_state[lev].nComp(),ng);
         MultiFab::Copy(base,base_state[lev],0,0,base.nComp(),ng);
-        VisMF::Write(base, MultiFabFileFullPrefix(lev, checkpointname, "Level_", "BaseState"));
+        write_mf(std::move(base), MultiFabFileFullPrefix(lev, checkpointname, "Level_", "BaseState"));
 
         if (solverChoice.use_terrain)  {
             // Note that we also write the ghost cells of z_phys_nd
             ng = z_phys_nd[lev]->nGrowVect();
             MultiFab z_height(convert(grids[lev],IntVect(1,1,1)),dmap[lev],1,ng);
             MultiFab::Copy(z_height,*z_phys_nd[lev],0,0,1,ng);
-            VisMF::Write(z_height, MultiFabFileFullPrefix(lev, checkpointname, "Level_", "Z_Phys_nd"));
+            write_mf(std::move(z_height), MultiFabFileFullPrefix(lev, checkpointname, "Level_", "Z_Phys_nd"));
         }
 
          // We must read and write qmoist with ghost cells because we don't directly impose BCs on these vars
@@ -149,7 +281,7 @@ ERF::WriteCheckpointFile () const
             int nvar = 1;
             MultiFab moist_vars(grids[lev],dmap[lev],nvar,ng);
             MultiFab::Copy(moist_vars,*(qmoist[lev][4]),0,0,nvar,ng);
-            VisMF::Write(moist_vars, amrex::MultiFabFileFullPrefix(lev, checkpointname, "Level_", "RainAccum"));
+            write_mf(std::move(moist_vars), amrex::MultiFabFileFullPrefix(lev, checkpointname, "Level_", "RainAccum"));
         }
 
         if(solverChoice.moisture_type == MoistureType::SAM){
@@ -157,17 +289,17 @@ ERF::WriteCheckpointFile () const
             int nvar = 1;
             MultiFab rain_accum(grids[lev],dmap[lev],nvar,ng);
             MultiFab::Copy(rain_accum,*(qmoist[lev][8]),0,0,nvar,ng);
-            VisMF::Write(rain_accum, amrex::MultiFabFileFullPrefix(lev, checkpointname, "Level_", "RainAccum"));
+            write_mf(std::move(rain_accum), amrex::MultiFabFileFullPrefix(lev, checkpointname, "Level_", "RainAccum"));
 
             ng = qmoist[lev][9]->nGrowVect();
             MultiFab snow_accum(grids[lev],dmap[lev],nvar,ng);
             MultiFab::Copy(snow_accum,*(qmoist[lev][9]),0,0,nvar,ng);
-            VisMF::Write(snow_accum, amrex::MultiFabFileFullPrefix(lev, checkpointname, "Level_", "SnowAccum"));
+            write_mf(std::move(snow_accum), amrex::MultiFabFileFullPrefix(lev, checkpointname, "Level_", "SnowAccum"));
 
             ng = qmoist[lev][10]->nGrowVect();
             MultiFab graup_accum(grids[lev],dmap[lev],nvar,ng);
             MultiFab::Copy(graup_accum,*(qmoist[lev][10]),0,0,nvar,ng);
-            VisMF::Write(graup_accum, amrex::MultiFabFileFullPrefix(lev, checkpointname, "Level_", "GraupAccum"));
+            write_mf(std::move(graup_accum), amrex::MultiFabFileFullPrefix(lev, checkpointname, "Level_", "GraupAccum"));
         }
 
 
@@ -178,7 +310,7 @@ ERF::WriteCheckpointFile () const
             ng = Nturb[lev].nGrowVect();
             MultiFab mf_Nturb(grids[lev],dmap[lev],1,ng);
             MultiFab::Copy(mf_Nturb,Nturb[lev],0,0,1,ng);
-            VisMF::Write(mf_Nturb, amrex::MultiFabFileFullPrefix(lev, checkpointname, "Level_", "NumTurb"));
+            write_mf(std::move(mf_Nturb), amrex::MultiFabFileFullPrefix(lev, checkpointname, "Level_", "NumTurb"));
         }
 #endif
 
@@ -191,7 +323,7 @@ ERF::WriteCheckpointFile () const
                 int nvar = lsm_data[lev][mvar]->nComp();
                 MultiFab lsm_vars(ba,dm,nvar,ng);
                 MultiFab::Copy(lsm_vars,*(lsm_data[lev][mvar]),0,0,nvar,ng);
-                VisMF::Write(lsm_vars, MultiFabFileFullPrefix(lev, checkpointname, "Level_", "LsmVars"));
+                write_mf(std::move(lsm_vars), MultiFabFileFullPrefix(lev, checkpointname, "Level_", "LsmVars"));
             }
         }
 
@@ -205,17 +337,17 @@ ERF::WriteCheckpointFile () const
         ng = mapfac_m[lev]->nGrowVect();
         MultiFab mf_m(ba2d,dmap[lev],1,ng);
         MultiFab::Copy(mf_m,*mapfac_m[lev],0,0,1,ng);
-        VisMF::Write(mf_m, MultiFabFileFullPrefix(lev, checkpointname, "Level_", "MapFactor_m"));
+        write_mf(std::move(mf_m), MultiFabFileFullPrefix(lev, checkpointname, "Level_", "MapFactor_m"));
 
         ng = mapfac_u[lev]->nGrowVect();
         MultiFab mf_u(convert(ba2d,IntVect(1,0,0)),dmap[lev],1,ng);
         MultiFab::Copy(mf_u,*mapfac_u[lev],0,0,1,ng);
-        VisMF::Write(mf_u, MultiFabFileFullPrefix(lev, checkpointname, "Level_", "MapFactor_u"));
+        write_mf(std::move(mf_u), MultiFabFileFullPrefix(lev, checkpointname, "Level_", "MapFactor_u"));
 
         ng = mapfac_v[lev]->nGrowVect();
         MultiFab mf_v(convert(ba2d,IntVect(0,1,0)),dmap[lev],1,ng);
         MultiFab::Copy(mf_v,*mapfac_v[lev],0,0,1,ng);
-        VisMF::Write(mf_v, MultiFabFileFullPrefix(lev, checkpointname, "Level_", "MapFactor_v"));
+        write_mf(std::move(mf_v), MultiFabFileFullPrefix(lev, checkpointname, "Level_", "MapFactor_v"));
 
         if (m_most && m_most->have_variable_sea_roughness())  {
             amrex::Print() << "Writing variable surface roughness" << std::endl;
@@ -225,21 +357,47 @@ ERF::WriteCheckpointFile () const
                 const Box& bx = mfi.growntilebox();
                 z0[mfi].copy<RunOn::Host>(*(m_most->get_z0(lev)), bx);
             }
-            VisMF::Write(z0, MultiFabFileFullPrefix(lev, checkpointname, "Level_", "Z0"));
+            write_mf(std::move(z0), MultiFabFileFullPrefix(lev, checkpointname, "Level_", "Z0"));
         }
     }
 
 #ifdef ERF_USE_PARTICLES
-   particleData.Checkpoint(checkpointname);
+    // With async output the particle containers copy their data and hand the writing to
+    // AsyncOut themselves, so this is queued ahead of the Header like the MultiFabs
+    particleData.Checkpoint(checkpointname);
 #endif
 
+    // Now write the Header
+    if (ParallelDescriptor::IOProcessor()) {
+        auto write_header = [hdr = HeaderFile.str(), checkpointname] ()
+        {
+            std::string HeaderFileName(checkpointname + "/Header");
+            VisMF::IO_Buffer io_buffer(VisMF::IO_Buffer_Size);
+            std::ofstream HeaderOut;
+            HeaderOut.rdbuf()->pubsetbuf(io_buffer.dataPtr(), io_buffer.size());
+            HeaderOut.open(HeaderFileName.c_str(), std::ofstream::out   |
+                                                   std::ofstream::trunc |
+                                                   std::ofstream::binary);
+            if( ! HeaderOut.good()) {
+                FileOpenFailed(HeaderFileName);
+            }
+            HeaderOut << hdr;
+        };
+
+        if (use_async) {
+            AsyncOut::Submit(std::move(write_header));
+        } else {
+            write_header();
+        }
+    }
+
 #ifdef ERF_USE_NETCDF
    // Write bdy_data files
    if (ParallelDescriptor::IOProcessor() && ((init_type=="real") || (init_type=="metgrid"))) {
 
-     // Vector dimensions
-     int num_time = bdy_data_xlo.size();
-     int num_var  = bdy_data_xlo[0].size();
+     // Vector dimensions (streamed data is read again from the wrfbdy file on restart)
+     int num_time = (m_bdy_stream) ? 0 : bdy_data_xlo.size();
+     int num_var  = (m_bdy_stream) ? 0 : bdy_data_xlo[0].size();
 
      // Open header file and write to it
      std::ofstream bdy_h_file(MultiFabFileFullPrefix(0, checkpointname, "Level_", "bdy_H"));
@@ -352,11 +510,42 @@ ERF::ReadCheckpointFile ()
         }
     }
 
-    for (int lev = 0; lev <= finest_level; ++lev) {
-        // read in level 'lev' BoxArray from Header
-        BoxArray ba;
-        ba.readFrom(is);
+    // read in the BoxArray of every level in the checkpoint from Header
+    const int nlev_read = finest_level + 1;
+    Vector<BoxArray> chk_ba(nlev_read);
+    for (int lev = 0; lev < nlev_read; ++lev) {
+        chk_ba[lev].readFrom(is);
         GotoNextLine(is);
+    }
+
+    // A checkpoint of a coarser level 0 domain is interpolated onto the current one
+    {
+        const Box& domain     = geom[0].Domain();
+        const Box  chk_domain = chk_ba[0].minimalBox();
+        if (chk_domain != domain) {
+            if (!restart_interp) {
+                Abort("The checkpoint domain differs from the current one; set erf.restart_interp = true to interpolate");
+            }
+            restart_ratio = domain.length() / chk_domain.length();
+            if (restart_ratio.min() < 1 || amrex::coarsen(domain, restart_ratio) != chk_domain) {
+                Abort("The current domain must be a refinement of the checkpoint domain to interpolate");
+            }
+            Print() << "Interpolating the checkpoint onto level 0 refined by " << restart_ratio << "\n";
+
+            // Only level 0 is restarted; finer levels are made again by regridding
+            finest_level = 0;
+            dt[0] /= restart_ratio.max();
+        }
+    }
+
+    for (int lev = 0; lev <= finest_level; ++lev) {
+        BoxArray ba = chk_ba[lev];
+
+        // Restart onto grids made from the current max_grid_size
+        if (restart_regrid || restart_ratio != IntVect(1)) {
+            ba = (lev == 0) ? BoxArray(geom[0].Domain()) : BoxArray(ba.simplified_list());
+            ba.maxSize(maxGridSize(lev));
+        }
 
         // create a distribution mapping
         DistributionMapping dm { ba, ParallelDescriptor::NProcs() };
@@ -372,114 +561,111 @@ ERF::ReadCheckpointFile ()
     // read in the MultiFab data
     for (int lev = 0; lev <= finest_level; ++lev)
     {
-        MultiFab cons(grids[lev],dmap[lev],ncomp_cons,0);
-        VisMF::Read(cons, MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "Cell"));
-        MultiFab::Copy(vars_new[lev][Vars::cons],cons,0,0,ncomp_cons,0);
+        const Geometry& g = geom[lev];
+        const IntVect& rr = restart_ratio;
+
+        read_restart_mf(vars_new[lev][Vars::cons], MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "Cell"),
+                        IntVect(0), g, rr);
         vars_new[lev][Vars::cons].setBndry(1.0e34);
 
-        MultiFab xvel(convert(grids[lev],IntVect(1,0,0)),dmap[lev],1,0);
-        VisMF::Read(xvel, MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "XFace"));
-        MultiFab::Copy(vars_new[lev][Vars::xvel],xvel,0,0,1,0);
+        read_restart_mf(vars_new[lev][Vars::xvel], MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "XFace"),
+                        IntVect(0), g, rr);
         vars_new[lev][Vars::xvel].setBndry(1.0e34);
 
-        MultiFab yvel(convert(grids[lev],IntVect(0,1,0)),dmap[lev],1,0);
-        VisMF::Read(yvel, MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "YFace"));
-        MultiFab::Copy(vars_new[lev][Vars::yvel],yvel,0,0,1,0);
+        read_restart_mf(vars_new[lev][Vars::yvel], MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "YFace"),
+                        IntVect(0), g, rr);
         vars_new[lev][Vars::yvel].setBndry(1.0e34);
 
-        MultiFab zvel(convert(grids[lev],IntVect(0,0,1)),dmap[lev],1,0);
-        VisMF::Read(zvel, MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "ZFace"));
-        MultiFab::Copy(vars_new[lev][Vars::zvel],zvel,0,0,1,0);
+        read_restart_mf(vars_new[lev][Vars::zvel], MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "ZFace"),
+                        IntVect(0), g, rr);
         vars_new[lev][Vars::zvel].setBndry(1.0e34);
 
-        // Note that we read the ghost cells of the base state (unlike above)
-        IntVect ng = base_state[lev].nGrowVect();
-        MultiFab base(grids[lev],dmap[lev],base_state[lev].nComp(),ng);
-        VisMF::Read(base, MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "BaseState"));
-        MultiFab::Copy(base_state[lev],base,0,0,base.nComp(),ng);
-        base_state[lev].FillBoundary(geom[lev].periodicity());
+        // The grid-dependent fields below are recomputed on a refined level 0 rather than interpolated
+        const bool interp = (rr != IntVect(1));
 
+        IntVect ng;
         if (solverChoice.use_terrain)  {
            // Note that we also read the ghost cells of z_phys_nd
            ng = z_phys_nd[lev]->nGrowVect();
-           MultiFab z_height(convert(grids[lev],IntVect(1,1,1)),dmap[lev],1,ng);
-           VisMF::Read(z_height, MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "Z_Phys_nd"));
-           MultiFab::Copy(*z_phys_nd[lev],z_height,0,0,1,ng);
+           read_restart_mf(*z_phys_nd[lev], MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "Z_Phys_nd"),
+                           ng, g, rr);
            update_terrain_arrays(lev);
         }
 
+        if (!interp) {
+            // Note that we read the ghost cells of the base state (unlike above)
+            ng = base_state[lev].nGrowVect();
+            read_restart_mf(base_state[lev], MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "BaseState"),
+                            ng, g, rr);
+        } else if (init_type == "real" || init_type == "metgrid") {
+            // Balance the base state hydrostatically with the restarted density
+            restart_hse(lev);
+        } else {
+            // The base state of idealized problems is defined analytically
+            initHSE(lev);
+        }
+        base_state[lev].FillBoundary(geom[lev].periodicity());
+
         // Read in the precipitation accumulation component
         if (solverChoice.moisture_type == MoistureType::Kessler) {
             ng = qmoist[lev][4]->nGrowVect();
-            int nvar = 1;
-            MultiFab moist_vars(grids[lev],dmap[lev],nvar,ng);
-            VisMF::Read(moist_vars, amrex::MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "RainAccum"));
-            MultiFab::Copy(*(qmoist[lev][4]),moist_vars,0,0,nvar,ng);
+            read_restart_mf(*(qmoist[lev][4]), MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "RainAccum"),
+                            ng, g, rr);
         }
 
          if (solverChoice.moisture_type == MoistureType::SAM) {
             ng = qmoist[lev][8]->nGrowVect();
-            int nvar = 1;
-            MultiFab rain_accum(grids[lev],dmap[lev],nvar,ng);
-            VisMF::Read(rain_accum, amrex::MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "RainAccum"));
-            MultiFab::Copy(*(qmoist[lev][8]),rain_accum,0,0,nvar,ng);
+            read_restart_mf(*(qmoist[lev][8]), MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "RainAccum"),
+                            ng, g, rr);
 
             ng = qmoist[lev][9]->nGrowVect();
-            MultiFab snow_accum(grids[lev],dmap[lev],nvar,ng);
-            VisMF::Read(snow_accum, amrex::MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "SnowAccum"));
-            MultiFab::Copy(*(qmoist[lev][9]),snow_accum,0,0,nvar,ng);
+            read_restart_mf(*(qmoist[lev][9]), MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "SnowAccum"),
+                            ng, g, rr);
 
             ng = qmoist[lev][10]->nGrowVect();
-            MultiFab graup_accum(grids[lev],dmap[lev],nvar,ng);
-            VisMF::Read(graup_accum, amrex::MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "GraupAccum"));
-            MultiFab::Copy(*(qmoist[lev][10]),graup_accum,0,0,nvar,ng);
-
+            read_restart_mf(*(qmoist[lev][10]), MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "GraupAccum"),
+                            ng, g, rr);
         }
 
 #if defined(ERF_USE_WINDFARM)
         if(solverChoice.windfarm_type == WindFarmType::Fitch or
            solverChoice.windfarm_type == WindFarmType::EWP or
            solverChoice.windfarm_type == WindFarmType::SimpleAD){
-            ng = Nturb[lev].nGrowVect();
-            MultiFab mf_Nturb(grids[lev],dmap[lev],1,ng);
-            VisMF::Read(mf_Nturb, amrex::MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "NumTurb"));
-            MultiFab::Copy(Nturb[lev],mf_Nturb,0,0,1,ng);
+            // The turbine counts were already made for these grids by init_windfarm
+            if (!interp) {
+                ng = Nturb[lev].nGrowVect();
+                read_restart_mf(Nturb[lev], MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "NumTurb"),
+                                ng, g, rr);
+            }
         }
 #endif
 
         if (solverChoice.lsm_type != LandSurfaceType::None) {
+            // The third dimension of the land surface data is the soil levels, which are not refined
+            const IntVect rr_lsm(rr[0], rr[1], 1);
             for (int mvar(0); mvar<lsm_data[lev].size(); ++mvar) {
-                BoxArray ba = lsm_data[lev][mvar]->boxArray();
-                DistributionMapping dm = lsm_data[lev][mvar]->DistributionMap();
                 ng = lsm_data[lev][mvar]->nGrowVect();
-                int nvar = lsm_data[lev][mvar]->nComp();
-                MultiFab lsm_vars(ba,dm,nvar,ng);
-                VisMF::Read(lsm_vars, MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "LsmVars"));
-                MultiFab::Copy(*(lsm_data[lev][mvar]),lsm_vars,0,0,nvar,ng);
+                read_restart_mf(*(lsm_data[lev][mvar]), MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "LsmVars"),
+                                ng, lsm.Get_Lsm_Geom(lev), rr_lsm);
             }
         }
 
-        // Note that we read the ghost cells of the mapfactors
-        BoxList bl2d = grids[lev].boxList();
-        for (auto& b : bl2d) {
-            b.setRange(2,0);
-        }
-        BoxArray ba2d(std::move(bl2d));
+        // Map factors that are not read from data were already set for these grids
+        // when the level was made
+        if (interp && init_type != "real" && init_type != "metgrid") continue;
 
+        // Note that we read the ghost cells of the mapfactors
         ng = mapfac_m[lev]->nGrowVect();
-        MultiFab mf_m(ba2d,dmap[lev],1,ng);
-        VisMF::Read(mf_m, MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "MapFactor_m"));
-        MultiFab::Copy(*mapfac_m[lev],mf_m,0,0,1,ng);
+        read_restart_mf(*mapfac_m[lev], MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "MapFactor_m"),
+                        ng, g, rr);
 
         ng = mapfac_u[lev]->nGrowVect();
-        MultiFab mf_u(convert(ba2d,IntVect(1,0,0)),dmap[lev],1,ng);
-        VisMF::Read(mf_u, MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "MapFactor_u"));
-        MultiFab::Copy(*mapfac_u[lev],mf_u,0,0,1,ng);
+        read_restart_mf(*mapfac_u[lev], MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "MapFactor_u"),
+                        ng, g, rr);
 
         ng = mapfac_v[lev]->nGrowVect();
-        MultiFab mf_v(convert(ba2d,IntVect(0,1,0)),dmap[lev],1,ng);
-        VisMF::Read(mf_v, MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "MapFactor_v"));
-        MultiFab::Copy(*mapfac_v[lev],mf_v,0,0,1,ng);
+        read_restart_mf(*mapfac_v[lev], MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "MapFactor_v"),
+                        ng, g, rr);
     }
 
 #ifdef ERF_USE_PARTICLES
@@ -487,8 +673,19 @@ ERF::ReadCheckpointFile ()
 #endif
 
 #ifdef ERF_USE_NETCDF
+    // Stream the boundary data from the wrfbdy file again
+    if ((init_type=="real") && real_bdy_stream) {
+        m_bdy_stream = std::make_unique<WRFBdyStream>(nc_bdy_file, nc_init_file[0][0],
+                                                      geom[0], solverChoice.moisture_type);
+        bdy_time_interval = m_bdy_stream->interval();
+        start_bdy_time    = m_bdy_stream->start_time();
+        real_width        = m_bdy_stream->width();
+        m_bdy_stream->update(t_new[0], 0.0, vars_new[0][Vars::cons],
+                             bdy_data_xlo, bdy_data_xhi, bdy_data_ylo, bdy_data_yhi);
+        m_bdy_stream->finish_reads();
+    }
     // Read bdy_data files
-    if ((init_type=="real") || (init_type=="metgrid")) {
+    else if ((init_type=="real") || (init_type=="metgrid")) {
         int ioproc = ParallelDescriptor::IOProcessorNumber();  // I/O rank
         int num_time;
         int num_var;
@@ -547,6 +744,10 @@ ERF::ReadCheckpointFile ()
         ParallelDescriptor::Bcast(&num_time,1,ioproc);
         ParallelDescriptor::Bcast(&num_var,1,ioproc);
 
+        if (num_time == 0) {
+            Abort("This checkpoint was written with erf.real_bdy_stream = true; restart with it too");
+        }
+
         // Everyone size their boxes
         bx_v.resize(4*num_var);
 
@@ -605,7 +806,8 @@ ERF::ReadCheckpointFileMOST ()
             amrex::Print() << "Reading variable surface roughness" << std::endl;
             IntVect ng = vars_new[lev][Vars::cons].nGrowVect(); ng[2]=0;
             MultiFab z0_in(ba2d,dmap[lev],1,ng);
-            VisMF::Read(z0_in, MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "Z0"));
+            read_restart_mf(z0_in, MultiFabFileFullPrefix(lev, restart_chkfile, "Level_", "Z0"),
+                            ng, geom[lev], restart_ratio);
             auto z0 = const_cast<FArrayBox*>(m_most->get_z0(lev));
             for (amrex::MFIter mfi(z0_in); mfi.isValid(); ++mfi) {
                 const Box& bx = mfi.growntilebox();
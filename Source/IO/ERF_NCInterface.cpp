@@ -439,6 +439,27 @@ void NCVar::par_access (const int cmode) const
     check_nc_error(nc_var_par_access(ncid, varid, cmode));
 }
 
+/**
+ * Error-checking wrapper for NetCDF function nc_def_var_chunking
+ *
+ * @param chunks Chunk size in each dimension of the variable
+ */
+void NCVar::def_chunking (const std::vector<size_t>& chunks) const
+{
+    check_nc_error(nc_def_var_chunking(ncid, varid, NC_CHUNKED, chunks.data()));
+}
+
+/**
+ * Error-checking wrapper for NetCDF function nc_def_var_deflate
+ *
+ * @param level Deflate level, 1 (fastest) to 9 (smallest)
+ * @param shuffle Whether to byte-shuffle the data before compressing
+ */
+void NCVar::def_deflate (const int level, const bool shuffle) const
+{
+    check_nc_error(nc_def_var_deflate(ncid, varid, shuffle ? 1 : 0, 1, level));
+}
+
 std::string NCGroup::name () const
 {
     size_t nlen;
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <string>
 #include <ctime>
+#include <algorithm>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -25,14 +26,25 @@ ERF::writeNCPlotFile (int lev, int which_subdomain, const std::string& dir,
                       const Vector<int>& /*level_steps*/, const Real time) const
 {
      // get the processor number
-     int iproc = amrex::ParallelContext::MyProcAll();
-     int nproc = amrex::ParallelDescriptor::NProcs();
+     int iproc = amrex::ParallelContext::MyProcSub();
+     int nproc = amrex::ParallelContext::NProcsSub();
 
      // total number of cells in this "domain" at this level
      std::vector<int> n_cells;
 
-     // number of points in each block at this level
-     std::vector<int> offset;
+     // Number of ranks that gather the data and write it collectively;
+     //     with 0 every rank writes each of its FABs independently
+     int nc_aggregators = 0;
+     // Default chunk size (in points) and deflate level, which may be overridden per variable
+     //     with erf.nc_plot_chunk.<var> and erf.nc_plot_deflate.<var>
+     int nc_chunk   = 0;
+     int nc_deflate = 0;
+     {
+         ParmParse pp("erf");
+         pp.query("nc_plot_aggregators", nc_aggregators);
+         pp.query("nc_plot_chunk", nc_chunk);
+         pp.query("nc_plot_deflate", nc_deflate);
+     }
 
      // set the full IO path for NetCDF output
      std::string FullPath = dir;
@@ -52,14 +64,6 @@ ERF::writeNCPlotFile (int lev, int which_subdomain, const std::string& dir,
 
      int nblocks = grids[lev].size();
      auto dm = plotMF[lev]->DistributionMap();
-     offset.reserve(nproc);
-     for(auto n = 0; n < nproc; n++) {
-         offset[n] = 0;
-     }
-     for(auto ib=0; ib<nblocks; ib++) {
-        auto npts_per_block = grids[lev][ib].length(0)*grids[lev][ib].length(1)*grids[lev][ib].length(2);
-        offset[dm[ib]] += npts_per_block;
-     }
 
      // We only do single-level writes when using NetCDF format
      int flev = lev;
@@ -71,6 +75,16 @@ ERF::writeNCPlotFile (int lev, int which_subdomain, const std::string& dir,
          subdomain = boxes_at_level[lev][which_subdomain];
      }
 
+     // Offset of each block in the file; blocks are stored in the same order as the grid coordinates
+     std::vector<long unsigned> block_offset(nblocks, 0);
+     long unsigned total_pts = 0;
+     for (auto ib = 0; ib < nblocks; ib++) {
+         if (subdomain.contains(grids[lev][ib])) {
+             block_offset[ib] = total_pts;
+             total_pts += grids[lev][ib].numPts();
+         }
+     }
+
      int nx = subdomain.length(0);
      int ny = subdomain.length(1);
      int nz = subdomain.length(2);
@@ -117,6 +131,24 @@ ERF::writeNCPlotFile (int lev, int which_subdomain, const std::string& dir,
 
      for (int i = 0; i < plot_var_names.size(); i++) {
          ncf.def_var(plot_var_names[i], NC_FLOAT, {np_name});
+
+         int var_chunk   = nc_chunk;
+         int var_deflate = nc_deflate;
+         ParmParse pp("erf");
+         pp.query(("nc_plot_chunk."   + plot_var_names[i]).c_str(), var_chunk);
+         pp.query(("nc_plot_deflate." + plot_var_names[i]).c_str(), var_deflate);
+
+         auto nc_plot_var = ncf.var(plot_var_names[i]);
+         if (var_chunk > 0) {
+             nc_plot_var.def_chunking({std::min(static_cast<size_t>(var_chunk), static_cast<size_t>(num_pts))});
+         }
+         if (var_deflate > 0) {
+             // Compressed variables can only be written collectively
+             if (nc_aggregators <= 0) {
+                 amrex::Abort("erf.nc_plot_deflate requires erf.nc_plot_aggregators > 0");
+             }
+             nc_plot_var.def_deflate(var_deflate);
+         }
      }
 
      ncf.exit_def_mode();
@@ -225,24 +257,132 @@ ERF::writeNCPlotFile (int lev, int which_subdomain, const std::string& dir,
        }
    }
 
-   size_t nfai = 0;
-   long unsigned numpts = 0;
    const int ncomp = plotMF[lev]->nComp();
 
-   for (MFIter fai(*plotMF[lev]); fai.isValid(); ++fai) {
-       auto box = fai.validbox();
-       if (subdomain.contains(box)) {
-           numpts = box.numPts();
-           long unsigned diff = nfai*numpts;
-           for(auto ip = 1; ip <= iproc; ++ip) diff += offset[ip-1];
+   if (nc_aggregators <= 0)
+   {
+       for (MFIter fai(*plotMF[lev]); fai.isValid(); ++fai) {
+           auto box = fai.validbox();
+           if (subdomain.contains(box)) {
+               long unsigned numpts = box.numPts();
+               long unsigned diff   = block_offset[fai.index()];
+
+               for (int k(0); k < ncomp; ++k) {
+                  const auto *data = plotMF[lev]->get(fai).dataPtr(k);
+                  auto nc_plot_var = ncf.var(plot_var_names[k]);
+                  nc_plot_var.par_access(NC_INDEPENDENT);
+                  nc_plot_var.put(data, {diff}, {numpts});
+               }
+           }
+       }
+   }
+   else
+   {
+       //
+       // Each aggregator writes one contiguous range of blocks. Ranks send their FABs to the
+       //     aggregator owning them, and each aggregator writes its range of every variable
+       //     with a single collective call.
+       //
+       const int naggr = std::min(nc_aggregators, nproc);
+       const long unsigned target = (total_pts + naggr - 1) / naggr;
+
+       std::vector<int> block_aggr(nblocks, -1);
+       std::vector<long unsigned> aggr_start(naggr+1, total_pts);
+       aggr_start[0] = 0;
+       int a = 0;
+       for (auto ib = 0; ib < nblocks; ib++) {
+           if (!subdomain.contains(grids[lev][ib])) continue;
+           while (a < naggr-1 && block_offset[ib] >= (a+1)*target) {
+               aggr_start[++a] = block_offset[ib];
+           }
+           block_aggr[ib] = a;
+       }
 
+       // Spread the aggregators evenly over the ranks
+       auto aggr_rank = [=] (int ia) { return (ia * nproc) / naggr; };
+       int my_aggr = -1;
+       for (int ia = 0; ia < naggr; ++ia) {
+           if (aggr_rank(ia) == iproc) my_aggr = ia;
+       }
+
+       // Owner of each block as a rank of the communicator we exchange over
+       std::vector<int> block_rank(nblocks);
+       for (auto ib = 0; ib < nblocks; ib++) {
+           block_rank[ib] = amrex::ParallelContext::global_to_local_rank(dm[ib]);
+       }
+
+       MPI_Comm comm = amrex::ParallelContext::CommunicatorSub();
+       MPI_Datatype mpi_real = ParallelDescriptor::Mpi_typemap<Real>::type();
+       const int tag = ParallelDescriptor::SeqNum();
+
+       // Receive, per source rank, all components of the blocks it sends to us, in block order
+       std::vector<std::vector<Real>> recv_buf(nproc);
+       std::vector<MPI_Request> reqs;
+       if (my_aggr >= 0) {
+           std::vector<long> recv_count(nproc, 0);
+           for (auto ib = 0; ib < nblocks; ib++) {
+               if (block_aggr[ib] == my_aggr) {
+                   recv_count[block_rank[ib]] += grids[lev][ib].numPts() * ncomp;
+               }
+           }
+           for (int r = 0; r < nproc; ++r) {
+               if (recv_count[r] == 0) continue;
+               recv_buf[r].resize(recv_count[r]);
+               reqs.emplace_back();
+               MPI_Irecv(recv_buf[r].data(), static_cast<int>(recv_count[r]), mpi_real,
+                         r, tag, comm, &reqs.back());
+           }
+       }
+
+       // Pack and send our blocks, one message per aggregator
+       std::vector<std::vector<Real>> send_buf(naggr);
+       for (auto ib = 0; ib < nblocks; ib++) {
+           if (block_rank[ib] != iproc || block_aggr[ib] < 0) continue;
+           const FArrayBox& fab = (*plotMF[lev])[ib];
+           const Long npts = grids[lev][ib].numPts();
+           auto& buf = send_buf[block_aggr[ib]];
+           const std::size_t pos = buf.size();
+           buf.resize(pos + npts*ncomp);
            for (int k(0); k < ncomp; ++k) {
-              const auto *data = plotMF[lev]->get(fai).dataPtr(k);
-              auto nc_plot_var = ncf.var(plot_var_names[k]);
-              nc_plot_var.par_access(NC_INDEPENDENT);
-              nc_plot_var.put(data, {diff}, {numpts});
+               Gpu::copyAsync(Gpu::deviceToHost, fab.dataPtr(k), fab.dataPtr(k) + npts,
+                              buf.data() + pos + k*npts);
+           }
+       }
+       Gpu::streamSynchronize();
+       for (int ia = 0; ia < naggr; ++ia) {
+           if (send_buf[ia].empty()) continue;
+           reqs.emplace_back();
+           MPI_Isend(send_buf[ia].data(), static_cast<int>(send_buf[ia].size()), mpi_real,
+                     aggr_rank(ia), tag, comm, &reqs.back());
+       }
+       MPI_Waitall(static_cast<int>(reqs.size()), reqs.data(), MPI_STATUSES_IGNORE);
+
+       // Unpack into one contiguous array per component
+       long unsigned my_start = 0;
+       long unsigned my_count = 0;
+       std::vector<Real> agg_buf;
+       if (my_aggr >= 0) {
+           my_start = aggr_start[my_aggr];
+           my_count = aggr_start[my_aggr+1] - my_start;
+           agg_buf.resize(my_count*ncomp);
+           std::vector<std::size_t> cursor(nproc, 0);
+           for (auto ib = 0; ib < nblocks; ib++) {
+               if (block_aggr[ib] != my_aggr) continue;
+               const long unsigned npts = grids[lev][ib].numPts();
+               const Real* src = recv_buf[block_rank[ib]].data() + cursor[block_rank[ib]];
+               for (int k(0); k < ncomp; ++k) {
+                   std::copy(src + k*npts, src + (k+1)*npts,
+                             agg_buf.data() + k*my_count + (block_offset[ib] - my_start));
+               }
+               cursor[block_rank[ib]] += npts*ncomp;
            }
-           nfai++;
+       }
+
+       // Every rank takes part in the collective writes; only aggregators have data
+       for (int k(0); k < ncomp; ++k) {
+           auto nc_plot_var = ncf.var(plot_var_names[k]);
+           nc_plot_var.par_access(NC_COLLECTIVE);
+           nc_plot_var.put(agg_buf.data() + k*my_count, {my_start}, {my_count});
        }
    }
    ncf.close();
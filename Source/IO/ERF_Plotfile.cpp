@@ -4,6 +4,7 @@
 #include "AMReX_PlotFileUtil.H"
 #include "ERF_TerrainMetrics.H"
 #include "ERF_Constants.H"
+#include "ERF_ZPlotfile.H"
 
 using namespace amrex;
 
@@ -149,6 +150,33 @@ ERF::appendPlotVariables (const std::string& pp_plot_var_names, Vector<std::stri
     }
 }
 
+void
+ERF::setPlotErrorBounds (const std::string& pp_plot_var_names, const std::string& pp_err_bounds,
+                         std::map<std::string,Real>& err_bounds)
+{
+    ParmParse pp(pp_prefix);
+
+    err_bounds.clear();
+
+    // The bounds, if given, are listed in the same order as the names in plot_vars
+    if (pp.contains(pp_err_bounds.c_str()))
+    {
+        int nPltVars = pp.countval(pp_plot_var_names.c_str());
+        int nBounds  = pp.countval(pp_err_bounds.c_str());
+        if (nBounds != nPltVars) {
+            Abort("ERF::setPlotErrorBounds: " + pp_err_bounds + " must have one entry per entry in " + pp_plot_var_names);
+        }
+
+        std::string nm;
+        Real bound;
+        for (int i = 0; i < nPltVars; i++) {
+            pp.get(pp_plot_var_names.c_str(), nm, i);
+            pp.get(pp_err_bounds.c_str(), bound, i);
+            err_bounds[nm] = bound;
+        }
+    }
+}
+
 // set plotfile variable names
 Vector<std::string>
 ERF::PlotFileVarNames (Vector<std::string> plot_var_names )
@@ -183,9 +211,10 @@ ERF::WritePlotFile (int which, Vector<std::string> plot_var_names)
                                     &rV_new[lev], &rW_new[lev]}, fillset);
     }
 
-    // Get qmoist pointers if using moisture
+    // Get qmoist pointers if using moisture, refreshed from the state if they lag it
     bool use_moisture = (solverChoice.moisture_type != MoistureType::None);
     for (int lev = 0; lev <= finest_level; ++lev) {
+        if (use_moisture) micro->Update_Qmoist_Lev(lev, vars_new[lev][Vars::cons]);
         for (int mvar(0); mvar<qmoist[lev].size(); ++mvar) {
             qmoist[lev][mvar] = micro->Get_Qmoist_Ptr(lev,mvar);
         }
@@ -1072,6 +1101,9 @@ ERF::WritePlotFile (int which, Vector<std::string> plot_var_names)
         }
 
 #ifdef ERF_USE_PARTICLES
+        // The deposition needs every particle in the grid that owns it
+        particleData.RedistributeIfNotInPlace();
+
         const auto& particles_namelist( particleData.getNames() );
         for (ParticlesNamesVector::size_type i = 0; i < particles_namelist.size(); i++) {
             if (containerHasElement(plot_var_names, std::string(particles_namelist[i]+"_count"))) {
@@ -1314,8 +1346,8 @@ ERF::WritePlotFile (int which, Vector<std::string> plot_var_names)
 #ifdef ERF_USE_RRTMGP
     // write additional RRTMGP data
     // TODO: currently single level only
-    if (which==1 && plot_rad) {
-        rad.writePlotfile(plot_file_1, t_new[0], istep[0]);
+    if (which==1 && plot_rad && rad[0]) {
+        rad[0]->writePlotfile(plot_file_1, t_new[0], istep[0]);
     }
 #endif
 
@@ -1340,6 +1372,14 @@ ERF::WritePlotFile (int which, Vector<std::string> plot_var_names)
 #ifdef ERF_USE_PARTICLES
             particleData.writePlotFile(plotfilename);
 #endif
+        } else if (plotfile_type == "compressed") {
+            Print() << "Writing compressed plotfile " << plotfilename << "\n";
+            WriteCompressedPlotfile(plotfilename, finest_level+1,
+                                    GetVecOfConstPtrs(mf),
+                                    GetVecOfConstPtrs(mf_nd),
+                                    varnames, (which == 1) ? plot_err_bounds_1 : plot_err_bounds_2,
+                                    t_new[0], istep);
+            writeJobInfo(plotfilename);
 #ifdef ERF_USE_HDF5
         } else if (plotfile_type == "hdf5" || plotfile_type == "HDF5") {
             Print() << "Writing plotfile " << plotfilename+"d01.h5" << "\n";
@@ -1445,6 +1485,15 @@ ERF::WritePlotFile (int which, Vector<std::string> plot_var_names)
             particleData.writePlotFile(plotfilename);
 #endif
 
+        } else if (plotfile_type == "compressed") {
+            Print() << "Writing compressed plotfile " << plotfilename << "\n";
+            WriteCompressedPlotfile(plotfilename, finest_level+1,
+                                    GetVecOfConstPtrs(mf),
+                                    GetVecOfConstPtrs(mf_nd),
+                                    varnames, (which == 1) ? plot_err_bounds_1 : plot_err_bounds_2,
+                                    t_new[0], istep);
+            writeJobInfo(plotfilename);
+
 #ifdef ERF_USE_NETCDF
         } else if (plotfile_type == "netcdf" || plotfile_type == "NetCDF") {
              for (int lev = 0; lev <= finest_level; ++lev) {
@@ -1542,6 +1591,76 @@ ERF::WriteMultiLevelPlotfileWithTerrain (const std::string& plotfilename, int nl
     }
 }
 
+void
+ERF::WriteCompressedPlotfile (const std::string& plotfilename, int nlevels,
+                              const Vector<const MultiFab*>& mf,
+                              const Vector<const MultiFab*>& mf_nd,
+                              const Vector<std::string>& varnames,
+                              const std::map<std::string,Real>& err_bounds,
+                              Real time,
+                              const Vector<int>& level_steps) const
+{
+    BL_PROFILE("WriteCompressedPlotfile()");
+
+    AMREX_ALWAYS_ASSERT(nlevels <= mf.size());
+    AMREX_ALWAYS_ASSERT(nlevels <= level_steps.size());
+    AMREX_ALWAYS_ASSERT(mf[0]->nComp() == varnames.size());
+
+    const std::string levelPrefix   = "Level_";
+    const std::string mfPrefix      = "Cell_Z";
+    const std::string mfNodalPrefix = "Nu_nd_Z";
+
+    PreBuildDirectorHierarchy(plotfilename, levelPrefix, nlevels, true);
+
+    // Requested bound for each component, in plotfile order
+    const int ncomp = mf[0]->nComp();
+    Vector<Real> err_bound(ncomp, m_plot_err_bound);
+    for (int n = 0; n < ncomp; ++n) {
+        auto it = err_bounds.find(varnames[n]);
+        if (it != err_bounds.end()) {
+            err_bound[n] = it->second;
+        }
+    }
+    const bool relative = (m_plot_err_type == "relative");
+
+    for (int level = 0; level < nlevels; ++level)
+    {
+        Vector<Real> abs_err = ZPlotfile::AbsErrorBounds(*mf[level], err_bound, relative);
+        ZPlotfile::WriteLevel(*mf[level], abs_err,
+                              MultiFabFileFullPrefix(level, plotfilename, levelPrefix, mfPrefix));
+
+        // The terrain nodal displacements are always stored losslessly
+        if (solverChoice.use_terrain) {
+            Vector<Real> no_err(mf_nd[level]->nComp(), 0.0);
+            ZPlotfile::WriteLevel(*mf_nd[level], no_err,
+                                  MultiFabFileFullPrefix(level, plotfilename, levelPrefix, mfNodalPrefix));
+        }
+    }
+
+    if (ParallelDescriptor::IOProcessor())
+    {
+        Vector<BoxArray> boxArrays(nlevels);
+        for(int level(0); level < boxArrays.size(); ++level) {
+            boxArrays[level] = mf[level]->boxArray();
+        }
+
+        VisMF::IO_Buffer io_buffer(VisMF::IO_Buffer_Size);
+        std::string HeaderFileName(plotfilename + "/Header");
+        std::ofstream HeaderFile;
+        HeaderFile.rdbuf()->pubsetbuf(io_buffer.dataPtr(), io_buffer.size());
+        HeaderFile.open(HeaderFileName.c_str(), std::ofstream::out   |
+                                                std::ofstream::trunc |
+                                                std::ofstream::binary);
+        if( ! HeaderFile.good()) FileOpenFailed(HeaderFileName);
+
+        // Same layout as a native plotfile Header but with our own version string
+        //     so that AMReX readers don't try to open the data as VisMF files
+        WriteGenericPlotfileHeader(HeaderFile, nlevels, boxArrays, varnames,
+                                   Geom(), time, level_steps, refRatio(),
+                                   ZPlotfile::version_string, levelPrefix, mfPrefix);
+    }
+}
+
 void
 ERF::WriteGenericPlotfileHeaderWithTerrain (std::ostream &HeaderFile,
                                             int nlevels,
@@ -0,0 +1,722 @@
+#include "AMReX_Gpu.H"
+#include "AMReX_ParmParse.H"
+#include "AMReX_Utility.H"
+#include "ERF_ProbeSampler.H"
+#include "ERF_IndexDefines.H"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+
+using namespace amrex;
+
+namespace {
+    //! A locally owned box whose column may contain a probe (terrain only)
+    struct Candidate {
+        int id;
+        int box;
+        int ic, jc;      // cell containing the probe horizontally
+        int klo, khi;    // vertical extent of the box
+        int kmin, kmax;  // vertical extent of the cells its stencils may use
+        Real z;
+    };
+
+    /**
+     * Lower corner, width and weight of the 1D interpolation stencil between cell centers,
+     * using only the cells [lo,hi]
+     */
+    void stencil_1d (Real s, int lo, int hi, int& i, int& di, Real& w)
+    {
+        if (lo == hi) {
+            i = lo; di = 0; w = 0.;
+            return;
+        }
+        i  = static_cast<int>(std::floor(s));
+        w  = s - static_cast<Real>(i);
+        di = 1;
+        if (i < lo) {
+            i = lo; w = 0.;
+        } else if (i > hi-1) {
+            i = hi-1; w = 1.;
+        }
+    }
+
+    //! Whether all cells of bx are valid cells of the level, allowing for periodic images
+    bool covered (const BoxArray& ba, const Geometry& geom, Box bx)
+    {
+        const Box& domain = geom.Domain();
+        for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+            if (!geom.isPeriodic(d)) continue;
+            if (bx.smallEnd(d) < domain.smallEnd(d)) {
+                bx.shift(d, domain.length(d));
+            } else if (bx.bigEnd(d) > domain.bigEnd(d)) {
+                bx.shift(d, -domain.length(d));
+            }
+        }
+        return domain.contains(bx) && ba.contains(bx);
+    }
+
+    //! Trilinear interpolation of every sampled variable at one probe
+    AMREX_GPU_DEVICE AMREX_FORCE_INLINE
+    void interp_probe (const ProbeSampler::Stencil& s, int nvars,
+                       const SampleVars::Type* type, const int* comp,
+                       Array4<const Real> const& cons, Array4<const Real> const& u,
+                       Array4<const Real> const& v, Array4<const Real> const& w,
+                       Real* vals) noexcept
+    {
+        const int i1 = s.i + s.di;
+        const int j1 = s.j + s.dj;
+        const int k1 = s.k + s.dk;
+        for (int nv = 0; nv < nvars; ++nv) {
+            auto f = [&] (int i, int j, int k) {
+                return SampleVars::cc_value(type[nv], comp[nv], i, j, k, cons, u, v, w);
+            };
+            vals[nv] =
+                (1.-s.wz) * ( (1.-s.wy) * ((1.-s.wx) * f(s.i,s.j,s.k ) + s.wx * f(i1,s.j,s.k ))
+                            +     s.wy  * ((1.-s.wx) * f(s.i,j1 ,s.k ) + s.wx * f(i1,j1 ,s.k )) )
+              +     s.wz  * ( (1.-s.wy) * ((1.-s.wx) * f(s.i,s.j,k1  ) + s.wx * f(i1,s.j,k1  ))
+                            +     s.wy  * ((1.-s.wx) * f(s.i,j1 ,k1  ) + s.wx * f(i1,j1 ,k1  )) );
+        }
+    }
+}
+
+/**
+ * Constructor for the ProbeSampler class, which reads the probe locations and variables
+ *
+ * @param cons_names Names of the conserved variables, as used in plotfiles
+ * @param ncons Number of conserved variables in the state
+ */
+ProbeSampler::ProbeSampler (const Vector<std::string>& cons_names, int ncons)
+{
+    ParmParse pp("erf");
+
+    pp.query("probe_dir", m_dir);
+    pp.query("probe_interval", m_interval);
+    pp.query("probe_per", m_per);
+    pp.query("probe_height_agl", m_agl);
+
+    if (m_interval <= 0 && m_per <= 0.) {
+        Abort("ProbeSampler: probes need a positive erf.probe_interval or erf.probe_per");
+    }
+
+    // Locations given directly in the inputs file
+    if (pp.contains("probe_locations")) {
+        int n = pp.countval("probe_locations");
+        if (n % AMREX_SPACEDIM != 0) {
+            Abort("ProbeSampler: erf.probe_locations must hold x y z triplets");
+        }
+        Vector<Real> xyz(n);
+        pp.queryarr("probe_locations", xyz, 0, n);
+        for (int p = 0; p < n/AMREX_SPACEDIM; ++p) {
+            m_x.push_back(xyz[AMREX_SPACEDIM*p  ]);
+            m_y.push_back(xyz[AMREX_SPACEDIM*p+1]);
+            m_z.push_back(xyz[AMREX_SPACEDIM*p+2]);
+        }
+    }
+
+    // Locations read from a file with one "x y z" line per probe; lines starting with # are skipped
+    std::string probe_file;
+    if (pp.query("probe_file", probe_file)) {
+        Vector<char> fileCharPtr;
+        ParallelDescriptor::ReadAndBcastFile(probe_file, fileCharPtr);
+        std::istringstream is(std::string(fileCharPtr.dataPtr()), std::istringstream::in);
+        std::string line;
+        while (std::getline(is, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            std::istringstream ls(line);
+            Real x, y, z;
+            if (ls >> x >> y >> z) {
+                m_x.push_back(x);
+                m_y.push_back(y);
+                m_z.push_back(z);
+            }
+        }
+    }
+
+    if (size() == 0) {
+        Abort("ProbeSampler: no probes given in erf.probe_locations or erf.probe_file");
+    }
+
+    m_var_names = {"x_velocity", "y_velocity", "z_velocity", "theta"};
+    if (pp.contains("probe_vars")) {
+        int nvars = pp.countval("probe_vars");
+        m_var_names.resize(nvars);
+        pp.queryarr("probe_vars", m_var_names, 0, nvars);
+    }
+    SampleVars::map_names(m_var_names, cons_names, ncons, m_var_type, m_var_comp, "probes");
+
+    if (ParallelDescriptor::IOProcessor()) {
+        if (!UtilCreateDirectory(m_dir, 0755)) {
+            CreateDirectoryFailed(m_dir);
+        }
+        write_header();
+    }
+    ParallelDescriptor::Barrier();
+}
+
+/**
+ * Drops the records written after a given step by an earlier run, so that a restarted
+ * run continues the time series without duplicated records
+ *
+ * @param t_step Last step to keep, or -1 to remove every record
+ */
+void
+ProbeSampler::truncate (int t_step) const
+{
+    if (!ParallelDescriptor::IOProcessor()) return;
+
+    const std::string data_name = m_dir + "/data.bin";
+    if (!std::filesystem::exists(data_name)) return;
+
+    const auto fsize = static_cast<std::streamoff>(std::filesystem::file_size(data_name));
+    const auto record_size = static_cast<std::streamoff>(sizeof(int) + sizeof(Real) +
+                                                         static_cast<Long>(size())*m_var_names.size()*sizeof(Real));
+
+    // Keep every complete record up to and including t_step
+    std::streamoff keep = 0;
+    {
+        std::ifstream is(data_name.c_str(), std::ios::in | std::ios::binary);
+        int step;
+        while (keep + record_size <= fsize &&
+               is.seekg(keep) && is.read(reinterpret_cast<char*>(&step), sizeof(int)) &&
+               step <= t_step)
+        {
+            keep += record_size;
+        }
+    }
+    if (keep < fsize) {
+        std::filesystem::resize_file(data_name, static_cast<std::uintmax_t>(keep));
+    }
+}
+
+/**
+ * Writes the Header describing the probe time series
+ */
+void
+ProbeSampler::write_header () const
+{
+    const std::string header_name = m_dir + "/Header";
+    std::ofstream header(header_name.c_str(), std::ofstream::out | std::ofstream::trunc);
+    if (!header.good()) {
+        FileOpenFailed(header_name);
+    }
+
+    header.precision(17);
+    header << "ERF-Probes-V1\n";
+    header << m_var_names.size() << "\n";
+    for (const auto& v : m_var_names) {
+        header << v << "\n";
+    }
+    header << sizeof(Real) << "\n";
+    header << m_agl << "\n";
+    header << size() << "\n";
+    for (int p = 0; p < size(); ++p) {
+        header << m_x[p] << " " << m_y[p] << " " << m_z[p] << "\n";
+    }
+}
+
+/**
+ * Assigns every probe to the finest level containing it, finds the locally owned box
+ * that holds it, computes its interpolation stencil, and sets up the gather to the IO rank
+ *
+ * @param geom Vector of Geometry containing the geometry at each level in the AMR
+ * @param vars_new Grid data for all variables across the AMR hierarchy
+ * @param z_phys_nd Height of the nodes at each level (nullptr without terrain)
+ * @param finest_level Current finest level
+ */
+void
+ProbeSampler::rebin (const Vector<Geometry>& geom,
+                     const Vector<Vector<MultiFab>>& vars_new,
+                     const Vector<std::unique_ptr<MultiFab>>& z_phys_nd,
+                     int finest_level)
+{
+    BL_PROFILE("ERF::ProbeSampler::rebin");
+
+    const int np      = size();
+    const int nlevels = finest_level + 1;
+
+    m_stencil.clear();
+    m_stencil.resize(nlevels);
+    m_ba.resize(nlevels);
+    m_dm.resize(nlevels);
+
+    // Level (plus one) at which each probe has been found, zero if not yet found
+    Vector<int> found(np, 0);
+
+    Vector<Vector<Stencil>> h_stencil(nlevels);
+
+    for (int lev = finest_level; lev >= 0; --lev)
+    {
+        const MultiFab& S = vars_new[lev][Vars::cons];
+        m_ba[lev] = S.boxArray();
+        m_dm[lev] = S.DistributionMap();
+
+        const Box& domain = geom[lev].Domain();
+        const Real* plo   = geom[lev].ProbLo();
+        auto const dxi    = geom[lev].InvCellSizeArray();
+
+        // Local index of each locally owned box
+        Vector<int> local_index(m_ba[lev].size(), -1);
+        for (MFIter mfi(S); mfi.isValid(); ++mfi) {
+            local_index[mfi.index()] = mfi.LocalIndex();
+        }
+
+        // Cells the stencils in each box may use: its valid cells, plus the first cell outside
+        // it wherever that cell is a valid cell of this level or its periodic image. This only clamps the stencils at non-periodic domain
+        // edges and at coarse-fine boundaries.
+        std::map<int,Box> range_of;
+        auto stencil_range = [&] (int gidx) -> const Box&
+        {
+            auto it = range_of.find(gidx);
+            if (it == range_of.end()) {
+                const Box& vbx = m_ba[lev][gidx];
+                Box rbx(vbx);
+                for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                    if (covered(m_ba[lev], geom[lev], adjCellLo(vbx,d))) rbx.growLo(d,1);
+                    if (covered(m_ba[lev], geom[lev], adjCellHi(vbx,d))) rbx.growHi(d,1);
+                }
+                it = range_of.emplace(gidx, rbx).first;
+            }
+            return it->second;
+        };
+
+        const bool has_terrain = (lev < static_cast<int>(z_phys_nd.size()) && z_phys_nd[lev]);
+
+        // Horizontal cell of each probe at this level, or -1 outside the domain
+        Vector<int> icell(np,-1), jcell(np,-1);
+        for (int p = 0; p < np; ++p)
+        {
+            const int ic = static_cast<int>(std::floor((m_x[p] - plo[0]) * dxi[0]));
+            const int jc = static_cast<int>(std::floor((m_y[p] - plo[1]) * dxi[1]));
+            if (ic < domain.smallEnd(0) || ic > domain.bigEnd(0) ||
+                jc < domain.smallEnd(1) || jc > domain.bigEnd(1)) continue;
+            icell[p] = ic;
+            jcell[p] = jc;
+        }
+
+        // Height of each probe: with terrain and heights above ground, the surface height of
+        // the probe's column is found by the owner of its lowest cell and shared with all ranks
+        Vector<Real> zprobe(m_z);
+        if (has_terrain && m_agl)
+        {
+            Vector<Real> zsurf(np, std::numeric_limits<Real>::lowest());
+
+            Vector<int> h_id, h_box, h_ic, h_jc;
+            for (int p = 0; p < np; ++p) {
+                if (found[p] > 0 || icell[p] < 0) continue;
+                const IntVect cell(icell[p], jcell[p], domain.smallEnd(2));
+                auto isects = m_ba[lev].intersections(Box(cell,cell), true, 0);
+                if (!isects.empty() && local_index[isects[0].first] >= 0) {
+                    h_id.push_back(p);
+                    h_box.push_back(local_index[isects[0].first]);
+                    h_ic.push_back(icell[p]);
+                    h_jc.push_back(jcell[p]);
+                }
+            }
+
+            const int nsurf = static_cast<int>(h_id.size());
+            Gpu::DeviceVector<int>  d_box(nsurf), d_ic(nsurf), d_jc(nsurf);
+            Gpu::DeviceVector<Real> d_zs(nsurf);
+            Gpu::copy(Gpu::hostToDevice, h_box.begin(), h_box.end(), d_box.begin());
+            Gpu::copy(Gpu::hostToDevice, h_ic.begin() , h_ic.end() , d_ic.begin());
+            Gpu::copy(Gpu::hostToDevice, h_jc.begin() , h_jc.end() , d_jc.begin());
+
+            const int* box_ptr = d_box.data();
+            const int* ic_ptr  = d_ic.data();
+            const int* jc_ptr  = d_jc.data();
+            Real*      zs_ptr  = d_zs.data();
+
+            auto const& zn_arrs = z_phys_nd[lev]->const_arrays();
+            const int dom_klo   = domain.smallEnd(2);
+
+            ParallelFor(nsurf, [=] AMREX_GPU_DEVICE (int n) noexcept
+            {
+                auto const& zn = zn_arrs[box_ptr[n]];
+                const int i = ic_ptr[n];
+                const int j = jc_ptr[n];
+                zs_ptr[n] = 0.25 * ( zn(i,j,dom_klo) + zn(i+1,j,dom_klo)
+                                   + zn(i,j+1,dom_klo) + zn(i+1,j+1,dom_klo) );
+            });
+
+            Vector<Real> h_zs(nsurf);
+            Gpu::copy(Gpu::deviceToHost, d_zs.begin(), d_zs.end(), h_zs.begin());
+            for (int n = 0; n < nsurf; ++n) {
+                zsurf[h_id[n]] = h_zs[n];
+            }
+            ParallelDescriptor::ReduceRealMax(zsurf.data(), np);
+
+            for (int p = 0; p < np; ++p) {
+                // Columns whose surface is not covered by this level are left to coarser levels
+                if (zsurf[p] == std::numeric_limits<Real>::lowest()) {
+                    icell[p] = -1;
+                } else {
+                    zprobe[p] += zsurf[p];
+                }
+            }
+        }
+
+        Vector<Candidate> h_cand;
+
+        for (int p = 0; p < np; ++p)
+        {
+            if (found[p] > 0 || icell[p] < 0) continue;
+
+            const int ic = icell[p];
+            const int jc = jcell[p];
+
+            if (has_terrain) {
+                // The height of the cells is only known on the ranks owning the column
+                Box column(IntVect(ic,jc,domain.smallEnd(2)), IntVect(ic,jc,domain.bigEnd(2)));
+                for (const auto& is : m_ba[lev].intersections(column)) {
+                    if (local_index[is.first] >= 0) {
+                        const Box& vbx = m_ba[lev][is.first];
+                        const Box& rbx = stencil_range(is.first);
+                        h_cand.push_back({p, local_index[is.first], ic, jc,
+                                          vbx.smallEnd(2), vbx.bigEnd(2),
+                                          rbx.smallEnd(2), rbx.bigEnd(2), zprobe[p]});
+                    }
+                }
+            } else {
+                const Real zabs = m_agl ? m_z[p] + plo[2] : m_z[p];
+                int kc = static_cast<int>(std::floor((zabs - plo[2]) * dxi[2]));
+                if (kc == domain.bigEnd(2)+1 && zabs == geom[lev].ProbHi(2)) kc = domain.bigEnd(2);
+                if (kc < domain.smallEnd(2) || kc > domain.bigEnd(2)) continue;
+
+                const IntVect cell(ic,jc,kc);
+                auto isects = m_ba[lev].intersections(Box(cell,cell), true, 0);
+                if (isects.empty()) continue;
+                found[p] = lev + 1;
+
+                const int gidx = isects[0].first;
+                if (local_index[gidx] < 0) continue;
+
+                const Box& rbx = stencil_range(gidx);
+                Stencil st;
+                st.id  = p;
+                st.box = local_index[gidx];
+                stencil_1d((m_x[p] - plo[0]) * dxi[0] - 0.5, rbx.smallEnd(0), rbx.bigEnd(0), st.i, st.di, st.wx);
+                stencil_1d((m_y[p] - plo[1]) * dxi[1] - 0.5, rbx.smallEnd(1), rbx.bigEnd(1), st.j, st.dj, st.wy);
+                stencil_1d((zabs   - plo[2]) * dxi[2] - 0.5, rbx.smallEnd(2), rbx.bigEnd(2), st.k, st.dk, st.wz);
+                h_stencil[lev].push_back(st);
+            }
+        }
+
+        if (has_terrain)
+        {
+            // Search the columns of the candidate boxes for the cell holding each probe
+            const int ncand = static_cast<int>(h_cand.size());
+
+            Gpu::DeviceVector<Candidate> d_cand(ncand);
+            Gpu::DeviceVector<int>       d_k(ncand), d_dk(ncand), d_ok(ncand);
+            Gpu::DeviceVector<Real>      d_wz(ncand);
+            Gpu::copy(Gpu::hostToDevice, h_cand.begin(), h_cand.end(), d_cand.begin());
+
+            const Candidate* cand = d_cand.data();
+            int*  kb_ptr = d_k.data();
+            int*  dk_ptr = d_dk.data();
+            int*  ok_ptr = d_ok.data();
+            Real* wz_ptr = d_wz.data();
+
+            auto const& zn_arrs = z_phys_nd[lev]->const_arrays();
+            const int dom_khi   = domain.bigEnd(2);
+
+            ParallelFor(ncand, [=] AMREX_GPU_DEVICE (int n) noexcept
+            {
+                const Candidate& c = cand[n];
+                auto const& zn = zn_arrs[c.box];
+
+                auto zcol = [&] (int k) {
+                    return 0.25 * ( zn(c.ic,c.jc,k) + zn(c.ic+1,c.jc,k)
+                                  + zn(c.ic,c.jc+1,k) + zn(c.ic+1,c.jc+1,k) );
+                };
+
+                const Real zabs = c.z;
+
+                ok_ptr[n] = 0;
+                if (zabs < zcol(c.klo) || zabs > zcol(c.khi+1)) return;
+                if (zabs == zcol(c.khi+1) && c.khi != dom_khi) return;
+
+                int kc = c.klo;
+                while (kc < c.khi && zabs >= zcol(kc+1)) ++kc;
+
+                if (c.kmin == c.kmax) {
+                    kb_ptr[n] = c.kmin;
+                    dk_ptr[n] = 0;
+                    wz_ptr[n] = 0.;
+                } else {
+                    const Real zc = 0.5 * (zcol(kc) + zcol(kc+1));
+                    int kb = (zabs < zc) ? kc-1 : kc;
+                    kb = amrex::max(c.kmin, amrex::min(kb, c.kmax-1));
+                    const Real z0 = 0.5 * (zcol(kb  ) + zcol(kb+1));
+                    const Real z1 = 0.5 * (zcol(kb+1) + zcol(kb+2));
+                    kb_ptr[n] = kb;
+                    dk_ptr[n] = 1;
+                    wz_ptr[n] = amrex::max(Real(0.), amrex::min(Real(1.), (zabs - z0) / (z1 - z0)));
+                }
+                ok_ptr[n] = 1;
+            });
+
+            Vector<int>  h_k(ncand), h_dk(ncand), h_ok(ncand);
+            Vector<Real> h_wz(ncand);
+            Gpu::copy(Gpu::deviceToHost, d_k.begin() , d_k.end() , h_k.begin());
+            Gpu::copy(Gpu::deviceToHost, d_dk.begin(), d_dk.end(), h_dk.begin());
+            Gpu::copy(Gpu::deviceToHost, d_ok.begin(), d_ok.end(), h_ok.begin());
+            Gpu::copy(Gpu::deviceToHost, d_wz.begin(), d_wz.end(), h_wz.begin());
+
+            for (int n = 0; n < ncand; ++n)
+            {
+                if (h_ok[n] == 0) continue;
+                const Candidate& c = h_cand[n];
+                const Box& rbx = stencil_range(S.IndexArray()[c.box]);
+                Stencil st;
+                st.id  = c.id;
+                st.box = c.box;
+                stencil_1d((m_x[c.id] - plo[0]) * dxi[0] - 0.5, rbx.smallEnd(0), rbx.bigEnd(0), st.i, st.di, st.wx);
+                stencil_1d((m_y[c.id] - plo[1]) * dxi[1] - 0.5, rbx.smallEnd(1), rbx.bigEnd(1), st.j, st.dj, st.wy);
+                st.k  = h_k[n];
+                st.dk = h_dk[n];
+                st.wz = h_wz[n];
+                h_stencil[lev].push_back(st);
+                found[c.id] = lev + 1;
+            }
+
+            // Only the owners know which probes they found
+            ParallelDescriptor::ReduceIntMax(found.data(), np);
+        }
+    }
+
+    // Stencils that reach into a neighbouring box read from a small copy of their cells,
+    // one box per probe owned by the rank of the probe, instead of the ghost cells of the
+    // state. The boxes are listed in probe order on all ranks, so the local boxes of a rank
+    // come in the order of its probes.
+    m_halo_stencil.clear();
+    m_halo_stencil.resize(nlevels);
+    m_halo_ba.assign(nlevels, BoxArray());
+    m_halo_dm.assign(nlevels, DistributionMapping());
+
+    Vector<Vector<Stencil>> h_direct(nlevels), h_halo(nlevels);
+    const int myproc = ParallelDescriptor::MyProc();
+
+    for (int lev = 0; lev < nlevels; ++lev)
+    {
+        const auto& index_array = vars_new[lev][Vars::cons].IndexArray();
+
+        Vector<int> owner(np, -1);
+        Vector<int> corners(2*AMREX_SPACEDIM*np, 0);
+        for (const auto& st : h_stencil[lev]) {
+            const Box sbx(IntVect(st.i, st.j, st.k), IntVect(st.i+st.di, st.j+st.dj, st.k+st.dk));
+            if (m_ba[lev][index_array[st.box]].contains(sbx)) {
+                h_direct[lev].push_back(st);
+            } else {
+                h_halo[lev].push_back(st);
+                owner[st.id] = myproc;
+                for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                    corners[2*AMREX_SPACEDIM*st.id+d]                = sbx.smallEnd(d);
+                    corners[2*AMREX_SPACEDIM*st.id+AMREX_SPACEDIM+d] = sbx.bigEnd(d);
+                }
+            }
+        }
+        ParallelDescriptor::ReduceIntMax(owner.data(), np);
+        ParallelDescriptor::ReduceIntSum(corners.data(), 2*AMREX_SPACEDIM*np);
+
+        BoxList bl;
+        Vector<int> pmap;
+        for (int p = 0; p < np; ++p) {
+            if (owner[p] < 0) continue;
+            const int* c = &corners[2*AMREX_SPACEDIM*p];
+            bl.push_back(Box(IntVect(c[0], c[1], c[2]), IntVect(c[3], c[4], c[5])));
+            pmap.push_back(owner[p]);
+        }
+        if (pmap.empty()) continue;
+
+        m_halo_ba[lev] = BoxArray(std::move(bl));
+        m_halo_dm[lev] = DistributionMapping(std::move(pmap));
+
+        std::sort(h_halo[lev].begin(), h_halo[lev].end(),
+                  [] (const Stencil& a, const Stencil& b) { return a.id < b.id; });
+        for (int n = 0; n < static_cast<int>(h_halo[lev].size()); ++n) {
+            h_halo[lev][n].box = n;
+        }
+    }
+
+    // Local probes in the order their values are packed: by level, then the stencils reading
+    // the state directly before those reading a copy
+    Vector<int> my_ids;
+    for (int lev = 0; lev < nlevels; ++lev) {
+        m_stencil[lev].resize(h_direct[lev].size());
+        Gpu::copy(Gpu::hostToDevice, h_direct[lev].begin(), h_direct[lev].end(), m_stencil[lev].begin());
+        m_halo_stencil[lev].resize(h_halo[lev].size());
+        Gpu::copy(Gpu::hostToDevice, h_halo[lev].begin(), h_halo[lev].end(), m_halo_stencil[lev].begin());
+        for (const auto& st : h_direct[lev]) {
+            my_ids.push_back(st.id);
+        }
+        for (const auto& st : h_halo[lev]) {
+            my_ids.push_back(st.id);
+        }
+    }
+
+    const int ioproc = ParallelDescriptor::IOProcessorNumber();
+    const int nprocs = ParallelDescriptor::NProcs();
+    int nlocal = static_cast<int>(my_ids.size());
+
+    m_recv_count.assign(nprocs, 0);
+    m_recv_disp.assign(nprocs, 0);
+    ParallelDescriptor::Gather(&nlocal, 1, m_recv_count.data(), 1, ioproc);
+
+    int ntotal = 0;
+    if (ParallelDescriptor::IOProcessor()) {
+        for (int r = 0; r < nprocs; ++r) {
+            m_recv_disp[r] = ntotal;
+            ntotal += m_recv_count[r];
+        }
+    }
+    m_gather_id.resize(ntotal);
+    ParallelDescriptor::Gatherv(my_ids.data(), nlocal, m_gather_id.data(),
+                                m_recv_count, m_recv_disp, ioproc);
+}
+
+/**
+ * Interpolates all probes and appends one record to the probe time series
+ *
+ * @param t_step Timestep number
+ * @param time Current time
+ * @param geom Vector of Geometry containing the geometry at each level in the AMR
+ * @param vars_new Grid data for all variables across the AMR hierarchy
+ * @param z_phys_nd Height of the nodes at each level (nullptr without terrain)
+ * @param finest_level Current finest level
+ * @param terrain_moved Whether the terrain has moved since the last output
+ */
+void
+ProbeSampler::write (int t_step, Real time,
+                     const Vector<Geometry>& geom,
+                     const Vector<Vector<MultiFab>>& vars_new,
+                     const Vector<std::unique_ptr<MultiFab>>& z_phys_nd,
+                     int finest_level, bool terrain_moved)
+{
+    BL_PROFILE("ERF::ProbeSampler::write");
+
+    // The stencils only change when we regrid or the terrain moves
+    bool need_rebin = terrain_moved || (static_cast<int>(m_ba.size()) != finest_level+1);
+    for (int lev = 0; lev <= finest_level && !need_rebin; ++lev) {
+        need_rebin = (m_ba[lev] != vars_new[lev][Vars::cons].boxArray()) ||
+                     (m_dm[lev] != vars_new[lev][Vars::cons].DistributionMap());
+    }
+    if (need_rebin) {
+        rebin(geom, vars_new, z_phys_nd, finest_level);
+    }
+
+    const int nvars = static_cast<int>(m_var_names.size());
+
+    Gpu::DeviceVector<SampleVars::Type> d_type(nvars);
+    Gpu::DeviceVector<int>              d_comp(nvars);
+    Gpu::copy(Gpu::hostToDevice, m_var_type.begin(), m_var_type.end(), d_type.begin());
+    Gpu::copy(Gpu::hostToDevice, m_var_comp.begin(), m_var_comp.end(), d_comp.begin());
+    const SampleVars::Type* type = d_type.data();
+    const int*              comp = d_comp.data();
+
+    // Which parts of the state the variables use
+    Array<bool,AMREX_SPACEDIM> need_vel {false, false, false};
+    for (const auto& t : m_var_type) {
+        if (t == SampleVars::Type::XVel) need_vel[0] = true;
+        if (t == SampleVars::Type::YVel) need_vel[1] = true;
+        if (t == SampleVars::Type::ZVel) need_vel[2] = true;
+    }
+
+    Long nlocal = 0;
+    for (int lev = 0; lev <= finest_level; ++lev) {
+        nlocal += m_stencil[lev].size() + m_halo_stencil[lev].size();
+    }
+
+    Gpu::DeviceVector<Real> d_vals(nlocal*nvars);
+
+    Long offset = 0;
+    for (int lev = 0; lev <= finest_level; ++lev)
+    {
+        const Long n = m_stencil[lev].size();
+        if (n > 0) {
+            auto const& cons = vars_new[lev][Vars::cons].const_arrays();
+            auto const& u    = vars_new[lev][Vars::xvel].const_arrays();
+            auto const& v    = vars_new[lev][Vars::yvel].const_arrays();
+            auto const& w    = vars_new[lev][Vars::zvel].const_arrays();
+
+            const Stencil* stencil = m_stencil[lev].data();
+            Real* vals = d_vals.data() + offset*nvars;
+
+            ParallelFor(n, [=] AMREX_GPU_DEVICE (Long ip) noexcept
+            {
+                const Stencil& s = stencil[ip];
+                interp_probe(s, nvars, type, comp, cons[s.box], u[s.box], v[s.box], w[s.box],
+                             vals + ip*nvars);
+            });
+            offset += n;
+        }
+
+        // Copy the cells of the stencils that reach into neighbouring boxes; only the valid
+        // cells of the state are read, so its ghost cells are left alone
+        if (m_halo_ba[lev].empty()) continue;
+
+        Array<MultiFab,AMREX_SPACEDIM+1> halo;
+        for (int var = Vars::cons; var <= Vars::zvel; ++var) {
+            if (var != Vars::cons && !need_vel[var-Vars::xvel]) continue;
+            const MultiFab& src = vars_new[lev][var];
+            halo[var].define(convert(m_halo_ba[lev], src.ixType()), m_halo_dm[lev], src.nComp(), 0);
+            halo[var].ParallelCopy(src, 0, 0, src.nComp(), IntVect(0), IntVect(0), geom[lev].periodicity());
+        }
+
+        const Long nh = m_halo_stencil[lev].size();
+        if (nh == 0) continue;
+
+        auto const& cons = halo[Vars::cons].const_arrays();
+        auto const& u    = (need_vel[0]) ? halo[Vars::xvel].const_arrays() : cons;
+        auto const& v    = (need_vel[1]) ? halo[Vars::yvel].const_arrays() : cons;
+        auto const& w    = (need_vel[2]) ? halo[Vars::zvel].const_arrays() : cons;
+
+        const Stencil* stencil = m_halo_stencil[lev].data();
+        Real* vals = d_vals.data() + offset*nvars;
+
+        ParallelFor(nh, [=] AMREX_GPU_DEVICE (Long ip) noexcept
+        {
+            const Stencil& s = stencil[ip];
+            interp_probe(s, nvars, type, comp, cons[s.box], u[s.box], v[s.box], w[s.box],
+                         vals + ip*nvars);
+        });
+        offset += nh;
+    }
+
+    Vector<Real> h_vals(nlocal*nvars);
+    Gpu::copy(Gpu::deviceToHost, d_vals.begin(), d_vals.end(), h_vals.begin());
+
+    // Gather to the IO rank, which writes every probe in its global order
+    const int ioproc = ParallelDescriptor::IOProcessorNumber();
+    std::vector<int> recv_count(m_recv_count), recv_disp(m_recv_disp);
+    for (auto& c : recv_count) c *= nvars;
+    for (auto& d : recv_disp)  d *= nvars;
+
+    Vector<Real> gathered(m_gather_id.size()*nvars);
+    ParallelDescriptor::Gatherv(h_vals.data(), static_cast<int>(h_vals.size()), gathered.data(),
+                                recv_count, recv_disp, ioproc);
+
+    if (ParallelDescriptor::IOProcessor())
+    {
+        Vector<Real> record(static_cast<Long>(size())*nvars, std::numeric_limits<Real>::quiet_NaN());
+        for (int g = 0; g < static_cast<int>(m_gather_id.size()); ++g) {
+            for (int nv = 0; nv < nvars; ++nv) {
+                record[m_gather_id[g]*nvars+nv] = gathered[g*nvars+nv];
+            }
+        }
+
+        const std::string data_name = m_dir + "/data.bin";
+        std::ofstream data_file(data_name.c_str(), std::ios::out | std::ios::app | std::ios::binary);
+        if (!data_file.good()) {
+            FileOpenFailed(data_name);
+        }
+        data_file.write(reinterpret_cast<const char*>(&t_step), sizeof(int));
+        data_file.write(reinterpret_cast<const char*>(&time), sizeof(Real));
+        data_file.write(reinterpret_cast<const char*>(record.data()),
+                        static_cast<std::streamsize>(record.size()*sizeof(Real)));
+    }
+}
@@ -5,6 +5,12 @@
 #include "ERF_IndexDefines.H"
 #include "AMReX_MultiFabUtil.H"
 #include "ERF_EOS.H"
+#include <AMReX_VisMF.H>
+#include "AMReX_Utility.H"
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
 
 using namespace amrex;
 
@@ -100,7 +106,7 @@ ReadBndryPlanes::interp_in_time (const Real& time)
         if (time < m_tnp1) {
             for (OrientationIter oit; oit != nullptr; ++oit) {
                 auto ori = oit();
-                if (ori.coordDir() < 2) {
+                if (ori.coordDir() < 2 && m_need[ori]) {
                     const int nlevels = m_data_n[ori]->size();
                     for (int lev = 0; lev < nlevels; ++lev) {
                         const auto& datn   = (*m_data_n[ori])[lev];
@@ -114,7 +120,7 @@ ReadBndryPlanes::interp_in_time (const Real& time)
         } else {
             for (OrientationIter oit; oit != nullptr; ++oit) {
                 auto ori = oit();
-                if (ori.coordDir() < 2) {
+                if (ori.coordDir() < 2 && m_need[ori]) {
                     const int nlevels = m_data_n[ori]->size();
                     for (int lev = 0; lev < nlevels; ++lev) {
                         const auto& datnp1 = (*m_data_np1[ori])[lev];
@@ -251,12 +257,81 @@ void ReadBndryPlanes::read_time_file ()
         ParallelDescriptor::IOProcessorNumber(),
         ParallelDescriptor::Communicator());
 
+    // The aggregated format is recognized by its Header
+    int aggregated = 0;
+    if (ParallelDescriptor::IOProcessor()) {
+        aggregated = FileExists(m_filename + "/Header");
+    }
+    ParallelDescriptor::Bcast(&aggregated, 1, ParallelDescriptor::IOProcessorNumber());
+    m_aggregated = aggregated;
+    if (m_aggregated) {
+        read_aggregated_header();
+    }
+
     // Allocate data we will need -- for now just at one level
     int lev = 0;
     define_level_data(lev);
     Print() << "Successfully read time file and allocated data" << std::endl;
 }
 
+/**
+ * Function in ReadBndryPlanes for deciding which lateral faces this rank needs:
+ * those that one of its level 0 boxes, grown by its ghost cells, reaches.
+ *
+ * @param lev0_vars Level 0 solution data
+ */
+bool ReadBndryPlanes::set_needed_faces (const Vector<MultiFab>& lev0_vars)
+{
+    const MultiFab& cons = lev0_vars[Vars::cons];
+    if (m_need_ba == cons.boxArray() && m_need_dm == cons.DistributionMap()) {
+        return false;
+    }
+    m_need_ba = cons.boxArray();
+    m_need_dm = cons.DistributionMap();
+
+    IntVect ng(0);
+    for (const auto& mf : lev0_vars) {
+        ng.max(mf.nGrowVect());
+    }
+    ng += IntVect(1);
+
+    const Box& domain = m_geom.Domain();
+    std::array<bool,2*AMREX_SPACEDIM> need {};
+    for (OrientationIter oit; oit != nullptr; ++oit) {
+        auto ori = oit();
+        const int dir = ori.coordDir();
+        if (dir < 2) {
+            Box band = grow(domain, ng);
+            if (ori.isLow()) {
+                band.setBig(dir, domain.smallEnd(dir));
+            } else {
+                band.setSmall(dir, domain.bigEnd(dir));
+            }
+            for (MFIter mfi(cons); mfi.isValid() && !need[ori]; ++mfi) {
+                need[ori] = grow(mfi.validbox(), ng).intersects(band);
+            }
+        }
+    }
+
+    const bool changed = (need != m_need);
+    m_need = need;
+    return changed;
+}
+
+/**
+ * Function in ReadBndryPlanes to start reading a file in a background thread
+ *
+ * @param idx Specifies the index corresponding to the timestep we want
+ */
+void ReadBndryPlanes::start_prefetch (const int idx)
+{
+    if (idx >= m_in_times.size() || std::none_of(m_need.begin(), m_need.end(), [] (bool b) { return b; })) {
+        return;
+    }
+    m_prefetch_idx = idx;
+    m_prefetch = std::async(std::launch::async, [this, idx, need = m_need] () { return load_file(idx, need); });
+}
+
 /**
  * Function in ReadBndryPlanes for reading boundary data
  * at a specific time and at the next timestep from input files.
@@ -264,10 +339,12 @@ void ReadBndryPlanes::read_time_file ()
  * @param time Current time
  * @param dt Current timestep
  * @param m_bc_extdir_vals Container storing the external dirichlet boundary conditions we are reading from the input files
+ * @param lev0_vars Level 0 solution data, whose grids decide which faces this rank reads
  */
 void ReadBndryPlanes::read_input_files (Real time,
                                         Real dt,
-                                        Array<Array<Real, AMREX_SPACEDIM*2>,AMREX_SPACEDIM+NBCVAR_max> m_bc_extdir_vals)
+                                        Array<Array<Real, AMREX_SPACEDIM*2>,AMREX_SPACEDIM+NBCVAR_max> m_bc_extdir_vals,
+                                        const Vector<MultiFab>& lev0_vars)
 {
     BL_PROFILE("ERF::ReadBndryPlanes::read_input_files");
 
@@ -276,13 +353,19 @@ void ReadBndryPlanes::read_input_files (Real time,
     AMREX_ALWAYS_ASSERT((m_in_times[0] <= time) && (time <= m_in_times.back()));
     AMREX_ALWAYS_ASSERT((m_in_times[0] <= time+dt) && (time+dt <= m_in_times.back()));
 
-    int ncomp = 1;
+    // If the faces we need have changed, read the files we hold again
+    if (set_needed_faces(lev0_vars) && last_file_read != -1)
+    {
+        if (m_prefetch.valid()) m_prefetch.wait();
+        m_prefetch = std::future<RawPlanes>();
 
-    const Box& domain = m_geom.Domain();
-    BoxArray ba(domain);
-    DistributionMapping dm{ba};
-    BndryRegister bndryn(ba, dm, m_in_rad, m_out_rad, m_extent_rad, ncomp);
-    bndryn.setVal(1.0e13);
+        read_file(last_file_read-2,m_data_n,m_bc_extdir_vals);
+        read_file(last_file_read-1,m_data_np1,m_bc_extdir_vals);
+        read_file(last_file_read  ,m_data_np2,m_bc_extdir_vals);
+        m_tinterp = -1.;
+
+        start_prefetch(last_file_read+1);
+    }
 
     // The first time we enter this routine we read the first three files
     if (last_file_read == -1)
@@ -301,6 +384,8 @@ void ReadBndryPlanes::read_input_files (Real time,
         m_tnp2 = m_in_times[idx_init];
 
         last_file_read = idx_init;
+
+        start_prefetch(last_file_read+1);
     }
 
     // Compute the index such that time falls between times[idx] and times[idx+1]
@@ -323,14 +408,44 @@ void ReadBndryPlanes::read_input_files (Real time,
         m_tnp1 = m_tnp2;
         m_tnp2 = m_in_times[new_read];
 
-        read_file(new_read,m_data_np2,m_bc_extdir_vals);
+        if (m_prefetch.valid() && m_prefetch_idx == new_read) {
+            if (m_prefetch.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                ++m_prefetch_hits;
+            } else {
+                ++m_prefetch_misses;
+                Real t0 = amrex::second();
+                m_prefetch.wait();
+                m_prefetch_wait += amrex::second() - t0;
+            }
+            RawPlanes raw = m_prefetch.get();
+            fill_from_raw(raw,m_data_np2,m_bc_extdir_vals);
+        } else {
+            read_file(new_read,m_data_np2,m_bc_extdir_vals);
+        }
         last_file_read = new_read;
+
+        start_prefetch(last_file_read+1);
     }
 
     AMREX_ASSERT(time    >= m_tn && time    <= m_tnp2);
     AMREX_ASSERT(time+dt >= m_tn && time+dt <= m_tnp2);
 }
 
+/**
+ * Function in ReadBndryPlanes to print the prefetch statistics summed over the ranks
+ */
+void ReadBndryPlanes::print_prefetch_stats () const
+{
+    int hits   = m_prefetch_hits;
+    int misses = m_prefetch_misses;
+    Real wait  = m_prefetch_wait;
+    ParallelDescriptor::ReduceIntSum(hits);
+    ParallelDescriptor::ReduceIntSum(misses);
+    ParallelDescriptor::ReduceRealMax(wait);
+    Print() << "ReadBndryPlanes prefetch: " << hits << " hits, " << misses
+            << " misses, max wait " << wait << " s" << std::endl;
+}
+
 /**
  * Function in ReadBndryPlanes to read boundary data for each face and variable
  * from files.
@@ -343,15 +458,201 @@ void ReadBndryPlanes::read_file (const int idx,
                                  Vector<std::unique_ptr<PlaneVector>>& data_to_fill,
                                  Array<Array<Real, AMREX_SPACEDIM*2>,AMREX_SPACEDIM+NBCVAR_max> m_bc_extdir_vals)
 {
+    RawPlanes raw = load_file(idx, m_need);
+    fill_from_raw(raw, data_to_fill, m_bc_extdir_vals);
+}
+
+/**
+ * Function in ReadBndryPlanes to read the FABs of the needed faces of one file.
+ * The FabSet of each face is read directly from its VisMF header and data files.
+ *
+ * @param idx Specifies the index corresponding to the timestep we want
+ * @param need Which faces to read
+ */
+ReadBndryPlanes::RawPlanes
+ReadBndryPlanes::load_file (const int idx, std::array<bool,2*AMREX_SPACEDIM> need) const
+{
+    if (m_aggregated) {
+        return load_record(idx, need);
+    }
+
     const int t_step = m_in_timesteps[idx];
     const std::string chkname1 = m_filename + Concatenate("/bndry_output", t_step);
 
     const std::string level_prefix = "Level_";
     const int lev = 0;
 
-    const Box& domain = m_geom.Domain();
-    BoxArray ba(domain);
-    DistributionMapping dm{ba};
+    Vector<std::string> var_names {"density"};
+    var_names.insert(var_names.end(), m_var_names.begin(), m_var_names.end());
+
+    RawPlanes raw(var_names.size());
+    for (int ivar = 0; ivar < var_names.size(); ivar++)
+    {
+        raw[ivar].resize(2*AMREX_SPACEDIM);
+
+        std::string filename1 = MultiFabFileFullPrefix(lev, chkname1, level_prefix, var_names[ivar]);
+
+        for (OrientationIter oit; oit != nullptr; ++oit) {
+            auto ori = oit();
+            if (ori.coordDir() >= 2 || !need[ori]) continue;
+
+            std::string facename1 = Concatenate(filename1 + '_', ori, 1);
+
+            std::ifstream hdr_file(facename1 + VisMF::TheMultiFabHdrFileSuffix);
+            if (!hdr_file.good()) {
+                FileOpenFailed(facename1 + VisMF::TheMultiFabHdrFileSuffix);
+            }
+            VisMF::Header hdr;
+            hdr_file >> hdr;
+
+            const std::string dir_name = facename1.substr(0, facename1.rfind('/')+1);
+            for (int i = 0; i < hdr.m_fod.size(); ++i)
+            {
+                std::ifstream fab_file(dir_name + hdr.m_fod[i].m_name, std::ios::in | std::ios::binary);
+                if (!fab_file.good()) {
+                    FileOpenFailed(dir_name + hdr.m_fod[i].m_name);
+                }
+                fab_file.seekg(hdr.m_fod[i].m_head, std::ios::beg);
+
+                // Pinned so the conversion kernels can read it directly
+                FArrayBox fab(The_Pinned_Arena());
+                if (hdr.m_vers == VisMF::Header::Version_v1) {
+                    fab.readFrom(fab_file);
+                } else {
+                    fab.resize(grow(hdr.m_ba[i], hdr.m_ngrow), hdr.m_ncomp);
+                    RealDescriptor::convertToNativeFormat(fab.dataPtr(), fab.size(), fab_file, hdr.m_writtenRD);
+                }
+                raw[ivar][ori].push_back(std::move(fab));
+            }
+        }
+    }
+    return raw;
+}
+
+/**
+ * Function in ReadBndryPlanes to read the Header of the aggregated format, which
+ * is read by the IO rank and broadcast.
+ */
+void ReadBndryPlanes::read_aggregated_header ()
+{
+    Vector<char> file_chars;
+    ParallelDescriptor::ReadAndBcastFile(m_filename + "/Header", file_chars);
+    std::istringstream is(std::string(file_chars.dataPtr()), std::istringstream::in);
+
+    std::string version;
+    is >> version;
+    if (version != "ERF-BndryPlanes-V1") {
+        Abort("ReadBndryPlanes: unknown format " + version + " in " + m_filename + "/Header");
+    }
+
+    int nvars;
+    is >> nvars;
+    m_agg_names.resize(nvars);
+    m_agg_ncomp.resize(nvars);
+    for (int i = 0; i < nvars; ++i) {
+        is >> m_agg_names[i] >> m_agg_ncomp[i];
+    }
+    for (int n = 0; n < 2*(AMREX_SPACEDIM-1); ++n) {
+        int ori;
+        is >> ori;
+        is >> m_agg_box[ori];
+    }
+
+    int real_size;
+    is >> real_size;
+    if (real_size != static_cast<int>(sizeof(Real))) {
+        Abort("ReadBndryPlanes: the boundary planes were written with a different Real precision");
+    }
+
+    for (const auto& var_name : m_var_names) {
+        if (std::find(m_agg_names.begin(), m_agg_names.end(), var_name) == m_agg_names.end()) {
+            Abort("ReadBndryPlanes: variable " + var_name + " is not in " + m_filename);
+        }
+    }
+}
+
+/**
+ * Function in ReadBndryPlanes to read the FABs of the needed faces of one output step
+ * from the face files of the aggregated format. The records have a fixed size, so
+ * record idx is read directly from its offset.
+ *
+ * @param idx Specifies the index corresponding to the timestep we want
+ * @param need Which faces to read
+ */
+ReadBndryPlanes::RawPlanes
+ReadBndryPlanes::load_record (const int idx, std::array<bool,2*AMREX_SPACEDIM> need) const
+{
+    Vector<std::string> var_names {"density"};
+    var_names.insert(var_names.end(), m_var_names.begin(), m_var_names.end());
+
+    RawPlanes raw(var_names.size());
+    for (auto& r : raw) {
+        r.resize(2*AMREX_SPACEDIM);
+    }
+
+    for (OrientationIter oit; oit != nullptr; ++oit) {
+        auto ori = oit();
+        if (ori.coordDir() >= 2 || !need[ori]) continue;
+
+        const Box& bx = m_agg_box[ori];
+
+        // Byte offset of each variable within a record
+        Vector<Long> var_offset(m_agg_names.size());
+        Long record_size = sizeof(int) + sizeof(Real);
+        for (int i = 0; i < m_agg_names.size(); ++i) {
+            var_offset[i] = record_size;
+            record_size += bx.numPts() * m_agg_ncomp[i] * sizeof(Real);
+        }
+
+        const std::string facename = Concatenate(m_filename + "/face_", ori, 1) + ".bin";
+        std::ifstream face_file(facename.c_str(), std::ios::in | std::ios::binary);
+        if (!face_file.good()) {
+            FileOpenFailed(facename);
+        }
+
+        const Long record_start = idx * record_size;
+        int t_step;
+        face_file.seekg(record_start, std::ios::beg);
+        face_file.read(reinterpret_cast<char*>(&t_step), sizeof(int));
+        if (!face_file.good() || t_step != m_in_timesteps[idx]) {
+            Abort("ReadBndryPlanes: " + facename + " does not match time.dat");
+        }
+
+        for (int ivar = 0; ivar < var_names.size(); ++ivar)
+        {
+            const int i = static_cast<int>(std::find(m_agg_names.begin(), m_agg_names.end(), var_names[ivar])
+                                           - m_agg_names.begin());
+            if (i == m_agg_names.size()) {
+                Abort("ReadBndryPlanes: density is not in " + m_filename);
+            }
+
+            // Pinned so the conversion kernels can read it directly
+            FArrayBox fab(The_Pinned_Arena());
+            fab.resize(bx, m_agg_ncomp[i]);
+            face_file.seekg(record_start + var_offset[i], std::ios::beg);
+            face_file.read(reinterpret_cast<char*>(fab.dataPtr()), static_cast<std::streamsize>(fab.nBytes()));
+            if (!face_file.good()) {
+                Abort("ReadBndryPlanes: " + facename + " is truncated");
+            }
+            raw[ivar][ori].push_back(std::move(fab));
+        }
+    }
+    return raw;
+}
+
+/**
+ * Function in ReadBndryPlanes to convert the face data read from a file to
+ * the Dirichlet values on the faces.
+ *
+ * @param raw Face data as read by load_file
+ * @param data_to_fill Container for face data on boundaries
+ * @param m_bc_extdir_vals Container storing the external dirichlet boundary conditions we are reading from the input files
+ */
+void ReadBndryPlanes::fill_from_raw (const RawPlanes& raw,
+                                     Vector<std::unique_ptr<PlaneVector>>& data_to_fill,
+                                     Array<Array<Real, AMREX_SPACEDIM*2>,AMREX_SPACEDIM+NBCVAR_max> m_bc_extdir_vals)
+{
+    const int lev = 0;
 
     GpuArray<GpuArray<Real, AMREX_SPACEDIM*2>, AMREX_SPACEDIM+NBCVAR_max> l_bc_extdir_vals_d;
 
@@ -374,7 +675,7 @@ void ReadBndryPlanes::read_file (const int idx,
     int ncomp_for_bc = BCVars::NumTypes;
     for (OrientationIter oit; oit != nullptr; ++oit) {
         auto ori = oit();
-        if (ori.coordDir() < 2) {
+        if (ori.coordDir() < 2 && m_need[ori]) {
             FArrayBox& d = (*data_to_fill[ori])[lev];
             const auto& bx = d.box();
             Array4<Real> d_arr = d.array();
@@ -385,24 +686,10 @@ void ReadBndryPlanes::read_file (const int idx,
         }
     }
 
-    // Read density for primitive to conserved conversions
-    std::string filenamer = MultiFabFileFullPrefix(lev, chkname1, level_prefix, "density");
-    BndryRegister bndry_r(ba, dm, m_in_rad, m_out_rad, m_extent_rad, 1);
-    bndry_r.setVal(1.0e13);
-    for (OrientationIter oit; oit != nullptr; ++oit) {
-          auto ori = oit();
-          if (ori.coordDir() < 2) {
-              std::string facenamer = Concatenate(filenamer + '_', ori, 1);
-              bndry_r[ori].read(facenamer);
-          }
-    }
-
     for (int ivar = 0; ivar < m_var_names.size(); ivar++)
     {
         std::string var_name = m_var_names[ivar];
 
-        std::string filename1 = MultiFabFileFullPrefix(lev, chkname1, level_prefix, var_name);
-
         int ncomp;
         if (var_name == "velocity") {
             ncomp = AMREX_SPACEDIM;
@@ -421,42 +708,23 @@ void ReadBndryPlanes::read_file (const int idx,
         if (var_name == "qc")          n_offset = BCVars::RhoQ2_bc_comp;
         if (var_name == "velocity")    n_offset = BCVars::xvel_bc;
 
-        // Print() << "Reading " << chkname1 << " for variable " << var_name << " with n_offset == " << n_offset << std::endl;
-
-        BndryRegister bndry(ba, dm, m_in_rad, m_out_rad, m_extent_rad, ncomp);
-        bndry.setVal(1.0e13);
-
-        // *********************************************************
-        // Read in the BndryReg for all non-z faces
-        // *********************************************************
         for (OrientationIter oit; oit != nullptr; ++oit) {
           auto ori = oit();
-          if (ori.coordDir() < 2) {
-
-            std::string facename1 = Concatenate(filename1 + '_', ori, 1);
-            bndry[ori].read(facename1);
+          if (ori.coordDir() < 2 && m_need[ori]) {
 
             const int normal = ori.coordDir();
             const IntVect v_offset = offset(ori.faceDir(), normal);
 
-            const auto& bbx = (*data_to_fill[ori])[lev].box();
-
-            // *********************************************************
-            // Copy from the BndryReg into a MultiFab then use copyTo
-            //     to write from the MultiFab to a single FAB for each face
-            // *********************************************************
-            MultiFab bndryMF(
-                bndry[ori].boxArray(), bndry[ori].DistributionMap(),
-                ncomp, 0, MFInfo());
+            FArrayBox& dest = (*data_to_fill[ori])[lev];
+            const auto& bbx = dest.box();
 
-            for (MFIter mfi(bndryMF); mfi.isValid(); ++mfi) {
+            for (int ib = 0; ib < raw[ivar+1][ori].size(); ++ib) {
 
-                const auto& vbx = mfi.validbox();
-                const auto& bndry_read_arr   = bndry[ori].array(mfi);
-                const auto& bndry_read_r_arr = bndry_r[ori].array(mfi);
-                const auto& bndry_mf_arr     = bndryMF.array(mfi);
+                const auto& bndry_read_arr   = raw[ivar+1][ori][ib].const_array();
+                const auto& bndry_read_r_arr = raw[0][ori][ib].const_array();
+                const auto& bndry_mf_arr     = dest.array(n_offset);
 
-                const auto& bx = bbx & vbx;
+                const auto& bx = bbx & raw[ivar+1][ori][ib].box();
                 if (bx.isEmpty()) {
                     continue;
                 }
@@ -531,10 +799,11 @@ void ReadBndryPlanes::read_file (const int idx,
                                    bndry_read_arr(i+v_offset[0],j+v_offset[1],k+v_offset[2], n));
                         });
                 }
-
-            } // mfi
-            bndryMF.copyTo((*data_to_fill[ori])[lev], 0, n_offset, ncomp);
+            } // ib
           } // coordDir < 2
         } // ori
     } // var_name
+
+    // The raw data is released by the caller once the kernels have read it
+    Gpu::streamSynchronize();
 }
@@ -24,7 +24,9 @@ read_from_metgrid (int lev, const Box& domain, const std::string& fname,
                    IArrayBox& NC_lmask_iab,
                    Real& Latitude,
                    Real& Longitude,
-                   Geometry& geom)
+                   Geometry& geom,
+                   bool read_local,
+                   const Box& read_bx)
 {
     Print() << "Loading header data from NetCDF file at level " << lev << std::endl;
 
@@ -128,15 +130,29 @@ read_from_metgrid (int lev, const Box& domain, const std::string& fname,
     std::string Lat_var_name = "XLAT_V";
     std::string Lon_var_name = "XLONG_U";
     Print() << "Building initial FABS from file " << fname << std::endl;
-    BuildFABsFromNetCDFFile<FArrayBox,Real>(domain, Latitude, Longitude,
-                                            Lat_var_name, Lon_var_name,
-                                            fname, NC_fnames, NC_fdim_types, NC_fabs);
+    if (read_local) {
+        BuildFABsFromNetCDFFile<FArrayBox,Real>(domain, Latitude, Longitude,
+                                                Lat_var_name, Lon_var_name,
+                                                fname, NC_fnames, NC_fdim_types, NC_fabs,
+                                                read_bx);
+    } else {
+        BuildFABsFromNetCDFFile<FArrayBox,Real>(domain, Latitude, Longitude,
+                                                Lat_var_name, Lon_var_name,
+                                                fname, NC_fnames, NC_fdim_types, NC_fabs);
+    }
 
     // Read the netcdf file and fill these IABs
     Print() << "Building initial IABS from file " << fname << std::endl;
-    BuildFABsFromNetCDFFile<IArrayBox,int>(domain, Latitude, Longitude,
-                                           Lat_var_name, Lon_var_name,
-                                           fname, NC_inames, NC_idim_types, NC_iabs);
+    if (read_local) {
+        BuildFABsFromNetCDFFile<IArrayBox,int>(domain, Latitude, Longitude,
+                                               Lat_var_name, Lon_var_name,
+                                               fname, NC_inames, NC_idim_types, NC_iabs,
+                                               read_bx);
+    } else {
+        BuildFABsFromNetCDFFile<IArrayBox,int>(domain, Latitude, Longitude,
+                                               Lat_var_name, Lon_var_name,
+                                               fname, NC_inames, NC_idim_types, NC_iabs);
+    }
 
     // TODO: FIND OUT IF WE NEED TO DIVIDE VELS BY MAPFAC
     //
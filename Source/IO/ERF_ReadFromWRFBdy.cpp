@@ -528,15 +528,21 @@ read_from_wrfbdy (const std::string& nc_bdy_file, const Box& domain,
     return timeInterval;
 }
 
+/**
+ * Converts one time slice of the wrfbdy data on one side of the domain to the
+ * variables used by ERF. The first slice is replaced by the initial data from
+ * wrfinput; the others are decoupled from the column mass using MU from the
+ * slice itself.
+ */
 void
-convert_wrfbdy_data (const Box& domain, Vector<Vector<FArrayBox>>& bdy_data,
-                     const FArrayBox& NC_MUB_fab,
-                     const FArrayBox& NC_PH_fab, const FArrayBox& NC_PHB_fab,
-                     const FArrayBox& NC_C1H_fab, const FArrayBox& NC_C2H_fab,
-                     const FArrayBox& NC_RDNW_fab,
-                     const FArrayBox& NC_xvel_fab, const FArrayBox& NC_yvel_fab,
-                     const FArrayBox& NC_rho_fab, const FArrayBox& NC_rhotheta_fab,
-                     const FArrayBox& NC_QVAPOR_fab)
+convert_wrfbdy_slice (const Box& domain, Vector<FArrayBox>& bdy_slice, bool initial,
+                      const FArrayBox& NC_MUB_fab,
+                      const FArrayBox& NC_PH_fab, const FArrayBox& NC_PHB_fab,
+                      const FArrayBox& NC_C1H_fab, const FArrayBox& NC_C2H_fab,
+                      const FArrayBox& NC_RDNW_fab,
+                      const FArrayBox& NC_xvel_fab, const FArrayBox& NC_yvel_fab,
+                      const FArrayBox& NC_rho_fab, const FArrayBox& NC_rhotheta_fab,
+                      const FArrayBox& NC_QVAPOR_fab)
 {
     // These were filled from wrfinput
     Array4<Real const> c1h_arr  = NC_C1H_fab.const_array();
@@ -547,105 +553,122 @@ convert_wrfbdy_data (const Box& domain, Vector<Vector<FArrayBox>>& bdy_data,
     Array4<Real const>  ph_arr  = NC_PH_fab.const_array();
     Array4<Real const> phb_arr  = NC_PHB_fab.const_array();
 
+    Array4<Real> bdy_u_arr  = bdy_slice[WRFBdyVars::U].array();  // This is face-centered
+    Array4<Real> bdy_v_arr  = bdy_slice[WRFBdyVars::V].array();
+    Array4<Real> bdy_r_arr  = bdy_slice[WRFBdyVars::R].array();
+    Array4<Real> bdy_t_arr  = bdy_slice[WRFBdyVars::T].array();
+    Array4<Real> bdy_qv_arr = bdy_slice[WRFBdyVars::QV].array();
+    Array4<Real> mu_arr     = bdy_slice[WRFBdyVars::MU].array(); // This is cell-centered
+
+    int ilo  = domain.smallEnd()[0];
+    int ihi  = domain.bigEnd()[0];
+    int jlo  = domain.smallEnd()[1];
+    int jhi  = domain.bigEnd()[1];
+
+    if (initial) {
+        bdy_slice[WRFBdyVars::U].template copy<RunOn::Device>(NC_xvel_fab);
+        bdy_slice[WRFBdyVars::V].template copy<RunOn::Device>(NC_yvel_fab);
+        bdy_slice[WRFBdyVars::R].template copy<RunOn::Device>(NC_rho_fab);
+        bdy_slice[WRFBdyVars::T].template copy<RunOn::Device>(NC_rhotheta_fab);
+        bdy_slice[WRFBdyVars::QV].template copy<RunOn::Device>(NC_QVAPOR_fab);
+        bdy_slice[WRFBdyVars::QV].template mult<RunOn::Device>(NC_rho_fab);
+    } else {
+        // Define u velocity
+        const auto & bx_u  = bdy_slice[WRFBdyVars::U].box();
+        ParallelFor(bx_u, [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
+        {
+            Real xmu;
+            if (i == ilo) {
+                xmu  = mu_arr(i,j,0) + mub_arr(i,j,0);
+            } else if (i > ihi) {
+                xmu  = mu_arr(i-1,j,0) + mub_arr(i-1,j,0);
+            } else {
+                xmu = ( mu_arr(i,j,0) +  mu_arr(i-1,j,0)
+                       +mub_arr(i,j,0) + mub_arr(i-1,j,0)) * 0.5;
+            }
+            Real xmu_mult = c1h_arr(0,0,k) * xmu + c2h_arr(0,0,k);
+            Real new_bdy = bdy_u_arr(i,j,k) / xmu_mult;
+            bdy_u_arr(i,j,k) = new_bdy;
+        });
+
+        // Define v velocity
+        const auto & bx_v  = bdy_slice[WRFBdyVars::V].box();
+        ParallelFor(bx_v, [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
+        {
+            Real xmu;
+            if (j == jlo) {
+                xmu  = mu_arr(i,j,0) + mub_arr(i,j,0);
+            } else if (j > jhi) {
+                xmu  = mu_arr(i,j-1,0) + mub_arr(i,j-1,0);
+            } else {
+                xmu =  ( mu_arr(i,j,0) +  mu_arr(i,j-1,0)
+                        +mub_arr(i,j,0) + mub_arr(i,j-1,0) ) * 0.5;
+            }
+            Real xmu_mult = c1h_arr(0,0,k) * xmu + c2h_arr(0,0,k);
+            Real new_bdy = bdy_v_arr(i,j,k) / xmu_mult;
+            bdy_v_arr(i,j,k) = new_bdy;
+        });
+
+        // Define density
+        const auto & bx_t = bdy_slice[WRFBdyVars::T].box(); // Note this is currently "THM" aka the perturbational moist pot. temp.
+        ParallelFor(bx_t, [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
+        {
+            Real xmu  = c1h_arr(0,0,k) * (mu_arr(i,j,0) + mub_arr(i,j,0)) + c2h_arr(0,0,k);
+            Real dpht = (ph_arr(i,j,k+1) + phb_arr(i,j,k+1)) - (ph_arr(i,j,k) + phb_arr(i,j,k));
+            bdy_r_arr(i,j,k) = -xmu / ( dpht * rdnw_arr(0,0,k) );
+            //if (nt == 0 and std::abs(r_arr(i,j,k) - bdy_r_arr(i,j,k)) > 0.) {
+            //    Print() << "INIT VS BDY DEN " << IntVect(i,j,k) << " " << r_arr(i,j,k) << " " << bdy_r_arr(i,j,k) <<
+            //        " " << std::abs(r_arr(i,j,k) - bdy_r_arr(i,j,k)) << std::endl;
+            //}
+        });
+
+        // Define theta
+        Real theta_ref = 300.;
+        ParallelFor(bx_t, [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
+        {
+            Real xmu  = (mu_arr(i,j,0) + mub_arr(i,j,0));
+            Real xmu_mult = c1h_arr(0,0,k) * xmu + c2h_arr(0,0,k);
+            Real new_bdy_Th = bdy_t_arr(i,j,k) / xmu_mult + theta_ref;
+            Real qv_fac = (1. + bdy_qv_arr(i,j,k) / 0.622 / xmu_mult);
+            new_bdy_Th /= qv_fac;
+            bdy_t_arr(i,j,k) = new_bdy_Th * bdy_r_arr(i,j,k);
+            //if (nt == 0 and std::abs(rth_arr(i,j,k) - bdy_t_arr(i,j,k)) > 0.) {
+            //    Print() << "INIT VS BDY TH " << IntVect(i,j,k) << " " << rth_arr(i,j,k) << " " << bdy_t_arr(i,j,k) <<
+            //             " " << std::abs(th_arr(i,j,k) - bdy_t_arr(i,j,k)) << std::endl;
+            //}
+        });
+
+        // Define Qv
+        const auto & bx_qv = bdy_slice[WRFBdyVars::QV].box();
+        ParallelFor(bx_qv, [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
+        {
+            Real xmu  = (mu_arr(i,j,0) + mub_arr(i,j,0));
+            Real xmu_mult = c1h_arr(0,0,k) * xmu + c2h_arr(0,0,k);
+            Real new_bdy_QV = bdy_qv_arr(i,j,k) / xmu_mult;
+            bdy_qv_arr(i,j,k) = new_bdy_QV * bdy_r_arr(i,j,k);
+        });
+
+    } // initial
+}
+
+void
+convert_wrfbdy_data (const Box& domain, Vector<Vector<FArrayBox>>& bdy_data,
+                     const FArrayBox& NC_MUB_fab,
+                     const FArrayBox& NC_PH_fab, const FArrayBox& NC_PHB_fab,
+                     const FArrayBox& NC_C1H_fab, const FArrayBox& NC_C2H_fab,
+                     const FArrayBox& NC_RDNW_fab,
+                     const FArrayBox& NC_xvel_fab, const FArrayBox& NC_yvel_fab,
+                     const FArrayBox& NC_rho_fab, const FArrayBox& NC_rhotheta_fab,
+                     const FArrayBox& NC_QVAPOR_fab)
+{
     int ntimes = bdy_data.size();
     for (int nt = 0; nt < ntimes; nt++)
     {
-        Array4<Real> bdy_u_arr  = bdy_data[nt][WRFBdyVars::U].array();  // This is face-centered
-        Array4<Real> bdy_v_arr  = bdy_data[nt][WRFBdyVars::V].array();
-        Array4<Real> bdy_r_arr  = bdy_data[nt][WRFBdyVars::R].array();
-        Array4<Real> bdy_t_arr  = bdy_data[nt][WRFBdyVars::T].array();
-        Array4<Real> bdy_qv_arr = bdy_data[nt][WRFBdyVars::QV].array();
-        Array4<Real> mu_arr     = bdy_data[nt][WRFBdyVars::MU].array(); // This is cell-centered
-
-        int ilo  = domain.smallEnd()[0];
-        int ihi  = domain.bigEnd()[0];
-        int jlo  = domain.smallEnd()[1];
-        int jhi  = domain.bigEnd()[1];
-
-        if (nt==0) {
-            bdy_data[0][WRFBdyVars::U].template copy<RunOn::Device>(NC_xvel_fab);
-            bdy_data[0][WRFBdyVars::V].template copy<RunOn::Device>(NC_yvel_fab);
-            bdy_data[0][WRFBdyVars::R].template copy<RunOn::Device>(NC_rho_fab);
-            bdy_data[0][WRFBdyVars::T].template copy<RunOn::Device>(NC_rhotheta_fab);
-            bdy_data[0][WRFBdyVars::QV].template copy<RunOn::Device>(NC_QVAPOR_fab);
-            bdy_data[0][WRFBdyVars::QV].template mult<RunOn::Device>(NC_rho_fab);
-        } else {
-            // Define u velocity
-            const auto & bx_u  = bdy_data[0][WRFBdyVars::U].box();
-            ParallelFor(bx_u, [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
-            {
-                Real xmu;
-                if (i == ilo) {
-                    xmu  = mu_arr(i,j,0) + mub_arr(i,j,0);
-                } else if (i > ihi) {
-                    xmu  = mu_arr(i-1,j,0) + mub_arr(i-1,j,0);
-                } else {
-                    xmu = ( mu_arr(i,j,0) +  mu_arr(i-1,j,0)
-                           +mub_arr(i,j,0) + mub_arr(i-1,j,0)) * 0.5;
-                }
-                Real xmu_mult = c1h_arr(0,0,k) * xmu + c2h_arr(0,0,k);
-                Real new_bdy = bdy_u_arr(i,j,k) / xmu_mult;
-                bdy_u_arr(i,j,k) = new_bdy;
-            });
-
-            // Define v velocity
-            const auto & bx_v  = bdy_data[0][WRFBdyVars::V].box();
-            ParallelFor(bx_v, [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
-            {
-                Real xmu;
-                if (j == jlo) {
-                    xmu  = mu_arr(i,j,0) + mub_arr(i,j,0);
-                } else if (j > jhi) {
-                    xmu  = mu_arr(i,j-1,0) + mub_arr(i,j-1,0);
-                } else {
-                    xmu =  ( mu_arr(i,j,0) +  mu_arr(i,j-1,0)
-                            +mub_arr(i,j,0) + mub_arr(i,j-1,0) ) * 0.5;
-                }
-                Real xmu_mult = c1h_arr(0,0,k) * xmu + c2h_arr(0,0,k);
-                Real new_bdy = bdy_v_arr(i,j,k) / xmu_mult;
-                bdy_v_arr(i,j,k) = new_bdy;
-            });
-
-            // Define density
-            const auto & bx_t = bdy_data[0][WRFBdyVars::T].box(); // Note this is currently "THM" aka the perturbational moist pot. temp.
-            ParallelFor(bx_t, [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
-            {
-                Real xmu  = c1h_arr(0,0,k) * (mu_arr(i,j,0) + mub_arr(i,j,0)) + c2h_arr(0,0,k);
-                Real dpht = (ph_arr(i,j,k+1) + phb_arr(i,j,k+1)) - (ph_arr(i,j,k) + phb_arr(i,j,k));
-                bdy_r_arr(i,j,k) = -xmu / ( dpht * rdnw_arr(0,0,k) );
-                //if (nt == 0 and std::abs(r_arr(i,j,k) - bdy_r_arr(i,j,k)) > 0.) {
-                //    Print() << "INIT VS BDY DEN " << IntVect(i,j,k) << " " << r_arr(i,j,k) << " " << bdy_r_arr(i,j,k) <<
-                //        " " << std::abs(r_arr(i,j,k) - bdy_r_arr(i,j,k)) << std::endl;
-                //}
-            });
-
-            // Define theta
-            Real theta_ref = 300.;
-            ParallelFor(bx_t, [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
-            {
-                Real xmu  = (mu_arr(i,j,0) + mub_arr(i,j,0));
-                Real xmu_mult = c1h_arr(0,0,k) * xmu + c2h_arr(0,0,k);
-                Real new_bdy_Th = bdy_t_arr(i,j,k) / xmu_mult + theta_ref;
-                Real qv_fac = (1. + bdy_qv_arr(i,j,k) / 0.622 / xmu_mult);
-                new_bdy_Th /= qv_fac;
-                bdy_t_arr(i,j,k) = new_bdy_Th * bdy_r_arr(i,j,k);
-                //if (nt == 0 and std::abs(rth_arr(i,j,k) - bdy_t_arr(i,j,k)) > 0.) {
-                //    Print() << "INIT VS BDY TH " << IntVect(i,j,k) << " " << rth_arr(i,j,k) << " " << bdy_t_arr(i,j,k) <<
-                //             " " << std::abs(th_arr(i,j,k) - bdy_t_arr(i,j,k)) << std::endl;
-                //}
-            });
-
-            // Define Qv
-            const auto & bx_qv = bdy_data[0][WRFBdyVars::QV].box();
-            ParallelFor(bx_qv, [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
-            {
-                Real xmu  = (mu_arr(i,j,0) + mub_arr(i,j,0));
-                Real xmu_mult = c1h_arr(0,0,k) * xmu + c2h_arr(0,0,k);
-                Real new_bdy_QV = bdy_qv_arr(i,j,k) / xmu_mult;
-                bdy_qv_arr(i,j,k) = new_bdy_QV * bdy_r_arr(i,j,k);
-            });
-
-        } // nt ==0
+        convert_wrfbdy_slice(domain, bdy_data[nt], (nt == 0),
+                             NC_MUB_fab, NC_PH_fab, NC_PHB_fab,
+                             NC_C1H_fab, NC_C2H_fab, NC_RDNW_fab,
+                             NC_xvel_fab, NC_yvel_fab,
+                             NC_rho_fab, NC_rhotheta_fab, NC_QVAPOR_fab);
     } // ntimes
 }
 #endif // ERF_USE_NETCDF
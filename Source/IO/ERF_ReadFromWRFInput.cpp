@@ -31,7 +31,9 @@ read_from_wrfinput (int lev,
                     MoistureType moisture_type,
                     Real& Latitude,
                     Real& Longitude,
-                    Geometry& geom)
+                    Geometry& geom,
+                    bool read_local,
+                    const Box& read_bx)
 {
     Print() << "Loading header data from NetCDF file at level " << lev << std::endl;
 
@@ -118,9 +120,16 @@ read_from_wrfinput (int lev,
     std::string Lat_var_name = "XLAT_V";
     std::string Lon_var_name = "XLONG_U";
     Print() << "Building initial FABS from file " << fname << std::endl;
-    BuildFABsFromNetCDFFile<FArrayBox,Real>(domain, Latitude, Longitude,
-                                            Lat_var_name, Lon_var_name,
-                                            fname, NC_names, NC_dim_types, NC_fabs);
+    if (read_local) {
+        BuildFABsFromNetCDFFile<FArrayBox,Real>(domain, Latitude, Longitude,
+                                                Lat_var_name, Lon_var_name,
+                                                fname, NC_names, NC_dim_types, NC_fabs,
+                                                read_bx);
+    } else {
+        BuildFABsFromNetCDFFile<FArrayBox,Real>(domain, Latitude, Longitude,
+                                                Lat_var_name, Lon_var_name,
+                                                fname, NC_names, NC_dim_types, NC_fabs);
+    }
 
 
     //
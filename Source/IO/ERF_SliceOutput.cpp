@@ -0,0 +1,368 @@
+#include "AMReX_Gpu.H"
+#include "AMReX_ParmParse.H"
+#include "AMReX_Utility.H"
+#include "ERF_SliceOutput.H"
+#include "ERF_SampleVars.H"
+#include "ERF_IndexDefines.H"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+
+using namespace amrex;
+
+namespace {
+    template <typename T>
+    void put_raw (Vector<char>& out, const T& v)
+    {
+        const char* p = reinterpret_cast<const char*>(&v);
+        out.insert(out.end(), p, p+sizeof(T));
+    }
+
+    template <typename T>
+    bool get_raw (std::istream& is, T& v)
+    {
+        return static_cast<bool>(is.read(reinterpret_cast<char*>(&v), sizeof(T)));
+    }
+}
+
+/**
+ * Constructor for the SliceOutput class, which reads the slice definitions from the inputs file
+ *
+ * @param geom Vector of Geometry containing the geometry at each level in the AMR
+ * @param cons_names Names of the conserved variables, as used in plotfiles
+ * @param ncons Number of conserved variables in the state
+ */
+SliceOutput::SliceOutput (Vector<Geometry>& geom,
+                          const Vector<std::string>& cons_names,
+                          int ncons) : m_geom(geom)
+{
+    ParmParse pp("erf");
+
+    pp.query("slice_dir", m_dir);
+
+    Vector<std::string> names;
+    pp.queryarr("slice_names", names);
+
+    for (const auto& name : names)
+    {
+        ParmParse pps("erf.slice." + name);
+
+        Slice s;
+        s.name = name;
+
+        if (pps.contains("normal")) {
+            pps.get("normal", s.normal);
+            pps.get("location", s.location);
+            if (s.normal < 0 || s.normal >= AMREX_SPACEDIM) {
+                Abort("SliceOutput: normal must be 0, 1 or 2 for slice " + name);
+            }
+        } else {
+            pps.getarr("lo", s.lo, 0, AMREX_SPACEDIM);
+            pps.getarr("hi", s.hi, 0, AMREX_SPACEDIM);
+        }
+
+        pps.query("level", s.level);
+        pps.query("interval", s.interval);
+        pps.query("per", s.per);
+        if (s.interval <= 0 && s.per <= 0.) {
+            Abort("SliceOutput: slice " + name + " needs a positive interval or per");
+        }
+
+        s.var_names = {"x_velocity", "y_velocity", "z_velocity", "theta"};
+        if (pps.contains("vars")) {
+            int nvars = pps.countval("vars");
+            s.var_names.resize(nvars);
+            pps.queryarr("vars", s.var_names, 0, nvars);
+        }
+
+        SampleVars::map_names(s.var_names, cons_names, ncons, s.var_type, s.var_comp,
+                              "slice " + name);
+
+        if (ParallelDescriptor::IOProcessor()) {
+            const std::string slice_dir = m_dir + "/" + name;
+            if (!UtilCreateDirectory(slice_dir, 0755)) {
+                CreateDirectoryFailed(slice_dir);
+            }
+            write_header(s);
+        }
+
+        m_slice.push_back(std::move(s));
+    }
+
+    ParallelDescriptor::Barrier();
+}
+
+/**
+ * Drops the records written after a given step by an earlier run, so that a restarted
+ * run continues each time series without duplicated records
+ *
+ * @param t_step Last step to keep, or -1 to remove every record
+ */
+void
+SliceOutput::truncate (int t_step)
+{
+    BL_PROFILE("ERF::SliceOutput::truncate");
+
+    const int nprocs = ParallelDescriptor::NProcs();
+    const int myproc = ParallelDescriptor::MyProc();
+
+    for (const auto& s : m_slice)
+    {
+        const std::string slice_dir = m_dir + "/" + s.name;
+        const Long nvars = static_cast<Long>(s.var_names.size());
+
+        // The data files were written by the ranks of the earlier run, whose number may differ
+        Vector<std::string> data_names;
+        for (const auto& entry : std::filesystem::directory_iterator(slice_dir)) {
+            if (entry.path().filename().string().rfind("data_", 0) == 0) {
+                data_names.push_back(entry.path().string());
+            }
+        }
+        std::sort(data_names.begin(), data_names.end());
+
+        for (int f = myproc; f < static_cast<int>(data_names.size()); f += nprocs)
+        {
+            const auto fsize = static_cast<std::streamoff>(std::filesystem::file_size(data_names[f]));
+
+            // Keep every complete record up to and including t_step
+            std::streamoff keep = 0;
+            {
+                std::ifstream is(data_names[f].c_str(), std::ios::in | std::ios::binary);
+                int step, lev, nboxes;
+                Real time;
+                while (get_raw(is, step) && get_raw(is, time) && get_raw(is, lev) && get_raw(is, nboxes))
+                {
+                    if (step > t_step) break;
+                    bool complete = true;
+                    for (int b = 0; b < nboxes && complete; ++b) {
+                        int lohi[2*AMREX_SPACEDIM];
+                        complete = static_cast<bool>(is.read(reinterpret_cast<char*>(lohi), sizeof(lohi)));
+                        Long npts = 1;
+                        for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                            npts *= lohi[AMREX_SPACEDIM+d] - lohi[d] + 1;
+                        }
+                        is.seekg(static_cast<std::streamoff>(npts*nvars*sizeof(Real)), std::ios::cur);
+                    }
+                    const std::streamoff pos = is.tellg();
+                    if (!complete || pos < 0 || pos > fsize) break;
+                    keep = pos;
+                }
+            }
+            if (keep < fsize) {
+                std::filesystem::resize_file(data_names[f], static_cast<std::uintmax_t>(keep));
+            }
+        }
+
+        if (ParallelDescriptor::IOProcessor())
+        {
+            const std::string time_name = slice_dir + "/time.dat";
+            std::string kept;
+            {
+                std::ifstream is(time_name.c_str());
+                std::string line;
+                while (std::getline(is, line)) {
+                    std::istringstream ls(line);
+                    int step;
+                    if (ls >> step && step <= t_step) {
+                        kept += line + "\n";
+                    }
+                }
+            }
+            std::ofstream time_file(time_name.c_str(), std::ios::out | std::ios::trunc);
+            time_file << kept;
+        }
+    }
+
+    ParallelDescriptor::Barrier();
+}
+
+/**
+ * Returns the index space box of a slice at a given level
+ *
+ * @param s Slice definition
+ * @param lev Level at which we want the box
+ */
+Box
+SliceOutput::slice_box (const Slice& s, int lev) const
+{
+    const Box& domain = m_geom[lev].Domain();
+    const Real* plo   = m_geom[lev].ProbLo();
+    auto const dxi    = m_geom[lev].InvCellSizeArray();
+
+    Box bx(domain);
+    if (s.normal >= 0) {
+        // The plane is the layer of cells containing the requested location
+        const int d = s.normal;
+        int i = static_cast<int>(std::floor((s.location - plo[d]) * dxi[d]));
+        i = std::max(domain.smallEnd(d), std::min(i, domain.bigEnd(d)));
+        bx.setSmall(d,i);
+        bx.setBig(d,i);
+    } else {
+        // The smallest box that contains all of the cell centers in the region
+        for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+            int ilo = static_cast<int>(std::floor((s.lo[d] - plo[d]) * dxi[d] + 0.5));
+            int ihi = static_cast<int>(std::floor((s.hi[d] - plo[d]) * dxi[d] + 0.5)) - 1;
+            bx.setSmall(d,ilo);
+            bx.setBig(d,ihi);
+        }
+        bx &= domain;
+    }
+    return bx;
+}
+
+/**
+ * Returns the level at which a slice is sampled: the requested level if one was given,
+ * otherwise the finest level whose grids cover the whole slice
+ *
+ * @param s Slice definition
+ * @param vars_new Grid data for all variables across the AMR hierarchy
+ * @param finest_level Current finest level
+ */
+int
+SliceOutput::slice_level (const Slice& s,
+                          const Vector<Vector<MultiFab>>& vars_new,
+                          int finest_level) const
+{
+    if (s.level >= 0) {
+        return std::min(s.level, finest_level);
+    }
+    for (int lev = finest_level; lev > 0; --lev) {
+        if (vars_new[lev][Vars::cons].boxArray().contains(slice_box(s,lev))) {
+            return lev;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Writes the Header describing a slice time series
+ *
+ * @param s Slice definition
+ */
+void
+SliceOutput::write_header (const Slice& s) const
+{
+    const std::string header_name = m_dir + "/" + s.name + "/Header";
+    std::ofstream header(header_name.c_str(), std::ofstream::out | std::ofstream::trunc);
+    if (!header.good()) {
+        FileOpenFailed(header_name);
+    }
+
+    header.precision(17);
+    header << "ERF-Slice-V1\n";
+    header << s.name << "\n";
+    header << s.var_names.size() << "\n";
+    for (const auto& v : s.var_names) {
+        header << v << "\n";
+    }
+    header << m_geom.size() << "\n";
+    for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+        header << m_geom[0].ProbLo(d) << " ";
+    }
+    header << "\n";
+    for (int lev = 0; lev < static_cast<int>(m_geom.size()); ++lev) {
+        header << m_geom[lev].Domain() << " ";
+        for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+            header << m_geom[lev].CellSize(d) << " ";
+        }
+        header << "\n";
+    }
+    header << sizeof(Real) << "\n";
+}
+
+/**
+ * Appends the part of a slice owned by this rank to the rank's data file
+ *
+ * @param n Index of the slice
+ * @param t_step Timestep number
+ * @param time Current time
+ * @param vars_new Grid data for all variables across the AMR hierarchy
+ * @param finest_level Current finest level
+ */
+void
+SliceOutput::write (int n, int t_step, Real time,
+                    const Vector<Vector<MultiFab>>& vars_new,
+                    int finest_level)
+{
+    BL_PROFILE("ERF::SliceOutput::write");
+
+    Slice& s = m_slice[n];
+
+    const int lev   = slice_level(s, vars_new, finest_level);
+    const Box sbx   = slice_box(s, lev);
+    const int nvars = static_cast<int>(s.var_names.size());
+
+    const MultiFab& S    = vars_new[lev][Vars::cons];
+    const MultiFab& xvel = vars_new[lev][Vars::xvel];
+    const MultiFab& yvel = vars_new[lev][Vars::yvel];
+    const MultiFab& zvel = vars_new[lev][Vars::zvel];
+
+    Vector<char> buffer;
+    put_raw<int>(buffer, t_step);
+    put_raw<Real>(buffer, time);
+    put_raw<int>(buffer, lev);
+    const std::size_t nboxes_offset = buffer.size();
+    put_raw<int>(buffer, 0);
+
+    int nboxes = 0;
+    for (MFIter mfi(S); mfi.isValid(); ++mfi)
+    {
+        const Box bx = mfi.validbox() & sbx;
+        if (!bx.ok()) continue;
+
+        auto const& cons = S.const_array(mfi);
+        auto const& u    = xvel.const_array(mfi);
+        auto const& v    = yvel.const_array(mfi);
+        auto const& w    = zvel.const_array(mfi);
+
+        FArrayBox tmp(bx, nvars, The_Async_Arena());
+        for (int nv = 0; nv < nvars; ++nv)
+        {
+            auto const& out = tmp.array(nv);
+            const int   c   = s.var_comp[nv];
+            const auto  t   = s.var_type[nv];
+            ParallelFor(bx, [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
+            {
+                out(i,j,k) = SampleVars::cc_value(t, c, i, j, k, cons, u, v, w);
+            });
+        }
+
+        for (int d = 0; d < AMREX_SPACEDIM; ++d) put_raw<int>(buffer, bx.smallEnd(d));
+        for (int d = 0; d < AMREX_SPACEDIM; ++d) put_raw<int>(buffer, bx.bigEnd(d));
+
+        const std::size_t offset = buffer.size();
+        buffer.resize(offset + tmp.nBytes());
+        Gpu::dtoh_memcpy(buffer.data() + offset, tmp.dataPtr(), tmp.nBytes());
+
+        ++nboxes;
+    }
+
+    // Ranks that own no part of the slice write nothing
+    if (nboxes > 0)
+    {
+        std::memcpy(buffer.data() + nboxes_offset, &nboxes, sizeof(int));
+
+        if (!s.data_file) {
+            const std::string data_name = Concatenate(m_dir + "/" + s.name + "/data_",
+                                                      ParallelDescriptor::MyProc(), 5);
+            s.data_file = std::make_unique<std::ofstream>(data_name.c_str(),
+                                                          std::ios::out | std::ios::app | std::ios::binary);
+            if (!s.data_file->good()) {
+                FileOpenFailed(data_name);
+            }
+        }
+        s.data_file->write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        s.data_file->flush();
+    }
+
+    if (ParallelDescriptor::IOProcessor())
+    {
+        const std::string time_name = m_dir + "/" + s.name + "/time.dat";
+        std::ofstream time_file(time_name.c_str(), std::ios::out | std::ios::app);
+        time_file.precision(17);
+        time_file << t_step << " " << time << " " << lev << "\n";
+    }
+}
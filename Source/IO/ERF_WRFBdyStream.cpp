@@ -0,0 +1,568 @@
+#include "ERF_WRFBdyStream.H"
+#include "ERF_NCWpsFile.H"
+#include "ERF_NCInterface.H"
+#include "ERF_IndexDefines.H"
+
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <numeric>
+
+using namespace amrex;
+
+void
+read_from_wrfinput (int lev, const Box& domain, const std::string& fname,
+                    FArrayBox& NC_xvel_fab, FArrayBox& NC_yvel_fab,
+                    FArrayBox& NC_zvel_fab, FArrayBox& NC_rho_fab,
+                    FArrayBox& NC_rhop_fab, FArrayBox& NC_rhotheta_fab,
+                    FArrayBox& NC_MUB_fab ,
+                    FArrayBox& NC_MSFU_fab, FArrayBox& NC_MSFV_fab,
+                    FArrayBox& NC_MSFM_fab, FArrayBox& NC_SST_fab,
+                    FArrayBox& NC_LANDMSK_fab,
+                    FArrayBox& NC_C1H_fab , FArrayBox& NC_C2H_fab,
+                    FArrayBox& NC_RDNW_fab,
+                    FArrayBox& NC_QVAPOR_fab,
+                    FArrayBox& NC_QCLOUD_fab,
+                    FArrayBox& NC_QRAIN_fab,
+                    FArrayBox& NC_PH_fab,
+                    FArrayBox& NC_P_fab,
+                    FArrayBox& NC_PHB_fab,
+                    FArrayBox& NC_ALB_fab,
+                    FArrayBox& NC_PB_fab,
+                    FArrayBox& NC_LAT_fab,
+                    FArrayBox& NC_LON_fab,
+                    MoistureType moisture_type,
+                    Real& Latitude,
+                    Real& Longitude,
+                    Geometry& geom,
+                    bool read_local,
+                    const Box& read_bx);
+
+void
+convert_wrfbdy_slice (const Box& domain, Vector<FArrayBox>& bdy_slice, bool initial,
+                      const FArrayBox& NC_MUB_fab,
+                      const FArrayBox& NC_PH_fab, const FArrayBox& NC_PHB_fab,
+                      const FArrayBox& NC_C1H_fab, const FArrayBox& NC_C2H_fab,
+                      const FArrayBox& NC_RDNW_fab,
+                      const FArrayBox& NC_xvel_fab, const FArrayBox& NC_yvel_fab,
+                      const FArrayBox& NC_rho_fab, const FArrayBox& NC_rhotheta_fab,
+                      const FArrayBox& NC_QVAPOR_fab);
+
+namespace {
+    // NOTE: the order of these must match the WRFBdyVars enum
+    const Vector<std::string> bdy_var_prefix = {"U","V","R","T","QVAPOR","MU","PC"};
+    const Vector<std::string> bdy_side_suffix = {"_BXS","_BXE","_BYS","_BYE"};
+}
+
+/**
+ * Constructor for the streaming wrfbdy provider
+ *
+ * @param bdy_file Name of the wrfbdy file
+ * @param init_file Name of the level 0 wrfinput file
+ * @param geom Level 0 geometry
+ * @param moisture_type Moisture model, as needed to read wrfinput
+ */
+WRFBdyStream::WRFBdyStream (const std::string& bdy_file,
+                            const std::string& init_file,
+                            Geometry& geom,
+                            MoistureType moisture_type)
+    : m_bdy_file(bdy_file), m_domain(geom.Domain())
+{
+    Print() << "Streaming boundary data from NetCDF file " << m_bdy_file << std::endl;
+
+    const int ioproc = ParallelDescriptor::IOProcessorNumber();
+
+    if (ParallelDescriptor::IOProcessor())
+    {
+        auto ncf = ncutils::NCFile::open(m_bdy_file, NC_NOWRITE);
+
+        // Read the time stamps
+        auto times = ncf.var("Times");
+        std::vector<size_t> shape = times.shape();
+        m_ntimes = static_cast<int>(shape[0]);
+        const int str_len = static_cast<int>(shape[1]);
+        std::vector<char> stamps(shape[0]*shape[1]);
+        times.get(stamps.data(), {0,0}, shape);
+
+        const std::string dateTimeFormat ="%Y-%m-%d_%H:%M:%S";
+        Vector<std::time_t> epochTimes;
+        for (int nt = 0; nt < m_ntimes; ++nt) {
+            std::string date(&stamps[nt*str_len], &stamps[nt*str_len] + str_len);
+            epochTimes.push_back(getEpochTime(date, dateTimeFormat));
+            if (nt == 1) {
+                m_interval = static_cast<Real>(epochTimes[1] - epochTimes[0]);
+            } else if (nt > 1) {
+                AMREX_ALWAYS_ASSERT(epochTimes[nt] - epochTimes[nt-1] == m_interval);
+            }
+        }
+        m_start_time = static_cast<Real>(epochTimes[0]);
+
+        // Width of the boundary region
+        m_width = static_cast<int>(ncf.var("U_BXS").shape()[1]);
+        AMREX_ALWAYS_ASSERT(1 <= m_width && m_width <= 5);
+
+        ncf.close();
+
+        // The initial fields on each side, with one extra cell inward for the face data
+        FArrayBox zvel, rhop, msfu, msfv, msfm, sst, lmsk, qc, qr, p, alb, pb, lat, lon;
+        Real lat_ref, lon_ref;
+        for (int side = 0; side < 4; ++side)
+        {
+            const int dir = side / 2;
+            Box strip(m_domain);
+            if (side % 2 == 0) {
+                strip.setBig(dir, m_domain.smallEnd(dir) + m_width);
+            } else {
+                strip.setSmall(dir, m_domain.bigEnd(dir) - m_width);
+            }
+
+            InitStrip& s = m_init[side];
+            read_from_wrfinput(0, m_domain, init_file,
+                               s.xvel, s.yvel, zvel, s.rho, rhop, s.rhoth, s.mub,
+                               msfu, msfv, msfm, sst, lmsk, s.c1h, s.c2h, s.rdnw,
+                               s.qv, qc, qr, s.ph, p, s.phb, alb, pb, lat, lon,
+                               moisture_type, lat_ref, lon_ref, geom,
+                               true, strip);
+        }
+    }
+
+    ParallelDescriptor::Bcast(&m_ntimes,1,ioproc);
+    ParallelDescriptor::Bcast(&m_width,1,ioproc);
+    ParallelDescriptor::Bcast(&m_start_time,1,ioproc);
+    ParallelDescriptor::Bcast(&m_interval,1,ioproc);
+
+#ifdef AMREX_USE_MPI
+    // Our own communicator so the boundary messages cannot match anyone else's
+    MPI_Comm_dup(ParallelDescriptor::Communicator(), &m_comm);
+#endif
+}
+
+WRFBdyStream::~WRFBdyStream ()
+{
+    for (auto& [nt, rd] : m_read) {
+        rd.wait();
+    }
+#ifdef AMREX_USE_MPI
+    for (auto& [nt, reqs] : m_req) {
+        MPI_Waitall(static_cast<int>(reqs.size()), reqs.data(), MPI_STATUSES_IGNORE);
+    }
+    if (m_comm != MPI_COMM_NULL) {
+        MPI_Comm_free(&m_comm);
+    }
+#endif
+}
+
+/**
+ * Returns the box of boundary variable ivar on a side, matching read_from_wrfbdy
+ *
+ * @param side Side of the domain (xlo, xhi, ylo, yhi)
+ * @param ivar Boundary variable (WRFBdyVars)
+ */
+Box
+WRFBdyStream::var_box (int side, int ivar) const
+{
+    const auto& lo = m_domain.loVect();
+    const auto& hi = m_domain.hiVect();
+    const int dir  = side / 2;
+
+    Box pbx(m_domain);
+    if (side % 2 == 0) {
+        pbx.setBig(dir, lo[dir]+m_width-1);
+    } else {
+        pbx.setSmall(dir, hi[dir]-m_width+1);
+    }
+
+    if (ivar == WRFBdyVars::MU || ivar == WRFBdyVars::PC) {
+        Box line(pbx);
+        line.setRange(2, 0);
+        return line;
+    }
+
+    const int stag = (ivar == WRFBdyVars::U) ? 0 : ((ivar == WRFBdyVars::V) ? 1 : -1);
+    if (stag < 0) {
+        return pbx;
+    } else if (stag == dir) {
+        pbx.shiftHalf(dir, (side % 2 == 0) ? -1 : 1);
+        return pbx;
+    } else {
+        return convert(pbx, IntVect::TheDimensionVector(stag));
+    }
+}
+
+/**
+ * Decides which sides this rank holds: those whose relaxation zone, including the
+ * exterior ghost cells, intersects one of the rank's level 0 boxes grown by its ghost cells
+ *
+ * @param cons Level 0 conserved state
+ */
+void
+WRFBdyStream::set_held_sides (const MultiFab& cons)
+{
+    m_ba = cons.boxArray();
+    m_dm = cons.DistributionMap();
+
+    IntVect ng = cons.nGrowVect() + IntVect(1);
+    ng[2] = 0;
+
+    int flags = 0;
+    for (int side = 0; side < 4; ++side)
+    {
+        const int dir = side / 2;
+        Box band(m_domain);
+        if (side % 2 == 0) {
+            band.setBig(dir, m_domain.smallEnd(dir) + m_width);
+        } else {
+            band.setSmall(dir, m_domain.bigEnd(dir) - m_width);
+        }
+        band.grow(ng);
+
+        // The IO rank reads every side anyway
+        bool held = ParallelDescriptor::IOProcessor();
+        for (MFIter mfi(cons); mfi.isValid() && !held; ++mfi) {
+            held = grow(mfi.validbox(), ng).intersects(band);
+        }
+        m_held[side] = held;
+        if (held) flags |= (1 << side);
+    }
+
+    const int nprocs = ParallelDescriptor::NProcs();
+    const int ioproc = ParallelDescriptor::IOProcessorNumber();
+    Vector<int> all_flags(nprocs, 0);
+    ParallelDescriptor::Gather(&flags, 1, all_flags.data(), 1, ioproc);
+
+    for (int side = 0; side < 4; ++side) {
+        m_holders[side].clear();
+        if (ParallelDescriptor::IOProcessor()) {
+            for (int rank = 0; rank < nprocs; ++rank) {
+                if (rank != ioproc && (all_flags[rank] & (1 << side))) {
+                    m_holders[side].push_back(rank);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Allocates slice nt on the held sides. On the IO rank a worker thread starts reading
+ * and converting it; elsewhere its receive is posted.
+ *
+ * @param nt Index of the time slice
+ */
+void
+WRFBdyStream::post_slice (int nt)
+{
+    BL_PROFILE("ERF::WRFBdyStream::post_slice");
+
+    auto& buf = m_buf[nt];
+    for (int side = 0; side < 4; ++side) {
+        if (!m_held[side]) continue;
+        Long npts = 0;
+        for (int ivar = 0; ivar < WRFBdyVars::NumTypes; ++ivar) {
+            npts += var_box(side,ivar).numPts();
+        }
+        buf[side].resize(npts);
+    }
+
+    if (ParallelDescriptor::IOProcessor())
+    {
+        // The worker only touches the buffers of this slice, which stay put until it is joined
+        std::array<Real*,4> dst;
+        for (int side = 0; side < 4; ++side) {
+            dst[side] = buf[side].data();
+        }
+        m_read[nt] = std::async(std::launch::async, [this, nt, dst] () { read_slice(nt, dst); });
+    }
+#ifdef AMREX_USE_MPI
+    else
+    {
+        const int ioproc = ParallelDescriptor::IOProcessorNumber();
+        MPI_Datatype mpi_real = ParallelDescriptor::Mpi_typemap<Real>::type();
+        auto& reqs = m_req[nt];
+        for (int side = 0; side < 4; ++side) {
+            if (!m_held[side]) continue;
+            reqs.emplace_back();
+            MPI_Irecv(buf[side].data(), static_cast<int>(buf[side].size()), mpi_real,
+                      ioproc, side, m_comm, &reqs.back());
+        }
+    }
+#endif
+}
+
+/**
+ * Reads slice nt of every side from the wrfbdy file into the packed buffers, reordered
+ * to the layout of the FABs. Without GPUs it is also converted to ERF variables here.
+ * This runs on a worker thread of the IO rank and makes no MPI calls.
+ *
+ * @param nt Index of the time slice
+ * @param dst Packed buffer of each side
+ */
+void
+WRFBdyStream::read_slice (int nt, std::array<Real*,4> dst) const
+{
+    auto ncf = ncutils::NCFile::open(m_bdy_file, NC_NOWRITE);
+
+    for (int side = 0; side < 4; ++side)
+    {
+        const int  dir = side / 2;
+        const int  sgn = (side % 2 == 0) ? 1 : -1;
+
+        Real* p = dst[side];
+        for (int ivar = 0; ivar < WRFBdyVars::NumTypes; ++ivar)
+        {
+            const Box bx = var_box(side,ivar);
+            FArrayBox fab(bx, 1, p);
+            p += bx.numPts();
+
+            auto var = ncf.var(bdy_var_prefix[ivar] + bdy_side_suffix[side]);
+            std::vector<size_t> count = var.shape();
+            std::vector<size_t> start(count.size(), 0);
+            start[0] = nt;
+            count[0] = 1;
+
+            std::vector<float> data(std::accumulate(count.begin(), count.end(),
+                                                    std::size_t(1), std::multiplies<>()));
+            var.get(data.data(), start, count);
+
+            // The file is ordered (width, bottom_top, along the side), counted inward
+            const int ns2 = static_cast<int>(count[2]);
+            const int ns3 = (count.size() > 3) ? static_cast<int>(count[3]) : 1;
+            const int off = (sgn > 0) ? bx.smallEnd(dir) : bx.bigEnd(dir);
+            const Long num_pts = bx.numPts();
+            Array4<Real> fab_arr = fab.array();
+            for (Long n = 0; n < num_pts; ++n) {
+                int m, k, l;
+                if (count.size() > 3) {
+                    m = static_cast<int>(n / (ns2 * ns3));
+                    k = static_cast<int>((n - m * (ns2 * ns3)) / ns3);
+                    l = static_cast<int>(n - m * (ns2 * ns3) - k * ns3);
+                } else {
+                    m = static_cast<int>(n / ns2);
+                    k = 0;
+                    l = static_cast<int>(n - m * ns2);
+                }
+                if (dir == 0) {
+                    fab_arr(off+sgn*m, l, k, 0) = static_cast<Real>(data[n]);
+                } else {
+                    fab_arr(l, off+sgn*m, k, 0) = static_cast<Real>(data[n]);
+                }
+            }
+        }
+#ifndef AMREX_USE_GPU
+        convert_slice(nt, side, dst[side]);
+#endif
+    }
+    ncf.close();
+}
+
+/**
+ * Converts the data of slice nt on one side, read from the file, to ERF variables
+ *
+ * @param nt Index of the time slice
+ * @param side Side of the domain
+ * @param p Packed buffer of the side
+ */
+void
+WRFBdyStream::convert_slice (int nt, int side, Real* p) const
+{
+    Vector<FArrayBox> slice;
+    for (int ivar = 0; ivar < WRFBdyVars::NumTypes; ++ivar) {
+        const Box bx = var_box(side,ivar);
+        slice.emplace_back(bx, 1, p);
+        p += bx.numPts();
+    }
+
+    const InitStrip& s = m_init[side];
+    convert_wrfbdy_slice(m_domain, slice, (nt == 0),
+                         s.mub, s.ph, s.phb, s.c1h, s.c2h, s.rdnw,
+                         s.xvel, s.yvel, s.rho, s.rhoth, s.qv);
+}
+
+/**
+ * On the IO rank, joins the worker reading slice nt, if it is still outstanding, and
+ * starts sending the slice to the other holders
+ *
+ * @param nt Index of the time slice
+ */
+void
+WRFBdyStream::send_slice (int nt)
+{
+    auto it = m_read.find(nt);
+    if (it == m_read.end()) return;
+
+    BL_PROFILE("ERF::WRFBdyStream::send_slice");
+
+    it->second.get();
+    m_read.erase(it);
+
+    auto& buf = m_buf.at(nt);
+#ifdef AMREX_USE_GPU
+    // The conversion launches kernels, so it stays on this thread
+    for (int side = 0; side < 4; ++side) {
+        convert_slice(nt, side, buf[side].data());
+    }
+    Gpu::streamSynchronize();
+#endif
+
+#ifdef AMREX_USE_MPI
+    MPI_Datatype mpi_real = ParallelDescriptor::Mpi_typemap<Real>::type();
+    auto& reqs = m_req[nt];
+    for (int side = 0; side < 4; ++side) {
+        // Messages between a pair of ranks with the same tag arrive in the order they were posted
+        for (int rank : m_holders[side]) {
+            reqs.emplace_back();
+            MPI_Isend(buf[side].data(), static_cast<int>(buf[side].size()), mpi_real,
+                      rank, side, m_comm, &reqs.back());
+        }
+    }
+#else
+    amrex::ignore_unused(buf);
+#endif
+}
+
+/**
+ * Joins the worker reading the next slice, if any, and starts sending it. NetCDF is not
+ * thread-safe, so this must be called before any other NetCDF I/O on the IO rank.
+ */
+void
+WRFBdyStream::finish_reads ()
+{
+    while (!m_read.empty()) {
+        send_slice(m_read.begin()->first);
+    }
+}
+
+/**
+ * Completes the read and the messages of slice nt
+ *
+ * @param nt Index of the time slice
+ */
+void
+WRFBdyStream::wait_slice (int nt)
+{
+    send_slice(nt);
+#ifdef AMREX_USE_MPI
+    auto it = m_req.find(nt);
+    if (it != m_req.end()) {
+        BL_PROFILE("ERF::WRFBdyStream::wait_slice");
+        MPI_Waitall(static_cast<int>(it->second.size()), it->second.data(), MPI_STATUSES_IGNORE);
+        m_req.erase(it);
+    }
+#endif
+}
+
+/**
+ * Makes the FABs of slice nt alias the held buffers, or their device copies with GPUs
+ *
+ * @param nt Index of the time slice
+ * @param bdy Boundary data containers for the four sides
+ */
+void
+WRFBdyStream::expose_slice (int nt, std::array<BdyData*,4>& bdy)
+{
+    auto& buf = m_buf.at(nt);
+#ifdef AMREX_USE_GPU
+    // The boundary fill kernels read the slice, so it is copied to device memory once
+    auto [dit, fresh] = m_dbuf.try_emplace(nt);
+    auto& dbuf = dit->second;
+#endif
+    for (int side = 0; side < 4; ++side) {
+        if (!m_held[side]) continue;
+#ifdef AMREX_USE_GPU
+        if (fresh) {
+            dbuf[side].resize(buf[side].size());
+            Gpu::copyAsync(Gpu::hostToDevice, buf[side].begin(), buf[side].end(), dbuf[side].begin());
+        }
+        Real* p = dbuf[side].data();
+#else
+        Real* p = buf[side].data();
+#endif
+        for (int ivar = 0; ivar < WRFBdyVars::NumTypes; ++ivar) {
+            const Box bx = var_box(side,ivar);
+            (*bdy[side])[nt][ivar] = FArrayBox(bx, 1, p);
+            p += bx.numPts();
+        }
+    }
+}
+
+/**
+ * Releases slice nt
+ *
+ * @param nt Index of the time slice
+ * @param bdy Boundary data containers for the four sides
+ */
+void
+WRFBdyStream::free_slice (int nt, std::array<BdyData*,4>& bdy)
+{
+    wait_slice(nt);
+    for (int side = 0; side < 4; ++side) {
+        for (auto& fab : (*bdy[side])[nt]) {
+            fab = FArrayBox();
+        }
+    }
+    m_buf.erase(nt);
+#ifdef AMREX_USE_GPU
+    m_dbuf.erase(nt);
+#endif
+}
+
+/**
+ * Makes sure this rank holds the boundary data needed to advance from time to
+ * time+dt, releases older slices and starts fetching the slice after those
+ *
+ * @param time Start of the level 0 step
+ * @param dt Level 0 time step
+ * @param cons Level 0 conserved state, whose grids decide which sides are held
+ * @param bdy_xlo Boundary data on the low x side
+ * @param bdy_xhi Boundary data on the high x side
+ * @param bdy_ylo Boundary data on the low y side
+ * @param bdy_yhi Boundary data on the high y side
+ */
+void
+WRFBdyStream::update (Real time, Real dt,
+                      const MultiFab& cons,
+                      BdyData& bdy_xlo, BdyData& bdy_xhi,
+                      BdyData& bdy_ylo, BdyData& bdy_yhi)
+{
+    BL_PROFILE("ERF::WRFBdyStream::update");
+
+    std::array<BdyData*,4> bdy {&bdy_xlo, &bdy_xhi, &bdy_ylo, &bdy_yhi};
+    for (auto* b : bdy) {
+        if (static_cast<int>(b->size()) != m_ntimes) {
+            b->clear();
+            b->resize(m_ntimes);
+            for (auto& bdy_at_time : *b) {
+                bdy_at_time.resize(WRFBdyVars::NumTypes);
+            }
+        }
+    }
+
+    // Start over if the level 0 grids have changed
+    if (m_ba != cons.boxArray() || m_dm != cons.DistributionMap()) {
+        while (!m_buf.empty()) {
+            free_slice(m_buf.begin()->first, bdy);
+        }
+        set_held_sides(cons);
+    }
+
+    // Slices bracketing every time in [time, time+dt]
+    const Real t0 = time - m_start_time;
+    const int n_lo = std::min(std::max(static_cast<int>(t0 / m_interval), 0), m_ntimes-1);
+    const int n_hi = std::min(static_cast<int>((t0 + dt) / m_interval) + 1, m_ntimes-1);
+
+    while (!m_buf.empty() && m_buf.begin()->first < n_lo) {
+        free_slice(m_buf.begin()->first, bdy);
+    }
+
+    for (int nt = n_lo; nt <= n_hi; ++nt) {
+        if (m_buf.count(nt) == 0) {
+            post_slice(nt);
+        }
+        wait_slice(nt);
+        expose_slice(nt, bdy);
+    }
+
+    // Fetch the next slice while we advance through this one
+    if (n_hi+1 < m_ntimes && m_buf.count(n_hi+1) == 0) {
+        post_slice(n_hi+1);
+    }
+}
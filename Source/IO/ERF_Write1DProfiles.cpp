@@ -348,6 +348,7 @@ ERF::derive_diag_profiles(Real /*time*/,
     if (use_moisture)
     {
         int n_qstate = micro->Get_Qstate_Size();
+        micro->Update_Qmoist_Lev(0, vars_new[0][Vars::cons]);
 
         for ( MFIter mfi(mf_cons,TilingIfNotGPU()); mfi.isValid(); ++mfi)
         {
@@ -2,12 +2,24 @@
 #include "AMReX_ParmParse.H"
 #include "AMReX_PlotFileUtil.H"
 #include "AMReX_MultiFabUtil.H"
+#include "AMReX_Utility.H"
 #include "ERF_WriteBndryPlanes.H"
 #include "ERF_IndexDefines.H"
 #include "ERF_Derive.H"
 
+#include <sstream>
+
 using namespace amrex;
 
+namespace {
+    template <typename T>
+    void put_raw (Vector<char>& out, const T& v)
+    {
+        const char* p = reinterpret_cast<const char*>(&v);
+        out.insert(out.end(), p, p+sizeof(T));
+    }
+}
+
 /**
  * Copies the contents of one boundary register to another in either x or y dimensions.
  *
@@ -107,6 +119,101 @@ WriteBndryPlanes::WriteBndryPlanes (Vector<BoxArray>& grids,
         m_var_names.resize(num_vars);
         pp.queryarr("bndry_output_var_names",m_var_names,0,num_vars);
     }
+
+    std::string format = "native";
+    pp.query("bndry_output_format", format);
+    if (format == "aggregated") {
+        m_aggregate = true;
+    } else if (format != "native") {
+        Abort("WriteBndryPlanes: bndry_output_format must be native or aggregated");
+    }
+    pp.query("bndry_output_flush_interval", m_flush_interval);
+    m_flush_interval = std::max(m_flush_interval, 1);
+
+    if (m_aggregate && ParallelDescriptor::IOProcessor()) {
+        if (!UtilCreateDirectory(m_filename, 0755)) {
+            CreateDirectoryFailed(m_filename);
+        }
+    }
+}
+
+/**
+ * Destructor for the WriteBndryPlanes class, which writes any planes still buffered
+ */
+WriteBndryPlanes::~WriteBndryPlanes ()
+{
+    flush(true);
+}
+
+/**
+ * Writes the Header describing the face files of the aggregated format
+ *
+ * @param bndry Boundary register holding the (shifted) face boxes
+ */
+void WriteBndryPlanes::write_header (const BndryRegister& bndry) const
+{
+    const std::string header_name = m_filename + "/Header";
+    std::ofstream header(header_name.c_str(), std::ofstream::out | std::ofstream::trunc);
+    if (!header.good()) {
+        FileOpenFailed(header_name);
+    }
+
+    header << "ERF-BndryPlanes-V1\n";
+    header << m_var_names.size() << "\n";
+    for (const auto& var_name : m_var_names) {
+        header << var_name << " " << ((var_name == "velocity") ? AMREX_SPACEDIM : 1) << "\n";
+    }
+    for (OrientationIter oit; oit != nullptr; ++oit) {
+        auto ori = oit();
+        if (ori.coordDir() < 2) {
+            header << int(ori) << " " << bndry[ori].boxArray()[0] << "\n";
+        }
+    }
+    header << sizeof(Real) << "\n";
+}
+
+/**
+ * Function to start appending the buffered planes of the aggregated format to the face
+ * files and time.dat. The files are written by a background thread; a flush waits for
+ * the previous one before starting.
+ *
+ * @param wait Whether to also wait until this flush is written
+ */
+void WriteBndryPlanes::flush (bool wait)
+{
+    if (!m_aggregate) return;
+
+    if (m_nbuffered > 0 && ParallelDescriptor::IOProcessor())
+    {
+        BL_PROFILE("ERF::WriteBndryPlanes::flush");
+
+        if (m_flush.valid()) m_flush.get();
+
+        m_flush = std::async(std::launch::async,
+                             [filename = m_filename, time_file = m_time_file,
+                              buffer = std::move(m_buffer), times = std::move(m_time_buffer)] ()
+        {
+            for (OrientationIter oit; oit != nullptr; ++oit) {
+                auto ori = oit();
+                if (ori.coordDir() < 2) {
+                    const std::string facename = Concatenate(filename + "/face_", ori, 1) + ".bin";
+                    std::ofstream face_file(facename.c_str(), std::ios::out | std::ios::app | std::ios::binary);
+                    if (!face_file.good()) {
+                        FileOpenFailed(facename);
+                    }
+                    face_file.write(buffer[ori].data(), static_cast<std::streamsize>(buffer[ori].size()));
+                }
+            }
+            std::ofstream oftime(time_file, std::ios::out | std::ios::app);
+            oftime << times;
+        });
+
+        for (auto& b : m_buffer) b.clear();
+        m_time_buffer.clear();
+    }
+    m_nbuffered = 0;
+
+    if (wait && m_flush.valid()) m_flush.get();
 }
 
 /**
@@ -133,12 +240,27 @@ void WriteBndryPlanes::write_planes (const int t_step, const Real time,
     //Print() << "Writing boundary planes at time " << time << std::endl;
 
     const std::string level_prefix = "Level_";
-    PreBuildDirectorHierarchy(chkname, level_prefix, 1, true);
+    if (!m_aggregate) {
+        PreBuildDirectorHierarchy(chkname, level_prefix, 1, true);
+    }
 
     // note: by using the entire domain box we end up using 1 processor
-    // to hold all boundaries
+    // to hold all boundaries; in the aggregated format that is the IO rank,
+    // which buffers them
     BoxArray ba(target_box);
-    DistributionMapping dm{ba};
+    DistributionMapping dm = (m_aggregate) ? DistributionMapping(Vector<int>{ParallelDescriptor::IOProcessorNumber()})
+                                           : DistributionMapping{ba};
+
+    const bool buffer_here = m_aggregate && ParallelDescriptor::IOProcessor();
+    if (buffer_here) {
+        for (OrientationIter oit; oit != nullptr; ++oit) {
+            auto ori = oit();
+            if (ori.coordDir() < 2) {
+                put_raw<int>(m_buffer[ori], t_step);
+                put_raw<Real>(m_buffer[ori], time);
+            }
+        }
+    }
 
     IntVect new_hi = target_box.bigEnd() - target_box.smallEnd();
     Box target_box_shifted(IntVect(0,0,0),new_hi);
@@ -236,19 +358,42 @@ void WriteBndryPlanes::write_planes (const int t_step, const Real time,
             Error("Don't know how to output this variable");
         }
 
+        if (buffer_here && !m_header_written && i == 0) {
+            write_header(bndry_shifted);
+        }
+
         for (OrientationIter oit; oit != nullptr; ++oit) {
             auto ori = oit();
             if (ori.coordDir() < 2) {
-                std::string facename = Concatenate(filename + '_', ori, 1);
                 br_shift(oit, bndry, bndry_shifted);
-                bndry_shifted[ori].write(facename);
+                if (!m_aggregate) {
+                    std::string facename = Concatenate(filename + '_', ori, 1);
+                    bndry_shifted[ori].write(facename);
+                } else if (buffer_here) {
+                    for (FabSetIter bfsi(bndry_shifted[ori]); bfsi.isValid(); ++bfsi) {
+                        const FArrayBox& fab = bndry_shifted[ori][bfsi];
+                        const std::size_t offset = m_buffer[ori].size();
+                        m_buffer[ori].resize(offset + fab.nBytes());
+                        Gpu::dtoh_memcpy(m_buffer[ori].data() + offset, fab.dataPtr(), fab.nBytes());
+                    }
+                }
             }
         }
 
     } // loop over num_vars
+    m_header_written = true;
 
     // Writing time.dat
-    if (ParallelDescriptor::IOProcessor()) {
+    if (m_aggregate) {
+        if (buffer_here) {
+            std::ostringstream line;
+            line << t_step << ' ' << time << '\n';
+            m_time_buffer += line.str();
+        }
+        if (++m_nbuffered >= m_flush_interval) {
+            flush();
+        }
+    } else if (ParallelDescriptor::IOProcessor()) {
         std::ofstream oftime(m_time_file, std::ios::out | std::ios::app);
         oftime << t_step << ' ' << time << '\n';
         oftime.close();
@@ -0,0 +1,353 @@
+#include <AMReX_NFiles.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_VisMF.H>
+#include <AMReX_GpuDevice.H>
+
+#include "ERF_ZPlotfile.H"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+
+using namespace amrex;
+
+namespace {
+
+    // Block types
+    constexpr std::uint8_t mode_raw   = 0;
+    constexpr std::uint8_t mode_quant = 1;
+    constexpr std::uint8_t mode_const = 2;
+
+    // Largest quantized range we allow before falling back to raw storage;
+    //     this keeps every quantized value exactly representable as a double
+    constexpr double max_quant_range = 4.0e15;
+
+    template <typename T>
+    void put_raw (Vector<char>& out, const T& v)
+    {
+        const char* p = reinterpret_cast<const char*>(&v);
+        out.insert(out.end(), p, p+sizeof(T));
+    }
+
+    template <typename T>
+    T get_raw (const char*& in)
+    {
+        T v;
+        std::memcpy(&v, in, sizeof(T));
+        in += sizeof(T);
+        return v;
+    }
+
+    void put_varint (Vector<char>& out, std::uint64_t v)
+    {
+        while (v >= 0x80) {
+            out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<char>(v));
+    }
+
+    std::uint64_t get_varint (const char*& in)
+    {
+        std::uint64_t v = 0;
+        int shift = 0;
+        while (true) {
+            auto b = static_cast<std::uint8_t>(*in++);
+            v |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) break;
+            shift += 7;
+        }
+        return v;
+    }
+}
+
+void
+ZPlotfile::encode (const Real* data, Long npts, Real abs_err, Vector<char>& out)
+{
+    double vmin =  std::numeric_limits<double>::max();
+    double vmax = -std::numeric_limits<double>::max();
+    bool all_finite = true;
+    for (Long n = 0; n < npts; ++n) {
+        const double v = data[n];
+        if (!std::isfinite(v)) {
+            all_finite = false;
+            break;
+        }
+        vmin = std::min(vmin,v);
+        vmax = std::max(vmax,v);
+    }
+
+    if (npts > 0 && all_finite && vmin == vmax) {
+        out.push_back(static_cast<char>(mode_const));
+        put_raw<Real>(out, data[0]);
+        return;
+    }
+
+    // Rounding to the nearest multiple of step gives an error of at most step/2;
+    //     shave the step slightly so that floating point round-off stays inside the bound
+    const double step = 2.0 * static_cast<double>(abs_err) * (1.0 - 1.0e-6);
+
+    if (abs_err <= 0. || !all_finite || (vmax - vmin) / step > max_quant_range) {
+        out.push_back(static_cast<char>(mode_raw));
+        for (Long n = 0; n < npts; ++n) {
+            put_raw<Real>(out, data[n]);
+        }
+        return;
+    }
+
+    out.push_back(static_cast<char>(mode_quant));
+    put_raw<double>(out, vmin);
+    put_raw<double>(out, step);
+
+    // A token is either (zigzag(delta) << 1) or (run_length << 1 | 1) for a run of zero deltas
+    std::int64_t  prev = 0;
+    std::uint64_t zero_run = 0;
+    for (Long n = 0; n < npts; ++n) {
+        auto q = static_cast<std::int64_t>(std::llround((static_cast<double>(data[n]) - vmin) / step));
+        std::int64_t d = q - prev;
+        prev = q;
+        if (d == 0) {
+            ++zero_run;
+        } else {
+            if (zero_run > 0) {
+                put_varint(out, (zero_run << 1) | 1);
+                zero_run = 0;
+            }
+            auto z = (static_cast<std::uint64_t>(d) << 1) ^ static_cast<std::uint64_t>(d >> 63);
+            put_varint(out, z << 1);
+        }
+    }
+    if (zero_run > 0) {
+        put_varint(out, (zero_run << 1) | 1);
+    }
+}
+
+void
+ZPlotfile::decode (const char*& in, Long npts, Real* data)
+{
+    const auto mode = get_raw<std::uint8_t>(in);
+
+    if (mode == mode_const) {
+        const Real v = get_raw<Real>(in);
+        for (Long n = 0; n < npts; ++n) {
+            data[n] = v;
+        }
+    } else if (mode == mode_raw) {
+        for (Long n = 0; n < npts; ++n) {
+            data[n] = get_raw<Real>(in);
+        }
+    } else if (mode == mode_quant) {
+        const double vmin = get_raw<double>(in);
+        const double step = get_raw<double>(in);
+        std::int64_t q = 0;
+        Long n = 0;
+        while (n < npts) {
+            std::uint64_t tok = get_varint(in);
+            if (tok & 1) {
+                std::uint64_t run = tok >> 1;
+                const Real v = static_cast<Real>(vmin + static_cast<double>(q) * step);
+                for (std::uint64_t r = 0; r < run && n < npts; ++r) {
+                    data[n++] = v;
+                }
+            } else {
+                std::uint64_t z = tok >> 1;
+                auto d = static_cast<std::int64_t>(z >> 1) ^ -static_cast<std::int64_t>(z & 1);
+                q += d;
+                data[n++] = static_cast<Real>(vmin + static_cast<double>(q) * step);
+            }
+        }
+    } else {
+        Abort("ZPlotfile::decode: unknown block type");
+    }
+}
+
+Vector<Real>
+ZPlotfile::AbsErrorBounds (const MultiFab& mf, const Vector<Real>& err_bound, bool relative)
+{
+    const int ncomp = mf.nComp();
+    AMREX_ALWAYS_ASSERT(err_bound.size() == ncomp);
+
+    Vector<Real> abs_err(err_bound);
+    if (relative) {
+        for (int n = 0; n < ncomp; ++n) {
+            if (err_bound[n] > 0.) {
+                // Bound is relative to the range of the component on this level
+                Real range = mf.max(n) - mf.min(n);
+                abs_err[n] = err_bound[n] * range;
+            }
+        }
+    }
+    return abs_err;
+}
+
+void
+ZPlotfile::WriteLevel (const MultiFab& mf, const Vector<Real>& abs_err, const std::string& prefix)
+{
+    BL_PROFILE("ZPlotfile::WriteLevel()");
+
+    AMREX_ALWAYS_ASSERT(mf.nGrowVect() == 0);
+
+    const int ncomp = mf.nComp();
+    AMREX_ALWAYS_ASSERT(abs_err.size() == ncomp);
+
+    const int  nOutFiles = VisMF::GetNOutFiles();
+    const bool groupSets = false;
+    const bool setBuf    = true;
+
+    // Encode all of our FABs before we wait for our turn to write
+    Vector<char> buffer;
+    FArrayBox host_fab;
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+    {
+        const Box& bx  = mfi.validbox();
+        const Long npts = bx.numPts();
+
+        host_fab.resize(bx, ncomp, The_Pinned_Arena());
+        Gpu::dtoh_memcpy(host_fab.dataPtr(), mf[mfi].dataPtr(), host_fab.nBytes());
+
+        put_raw<int>(buffer, mfi.index());
+        put_raw<int>(buffer, ncomp);
+        put_raw<Long>(buffer, npts);
+
+        Vector<char> block;
+        for (int n = 0; n < ncomp; ++n) {
+            block.clear();
+            encode(host_fab.dataPtr(n), npts, abs_err[n], block);
+            put_raw<std::uint64_t>(buffer, static_cast<std::uint64_t>(block.size()));
+            buffer.insert(buffer.end(), block.begin(), block.end());
+        }
+    }
+
+    const std::string data_prefix(prefix + "_D");
+    NFilesIter nfi(nOutFiles, data_prefix, groupSets, setBuf);
+    for ( ; nfi.ReadyToWrite(); ++nfi) {
+        if (!buffer.empty()) {
+            nfi.Stream().write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        }
+    }
+
+    if (ParallelDescriptor::IOProcessor())
+    {
+        std::string HeaderFileName(prefix + "_H");
+        VisMF::IO_Buffer io_buffer(VisMF::IO_Buffer_Size);
+        std::ofstream HeaderFile;
+        HeaderFile.rdbuf()->pubsetbuf(io_buffer.dataPtr(), io_buffer.size());
+        HeaderFile.open(HeaderFileName.c_str(), std::ofstream::out   |
+                                                std::ofstream::trunc |
+                                                std::ofstream::binary);
+        if( ! HeaderFile.good()) {
+            FileOpenFailed(HeaderFileName);
+        }
+
+        HeaderFile.precision(17);
+        HeaderFile << version_string << "\n";
+        HeaderFile << ncomp << "\n";
+        for (int n = 0; n < ncomp; ++n) {
+            HeaderFile << abs_err[n] << " ";
+        }
+        HeaderFile << "\n";
+        mf.boxArray().writeOn(HeaderFile);
+        HeaderFile << "\n";
+        HeaderFile << nOutFiles << "\n";
+        const DistributionMapping& dm = mf.DistributionMap();
+        for (int i = 0; i < dm.size(); ++i) {
+            HeaderFile << dm[i] << " ";
+        }
+        HeaderFile << "\n";
+    }
+}
+
+void
+ZPlotfile::ReadLevel (const std::string& prefix, MultiFab& mf, Vector<Real>& abs_err)
+{
+    BL_PROFILE("ZPlotfile::ReadLevel()");
+
+    std::string File(prefix + "_H");
+    Vector<char> fileCharPtr;
+    ParallelDescriptor::ReadAndBcastFile(File, fileCharPtr);
+    std::string fileCharPtrString(fileCharPtr.dataPtr());
+    std::istringstream is(fileCharPtrString, std::istringstream::in);
+
+    std::string version;
+    std::getline(is, version);
+    if (version != version_string) {
+        Abort("ZPlotfile::ReadLevel: unexpected header version " + version);
+    }
+
+    int ncomp;
+    is >> ncomp;
+    abs_err.resize(ncomp);
+    for (int n = 0; n < ncomp; ++n) {
+        is >> abs_err[n];
+    }
+
+    BoxArray ba;
+    ba.readFrom(is);
+
+    int nOutFiles;
+    is >> nOutFiles;
+    Vector<int> writer_rank(ba.size());
+    for (int i = 0; i < ba.size(); ++i) {
+        is >> writer_rank[i];
+    }
+
+    DistributionMapping dm(ba, ParallelDescriptor::NProcs());
+    mf.define(ba, dm, ncomp, 0);
+
+    // Which files hold the FABs we own?
+    std::map<std::string,int> files_to_read;
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+        const std::string fname = NFilesIter::FileName(nOutFiles, prefix + "_D",
+                                                        writer_rank[mfi.index()], false);
+        files_to_read[fname] += 1;
+    }
+
+    FArrayBox host_fab;
+    Vector<char> block;
+    for (auto const& f : files_to_read)
+    {
+        std::ifstream ifs(f.first, std::ios::in | std::ios::binary);
+        if (!ifs.good()) {
+            FileOpenFailed(f.first);
+        }
+
+        int nleft = f.second;
+        while (nleft > 0 && ifs.peek() != std::char_traits<char>::eof())
+        {
+            int idx, nc;
+            Long npts;
+            ifs.read(reinterpret_cast<char*>(&idx) , sizeof(int));
+            ifs.read(reinterpret_cast<char*>(&nc)  , sizeof(int));
+            ifs.read(reinterpret_cast<char*>(&npts), sizeof(Long));
+            AMREX_ALWAYS_ASSERT(nc == ncomp);
+
+            const bool is_mine = (dm[idx] == ParallelDescriptor::MyProc());
+            if (is_mine) {
+                AMREX_ALWAYS_ASSERT(npts == ba[idx].numPts());
+                host_fab.resize(ba[idx], ncomp, The_Pinned_Arena());
+            }
+
+            for (int n = 0; n < ncomp; ++n) {
+                std::uint64_t nbytes;
+                ifs.read(reinterpret_cast<char*>(&nbytes), sizeof(std::uint64_t));
+                if (is_mine) {
+                    block.resize(static_cast<Long>(nbytes));
+                    ifs.read(block.data(), static_cast<std::streamsize>(nbytes));
+                    const char* p = block.data();
+                    decode(p, npts, host_fab.dataPtr(n));
+                } else {
+                    ifs.seekg(static_cast<std::streamoff>(nbytes), std::ios::cur);
+                }
+            }
+
+            if (is_mine) {
+                Gpu::htod_memcpy(mf[idx].dataPtr(), host_fab.dataPtr(), host_fab.nBytes());
+                --nleft;
+            }
+        }
+    }
+}
@@ -308,6 +308,40 @@ ERF::initHSE ()
     }
 }
 
+/**
+ * Puts the base state in hydrostatic equilibrium with the current density, as needed
+ * when a checkpoint is interpolated onto a refined level 0.
+ *
+ * @param[in] lev Integer specifying the current level
+ */
+void
+ERF::restart_hse (int lev)
+{
+    // The pressure is integrated up each column, so work on grids spanning the whole height
+    const Box& domain = geom[lev].Domain();
+    BoxArray ba_col(domain);
+    ChopGrids2D(ba_col, domain, ParallelDescriptor::NProcs());
+    DistributionMapping dm_col(ba_col);
+
+    MultiFab col_state(ba_col, dm_col, 3, 1);
+    col_state.setVal(0.0);
+    col_state.ParallelCopy(vars_new[lev][Vars::cons], Rho_comp, 0, 1, 0, 1, geom[lev].periodicity());
+
+    MultiFab col_r_hse (col_state, make_alias, 0, 1);
+    MultiFab col_p_hse (col_state, make_alias, 1, 1);
+    MultiFab col_pi_hse(col_state, make_alias, 2, 1);
+
+    std::unique_ptr<MultiFab> col_z_phys_cc;
+    if (solverChoice.use_terrain) {
+        col_z_phys_cc = std::make_unique<MultiFab>(ba_col, dm_col, 1, 1);
+        col_z_phys_cc->ParallelCopy(*z_phys_cc[lev], 0, 0, 1, 1, 1);
+    }
+
+    erf_enforce_hse(lev, col_r_hse, col_p_hse, col_pi_hse, col_z_phys_cc);
+
+    base_state[lev].ParallelCopy(col_state, 0, 0, 3, 1, 1);
+}
+
 /**
  * Enforces hydrostatic equilibrium when using terrain.
  *
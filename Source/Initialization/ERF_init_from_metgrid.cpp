@@ -3,6 +3,9 @@
  */
 
 #include <ERF_Metgrid_utils.H>
+#ifdef ERF_USE_NETCDF
+#include <ERF_NCWpsFile.H>
+#endif
 
 using namespace amrex;
 
@@ -78,6 +81,18 @@ ERF::init_from_metgrid (int lev)
     Arena_Used = The_Pinned_Arena();
 #endif
 
+    // With nc_read_local every rank reads only the part of each file that covers its own
+    // boxes (plus ghost cells), so the files are read by all ranks at once
+    Box read_bx;
+    if (nc_read_local) {
+        IntVect ng_read = vars_new[lev][Vars::cons].nGrowVect();
+        if (solverChoice.use_terrain) ng_read.max(z_phys_nd[lev]->nGrowVect());
+        ng_read += IntVect(1);
+        read_bx = nc_local_read_box(vars_new[lev][Vars::cons].boxArray(),
+                                    vars_new[lev][Vars::cons].DistributionMap(),
+                                    ng_read, boxes_at_level[lev][0]);
+    }
+
     for (int it = 0; it < ntimes; it++) {
         read_from_metgrid(lev, boxes_at_level[lev][0], nc_init_file[lev][it],
                           NC_dateTime[it], NC_epochTime[it],
@@ -89,7 +104,8 @@ ERF::init_from_metgrid (int lev)
                           NC_ght_fab[it],  NC_hgt_fab[it],  NC_psfc_fab[it],
                           NC_MSFU_fab[it], NC_MSFV_fab[it], NC_MSFM_fab[it],
                           NC_sst_fab[it],  NC_LAT_fab[it],  NC_LON_fab[it],
-                          NC_lmask_iab[it], Latitude,       Longitude,       geom[lev]);
+                          NC_lmask_iab[it], Latitude,       Longitude,       geom[lev],
+                          nc_read_local,    read_bx);
     } // it
 
     // Verify that files in nc_init_file[lev] are ordered from earliest to latest.
@@ -8,6 +8,9 @@
 #include <ERF_Utils.H>
 #include <ERF_prob_common.H>
 #include <ERF_DataStruct.H>
+#ifdef ERF_USE_NETCDF
+#include <ERF_NCWpsFile.H>
+#endif
 
 using namespace amrex;
 
@@ -37,7 +40,9 @@ read_from_wrfinput (int lev, const Box& domain, const std::string& fname,
                     MoistureType moisture_type,
                     Real& Latitude,
                     Real& Longitude,
-                    Geometry& geom);
+                    Geometry& geom,
+                    bool read_local,
+                    const Box& read_bx);
 
 Real
 read_from_wrfbdy (const std::string& nc_bdy_file, const Box& domain,
@@ -89,7 +94,8 @@ init_msfs_from_wrfinput (int lev, FArrayBox& msfu_fab,
 void
 verify_terrain_top_boundary (const Real& z_top,
                              const Vector<FArrayBox>& NC_PH_fab,
-                             const Vector<FArrayBox>& NC_PHB_fab);
+                             const Vector<FArrayBox>& NC_PHB_fab,
+                             bool reduce);
 
 void
 init_terrain_from_wrfinput (int lev, const Real& z_top,
@@ -151,8 +157,21 @@ ERF::init_from_wrfinput (int lev)
     if (nc_init_file.empty())
         amrex::Error("NetCDF initialization file name must be provided via input");
 
+    // With nc_read_local every rank reads only the part of each file that covers its own
+    // boxes, grown so that the ghost cells of the state, base state and terrain are covered
+    IntVect ng_read = vars_new[lev][Vars::cons].nGrowVect();
+    ng_read.max(base_state[lev].nGrowVect());
+    if (solverChoice.use_terrain) ng_read.max(z_phys_nd[lev]->nGrowVect());
+    ng_read += IntVect(1);
+
     for (int idx = 0; idx < num_boxes_at_level[lev]; idx++)
     {
+        Box read_bx;
+        if (nc_read_local) {
+            read_bx = nc_local_read_box(vars_new[lev][Vars::cons].boxArray(),
+                                        vars_new[lev][Vars::cons].DistributionMap(),
+                                        ng_read, boxes_at_level[lev][idx]);
+        }
         read_from_wrfinput(lev, boxes_at_level[lev][idx], nc_init_file[lev][idx],
                            NC_xvel_fab[idx]  , NC_yvel_fab[idx]  , NC_zvel_fab[idx] , NC_rho_fab[idx],
                            NC_rhop_fab[idx]  , NC_rhoth_fab[idx] , NC_MUB_fab[idx]  ,
@@ -163,7 +182,8 @@ ERF::init_from_wrfinput (int lev)
                            NC_PH_fab[idx]    , NC_P_fab[idx]     , NC_PHB_fab[idx]  ,
                            NC_ALB_fab[idx]   , NC_PB_fab[idx]    ,
                            NC_LAT_fab[idx]   , NC_LON_fab[idx],
-                           solverChoice.moisture_type, Latitude, Longitude, geom[lev]);
+                           solverChoice.moisture_type, Latitude, Longitude, geom[lev],
+                           nc_read_local, read_bx);
     }
 
     auto& lev_new = vars_new[lev];
@@ -256,8 +276,9 @@ ERF::init_from_wrfinput (int lev)
     const Real& z_top = geom[lev].ProbHi(2);
     if (solverChoice.use_terrain)
     {
-        if (ParallelDescriptor::IOProcessor()) {
-            verify_terrain_top_boundary(z_top, NC_PH_fab, NC_PHB_fab);
+        // With rank-local data every rank checks its part and we reduce the extrema
+        if (nc_read_local || ParallelDescriptor::IOProcessor()) {
+            verify_terrain_top_boundary(z_top, NC_PH_fab, NC_PHB_fab, nc_read_local);
         }
 
         std::unique_ptr<MultiFab>& z_phys = z_phys_nd[lev];
@@ -300,7 +321,23 @@ ERF::init_from_wrfinput (int lev)
         pi_hse.FillBoundary(geom[lev].periodicity());
     }
 
-    if (init_type == "real" && (lev == 0)) {
+    if (init_type == "real" && (lev == 0) && real_bdy_stream) {
+        if (nc_bdy_file.empty())
+            amrex::Error("NetCDF boundary file name must be provided via input");
+        m_bdy_stream = std::make_unique<WRFBdyStream>(nc_bdy_file, nc_init_file[lev][0],
+                                                      geom[lev], solverChoice.moisture_type);
+        bdy_time_interval = m_bdy_stream->interval();
+        start_bdy_time    = m_bdy_stream->start_time();
+        real_width        = m_bdy_stream->width();
+
+        Print() << "Streaming boundary data with width "  << real_width << std::endl;
+        Print() << "Running with specification width: " << real_set_width
+                << " and relaxation width: " << real_width - real_set_width << std::endl;
+
+        m_bdy_stream->update(start_bdy_time, 0.0, lev_new[Vars::cons],
+                             bdy_data_xlo, bdy_data_xhi, bdy_data_ylo, bdy_data_yhi);
+        m_bdy_stream->finish_reads();
+    } else if (init_type == "real" && (lev == 0)) {
         if (nc_bdy_file.empty())
             amrex::Error("NetCDF boundary file name must be provided via input");
         bdy_time_interval = read_from_wrfbdy(nc_bdy_file,geom[0].Domain(),
@@ -311,22 +348,73 @@ ERF::init_from_wrfinput (int lev)
         Print() << "Running with specification width: " << real_set_width
                 << " and relaxation width: " << real_width - real_set_width << std::endl;
 
-        convert_wrfbdy_data(domain,bdy_data_xlo,
-                            NC_MUB_fab[0] , NC_PH_fab[0]  , NC_PHB_fab[0] ,
-                            NC_C1H_fab[0] , NC_C2H_fab[0] , NC_RDNW_fab[0],
-                            NC_xvel_fab[0], NC_yvel_fab[0], NC_rho_fab[0] , NC_rhoth_fab[0], NC_QVAPOR_fab[0]);
-        convert_wrfbdy_data(domain,bdy_data_xhi,
-                            NC_MUB_fab[0] , NC_PH_fab[0]  , NC_PHB_fab[0] ,
-                            NC_C1H_fab[0] , NC_C2H_fab[0] , NC_RDNW_fab[0],
-                            NC_xvel_fab[0], NC_yvel_fab[0], NC_rho_fab[0] , NC_rhoth_fab[0], NC_QVAPOR_fab[0]);
-        convert_wrfbdy_data(domain,bdy_data_ylo,
-                            NC_MUB_fab[0] , NC_PH_fab[0]  , NC_PHB_fab[0] ,
-                            NC_C1H_fab[0] , NC_C2H_fab[0] , NC_RDNW_fab[0],
-                            NC_xvel_fab[0], NC_yvel_fab[0], NC_rho_fab[0] , NC_rhoth_fab[0], NC_QVAPOR_fab[0]);
-        convert_wrfbdy_data(domain,bdy_data_yhi,
-                            NC_MUB_fab[0] , NC_PH_fab[0]  , NC_PHB_fab[0] ,
-                            NC_C1H_fab[0] , NC_C2H_fab[0] , NC_RDNW_fab[0],
-                            NC_xvel_fab[0], NC_yvel_fab[0], NC_rho_fab[0] , NC_rhoth_fab[0], NC_QVAPOR_fab[0]);
+        if (nc_read_local) {
+            //
+            // The conversion needs the initial data on the lateral boundary strips, which in
+            // general no rank holds when reading rank-locally. The IO rank reads just these
+            // strips, converts the boundary data and broadcasts the result.
+            //
+            if (ParallelDescriptor::IOProcessor()) {
+                FArrayBox xvel, yvel, zvel, rho, rhop, rhoth, mub, msfu, msfv, msfm, sst, lmsk,
+                          c1h, c2h, rdnw, qv, qc, qr, ph, p, phb, alb, pb, lat, lon;
+                Real lat_ref, lon_ref;
+
+                Array<Vector<Vector<FArrayBox>>*,4> bdy_data {&bdy_data_xlo, &bdy_data_xhi,
+                                                             &bdy_data_ylo, &bdy_data_yhi};
+                for (int side = 0; side < 4; ++side)
+                {
+                    // One extra cell inward since face data use the cell on either side
+                    const int dir = side / 2;
+                    Box strip(domain);
+                    if (side % 2 == 0) {
+                        strip.setBig(dir, domain.smallEnd(dir) + real_width);
+                    } else {
+                        strip.setSmall(dir, domain.bigEnd(dir) - real_width);
+                    }
+
+                    read_from_wrfinput(lev, domain, nc_init_file[lev][0],
+                                       xvel, yvel, zvel, rho, rhop, rhoth, mub,
+                                       msfu, msfv, msfm, sst, lmsk, c1h, c2h, rdnw,
+                                       qv, qc, qr, ph, p, phb, alb, pb, lat, lon,
+                                       solverChoice.moisture_type, lat_ref, lon_ref, geom[lev],
+                                       true, strip);
+
+                    convert_wrfbdy_data(domain, *bdy_data[side],
+                                        mub , ph  , phb ,
+                                        c1h , c2h , rdnw,
+                                        xvel, yvel, rho , rhoth, qv);
+                }
+                Gpu::streamSynchronize();
+            }
+
+            int ioproc = ParallelDescriptor::IOProcessorNumber();
+            for (auto* bdy_data : {&bdy_data_xlo, &bdy_data_xhi, &bdy_data_ylo, &bdy_data_yhi}) {
+                for (auto& bdy_data_at_time : *bdy_data) {
+                    for (int ivar : {WRFBdyVars::U, WRFBdyVars::V, WRFBdyVars::R,
+                                     WRFBdyVars::T, WRFBdyVars::QV}) {
+                        FArrayBox& fab = bdy_data_at_time[ivar];
+                        ParallelDescriptor::Bcast(fab.dataPtr(), fab.size(), ioproc);
+                    }
+                }
+            }
+        } else {
+            convert_wrfbdy_data(domain,bdy_data_xlo,
+                                NC_MUB_fab[0] , NC_PH_fab[0]  , NC_PHB_fab[0] ,
+                                NC_C1H_fab[0] , NC_C2H_fab[0] , NC_RDNW_fab[0],
+                                NC_xvel_fab[0], NC_yvel_fab[0], NC_rho_fab[0] , NC_rhoth_fab[0], NC_QVAPOR_fab[0]);
+            convert_wrfbdy_data(domain,bdy_data_xhi,
+                                NC_MUB_fab[0] , NC_PH_fab[0]  , NC_PHB_fab[0] ,
+                                NC_C1H_fab[0] , NC_C2H_fab[0] , NC_RDNW_fab[0],
+                                NC_xvel_fab[0], NC_yvel_fab[0], NC_rho_fab[0] , NC_rhoth_fab[0], NC_QVAPOR_fab[0]);
+            convert_wrfbdy_data(domain,bdy_data_ylo,
+                                NC_MUB_fab[0] , NC_PH_fab[0]  , NC_PHB_fab[0] ,
+                                NC_C1H_fab[0] , NC_C2H_fab[0] , NC_RDNW_fab[0],
+                                NC_xvel_fab[0], NC_yvel_fab[0], NC_rho_fab[0] , NC_rhoth_fab[0], NC_QVAPOR_fab[0]);
+            convert_wrfbdy_data(domain,bdy_data_yhi,
+                                NC_MUB_fab[0] , NC_PH_fab[0]  , NC_PHB_fab[0] ,
+                                NC_C1H_fab[0] , NC_C2H_fab[0] , NC_RDNW_fab[0],
+                                NC_xvel_fab[0], NC_yvel_fab[0], NC_rho_fab[0] , NC_rhoth_fab[0], NC_QVAPOR_fab[0]);
+        }
     }
 
     // Start at the earliest time (read_from_wrfbdy)
@@ -525,11 +613,13 @@ init_base_state_from_wrfinput (int /*lev*/,
  * @param z_top Real user specified top boundary
  * @param NC_PH_fab Vector of FArrayBox objects storing WRF terrain coordinate data (PH)
  * @param NC_PHB_fab Vector of FArrayBox objects storing WRF terrain coordinate data (PHB)
+ * @param reduce Whether each rank holds only part of the data, so the extrema must be reduced over all ranks
  */
 void
 verify_terrain_top_boundary (const Real& z_top,
                              const Vector<FArrayBox>& NC_PH_fab,
-                             const Vector<FArrayBox>& NC_PHB_fab)
+                             const Vector<FArrayBox>& NC_PHB_fab,
+                             bool reduce)
 {
     int nboxes = NC_PH_fab.size();
     for (int idx = 0; idx < nboxes; idx++) {
@@ -574,6 +664,9 @@ verify_terrain_top_boundary (const Real& z_top,
         });
 
         Gpu::copy(Gpu::deviceToHost, MaxMax_d.begin(), MaxMax_d.end(), MaxMax_h.begin());
+        if (reduce) {
+            ParallelDescriptor::ReduceRealMax(MaxMax_h.data(), 2);
+        }
         if ((z_top > MaxMax_h[0]) || (z_top < MaxMax_h[1])) {
             Print() << "Z problem extent " << z_top << " does not match NETCDF file min "
                     << MaxMax_h[1] << " and max " << MaxMax_h[0] << "!\n";
@@ -29,12 +29,12 @@ ERF::init_windfarm (int lev)
                              true, false);
     }
 
-    windfarm->fill_Nturb_multifab(geom[lev], Nturb[lev]);
+    windfarm->fill_Nturb_multifab(lev, geom[lev], Nturb[lev]);
 
     windfarm->write_turbine_locations_vtk();
 
     if(solverChoice.windfarm_type == WindFarmType::SimpleAD) {
-        windfarm->fill_SMark_multifab(geom[lev], SMark[lev],
+        windfarm->fill_SMark_multifab(lev, geom[lev], SMark[lev],
                                       solverChoice.sampling_distance_by_D,
                                       solverChoice.turb_disk_angle);
         windfarm->write_actuator_disks_vtk(geom[lev]);
@@ -57,17 +57,18 @@ void Kessler::Init (const MultiFab& cons_in,
 }
 
 /**
- * Initializes the Microphysics module.
+ * Sets the moisture fractions of the microphysics module from the state;
+ * the advance works on the state itself and updates them as it goes.
  *
  * @param[in] cons_in Conserved variables input
  */
 void Kessler::Copy_State_to_Micro (const MultiFab& cons_in)
 {
-    // Get the temperature, density, theta, qt and qp from input
-    for ( MFIter mfi(cons_in); mfi.isValid(); ++mfi) {
+    // Get qv, qc, qt and qp from input
+    for ( MFIter mfi(cons_in,TilingIfNotGPU()); mfi.isValid(); ++mfi) {
         const auto& box3d = mfi.tilebox();
 
-        auto states_array = cons_in.array(mfi);
+        auto states_array = cons_in.const_array(mfi);
 
         auto qt_array    = mic_fab_vars[MicVar_Kess::qt]->array(mfi);
         auto qv_array    = mic_fab_vars[MicVar_Kess::qv]->array(mfi);
@@ -75,25 +76,12 @@ void Kessler::Copy_State_to_Micro (const MultiFab& cons_in)
 
         auto qp_array    = mic_fab_vars[MicVar_Kess::qp]->array(mfi);
 
-        auto rho_array   = mic_fab_vars[MicVar_Kess::rho]->array(mfi);
-        auto theta_array = mic_fab_vars[MicVar_Kess::theta]->array(mfi);
-        auto tabs_array  = mic_fab_vars[MicVar_Kess::tabs]->array(mfi);
-        auto pres_array  = mic_fab_vars[MicVar_Kess::pres]->array(mfi);
-
-        // Get pressure, theta, temperature, density, and qt, qp
         ParallelFor( box3d, [=] AMREX_GPU_DEVICE (int i, int j, int k)
         {
-            rho_array(i,j,k)   = states_array(i,j,k,Rho_comp);
-            theta_array(i,j,k) = states_array(i,j,k,RhoTheta_comp)/states_array(i,j,k,Rho_comp);
-            qv_array(i,j,k)    = states_array(i,j,k,RhoQ1_comp)/states_array(i,j,k,Rho_comp);
-            qc_array(i,j,k)    = states_array(i,j,k,RhoQ2_comp)/states_array(i,j,k,Rho_comp);
-            qp_array(i,j,k)    = states_array(i,j,k,RhoQ3_comp)/states_array(i,j,k,Rho_comp);
-            qt_array(i,j,k)    = qv_array(i,j,k) + qc_array(i,j,k);
-
-            tabs_array(i,j,k)  = getTgivenRandRTh(states_array(i,j,k,Rho_comp),
-                                                  states_array(i,j,k,RhoTheta_comp),
-                                                  qv_array(i,j,k));
-            pres_array(i,j,k)  = getPgivenRTh(states_array(i,j,k,RhoTheta_comp), qv_array(i,j,k))/100.;
+            qv_array(i,j,k) = states_array(i,j,k,RhoQ1_comp)/states_array(i,j,k,Rho_comp);
+            qc_array(i,j,k) = states_array(i,j,k,RhoQ2_comp)/states_array(i,j,k,Rho_comp);
+            qp_array(i,j,k) = states_array(i,j,k,RhoQ3_comp)/states_array(i,j,k,Rho_comp);
+            qt_array(i,j,k) = qv_array(i,j,k) + qc_array(i,j,k);
         });
     }
 }
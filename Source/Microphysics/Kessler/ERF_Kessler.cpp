@@ -1,89 +1,109 @@
 #include <ERF_EOS.H>
 #include <ERF_TileNoZ.H>
+#include <AMReX_Reduce.H>
 #include "ERF_Kessler.H"
 #include "ERF_DataStruct.H"
+#include "ERF_ParFunctions.H"
 
 using namespace amrex;
 
 /**
  * Compute Precipitation-related Microphysics quantities.
+ *
+ * The conserved state is updated in place. Density, potential temperature and the
+ * moisture fractions are read from it, and temperature and pressure are computed
+ * from it where they are needed.
  */
 void Kessler::AdvanceKessler (const SolverChoice &solverChoice)
 {
-    auto tabs  = mic_fab_vars[MicVar_Kess::tabs];
+    BL_PROFILE("Kessler::AdvanceKessler()");
+
+    MultiFab& cons = *m_cons;
+
+    const SatTableView sat = m_sat_table.view();
+
     if (solverChoice.moisture_type == MoistureType::Kessler){
+        Real cfl_max = solverChoice.sedimentation_cfl;
+
         auto dz = m_geom.CellSize(2);
         auto domain = m_geom.Domain();
         int k_lo = domain.smallEnd(2);
         int k_hi = domain.bigEnd(2);
 
-        MultiFab fz;
-        auto ba    = tabs->boxArray();
-        auto dm    = tabs->DistributionMap();
-        fz.define(convert(ba, IntVect(0,0,1)), dm, 1, 0); // No ghost cells
-
         Real dtn = dt;
 
-        for ( MFIter mfi(fz, TilingIfNotGPU()); mfi.isValid(); ++mfi ){
-            auto rho_array = mic_fab_vars[MicVar_Kess::rho]->array(mfi);
-            auto qp_array  = mic_fab_vars[MicVar_Kess::qp]->array(mfi);
-            auto rain_accum_array = mic_fab_vars[MicVar_Kess::rain_accum]->array(mfi);
-
-            auto fz_array  = fz.array(mfi);
-            const Box& tbz = mfi.tilebox();
-
-            ParallelFor(tbz, [=] AMREX_GPU_DEVICE(int i, int j, int k) noexcept
-            {
-                Real rho_avg, qp_avg;
+        // Fluxes of the sedimentation over the whole step; a subcycled sedimentation
+        // updates the rain before the conversions instead
+        MultiFab fz;
 
-                if (k==k_lo) {
-                    rho_avg = rho_array(i,j,k);
-                    qp_avg  = qp_array(i,j,k);
-                } else if (k==k_hi+1) {
-                    rho_avg = rho_array(i,j,k-1);
-                    qp_avg  = qp_array(i,j,k-1);
-                } else {
-                    rho_avg = 0.5*(rho_array(i,j,k-1) + rho_array(i,j,k)); // Convert to g/cm^3
-                    qp_avg = 0.5*(qp_array(i,j,k-1)  + qp_array(i,j,k));
-                }
+        if (cfl_max > 0.0) {
+            this->RainFall(cfl_max, solverChoice.sedimentation_max_substeps);
+        } else {
+            auto ba    = cons.boxArray();
+            auto dm    = cons.DistributionMap();
+            fz.define(convert(ba, IntVect(0,0,1)), dm, 1, 0); // No ghost cells
+
+            for ( MFIter mfi(fz, TilingIfNotGPU()); mfi.isValid(); ++mfi ){
+                BoxCostTimer box_timer(m_box_cost, mfi);
+                auto states_array = cons.const_array(mfi);
+                auto rain_accum_array = mic_fab_vars[MicVar_Kess::rain_accum]->array(mfi);
+
+                auto fz_array  = fz.array(mfi);
+                const Box& tbz = mfi.tilebox();
+
+                ParallelFor(tbz, [=] AMREX_GPU_DEVICE(int i, int j, int k) noexcept
+                {
+                    Real rho_avg, qp_avg;
+
+                    if (k==k_lo) {
+                        rho_avg = states_array(i,j,k,Rho_comp);
+                        qp_avg  = states_array(i,j,k,RhoQ3_comp)/states_array(i,j,k,Rho_comp);
+                    } else if (k==k_hi+1) {
+                        rho_avg = states_array(i,j,k-1,Rho_comp);
+                        qp_avg  = states_array(i,j,k-1,RhoQ3_comp)/states_array(i,j,k-1,Rho_comp);
+                    } else {
+                        rho_avg = 0.5*(states_array(i,j,k-1,Rho_comp) + states_array(i,j,k,Rho_comp)); // Convert to g/cm^3
+                        qp_avg  = 0.5*(states_array(i,j,k-1,RhoQ3_comp)/states_array(i,j,k-1,Rho_comp)
+                                     + states_array(i,j,k  ,RhoQ3_comp)/states_array(i,j,k  ,Rho_comp));
+                    }
 
-                qp_avg = std::max(0.0, qp_avg);
+                    qp_avg = std::max(0.0, qp_avg);
 
-                Real V_terminal = 36.34*std::pow(rho_avg*0.001*qp_avg, 0.1346)*std::pow(rho_avg/1.16, -0.5); // in m/s
+                    Real V_terminal = 36.34*std::pow(rho_avg*0.001*qp_avg, 0.1346)*std::pow(rho_avg/1.16, -0.5); // in m/s
 
-                // NOTE: Fz is the sedimentation flux from the advective operator.
-                //       In the terrain-following coordinate system, the z-deriv in
-                //       the divergence uses the normal velocity (Omega). However,
-                //       there are no u/v components to the sedimentation velocity.
-                //       Therefore, we simply end up with a division by detJ when
-                //       evaluating the source term: dJinv * (flux_hi - flux_lo) * dzinv.
-                fz_array(i,j,k) = rho_avg*V_terminal*qp_avg;
+                    // NOTE: Fz is the sedimentation flux from the advective operator.
+                    //       In the terrain-following coordinate system, the z-deriv in
+                    //       the divergence uses the normal velocity (Omega). However,
+                    //       there are no u/v components to the sedimentation velocity.
+                    //       Therefore, we simply end up with a division by detJ when
+                    //       evaluating the source term: dJinv * (flux_hi - flux_lo) * dzinv.
+                    fz_array(i,j,k) = rho_avg*V_terminal*qp_avg;
 
-                if(k==k_lo){
-                    rain_accum_array(i,j,k) = rain_accum_array(i,j,k) + rho_avg*qp_avg*V_terminal*dtn/1000.0*1000.0; // Divide by rho_water and convert to mm
-                }
+                    if(k==k_lo){
+                        rain_accum_array(i,j,k) = rain_accum_array(i,j,k) + rho_avg*qp_avg*V_terminal*dtn/1000.0*1000.0; // Divide by rho_water and convert to mm
+                    }
 
-                /*if(k==0){
-                  fz_array(i,j,k) = 0;
-                  }*/
-            });
+                    /*if(k==0){
+                      fz_array(i,j,k) = 0;
+                      }*/
+                });
+            }
         }
 
-        for ( MFIter mfi(*tabs,TilingIfNotGPU()); mfi.isValid(); ++mfi) {
+        for ( MFIter mfi(cons,TilingIfNotGPU()); mfi.isValid(); ++mfi) {
+            BoxCostTimer box_timer(m_box_cost, mfi);
+            auto states_array = cons.array(mfi);
+
             auto qv_array    = mic_fab_vars[MicVar_Kess::qv]->array(mfi);
             auto qc_array    = mic_fab_vars[MicVar_Kess::qcl]->array(mfi);
             auto qp_array    = mic_fab_vars[MicVar_Kess::qp]->array(mfi);
             auto qt_array    = mic_fab_vars[MicVar_Kess::qt]->array(mfi);
-            auto tabs_array  = mic_fab_vars[MicVar_Kess::tabs]->array(mfi);
-            auto pres_array  = mic_fab_vars[MicVar_Kess::pres]->array(mfi);
-            auto theta_array = mic_fab_vars[MicVar_Kess::theta]->array(mfi);
-            auto rho_array   = mic_fab_vars[MicVar_Kess::rho]->array(mfi);
 
             const auto dJ_array = (m_detJ_cc) ? m_detJ_cc->const_array(mfi) : Array4<const Real>{};
 
             const auto& box3d = mfi.tilebox();
 
-            auto fz_array  = fz.array(mfi);
+            const auto fz_array = (cfl_max > 0.0) ? Array4<Real>{} : fz.array(mfi);
 
             // Expose for GPU
             Real d_fac_cond = m_fac_cond;
@@ -93,18 +113,27 @@ void Kessler::AdvanceKessler (const SolverChoice &solverChoice)
                 // Jacobian determinant
                 Real dJinv = (dJ_array) ? 1.0/dJ_array(i,j,k) : 1.0;
 
-                qv_array(i,j,k) = std::max(0.0, qv_array(i,j,k));
-                qc_array(i,j,k) = std::max(0.0, qc_array(i,j,k));
-                qp_array(i,j,k) = std::max(0.0, qp_array(i,j,k));
+                Real rho   = states_array(i,j,k,Rho_comp);
+                Real theta = states_array(i,j,k,RhoTheta_comp)/rho;
+                Real qv    = states_array(i,j,k,RhoQ1_comp)/rho;
+                Real qc    = states_array(i,j,k,RhoQ2_comp)/rho;
+                Real qp    = states_array(i,j,k,RhoQ3_comp)/rho;
+
+                // Temperature and pressure [mbar] before the update
+                Real tabs     = getTgivenRandRTh(rho, states_array(i,j,k,RhoTheta_comp), qv);
+                Real pressure = getPgivenRTh(states_array(i,j,k,RhoTheta_comp), qv)/100.;
+
+                qv = std::max(0.0, qv);
+                qc = std::max(0.0, qc);
+                qp = std::max(0.0, qp);
 
                 //------- Autoconversion/accretion
                 Real qcc, auto_r, accrr;
                 Real qsat, dtqsat;
                 Real dq_clwater_to_rain, dq_rain_to_vapor, dq_clwater_to_vapor, dq_vapor_to_clwater;
 
-                Real pressure = pres_array(i,j,k);
-                erf_qsatw(tabs_array(i,j,k), pressure, qsat);
-                erf_dtqsatw(tabs_array(i,j,k), pressure, dtqsat);
+                erf_qsatw(tabs, pressure, qsat, sat);
+                erf_dtqsatw(tabs, pressure, dtqsat, sat);
 
                 if (qsat <= 0.0) {
                     amrex::Warning("qsat computed as non-positive; setting to 0.!");
@@ -120,35 +149,35 @@ void Kessler::AdvanceKessler (const SolverChoice &solverChoice)
                 dq_vapor_to_clwater = 0.0;
                 dq_clwater_to_vapor = 0.0;
 
-                //Real fac = qsat*4093.0*L_v/(Cp_d*std::pow(tabs_array(i,j,k)-36.0,2));
-                //Real fac = qsat*L_v*L_v/(Cp_d*R_v*tabs_array(i,j,k)*tabs_array(i,j,k));
+                //Real fac = qsat*4093.0*L_v/(Cp_d*std::pow(tabs-36.0,2));
+                //Real fac = qsat*L_v*L_v/(Cp_d*R_v*tabs*tabs);
                 Real fac = 1.0 + (L_v/Cp_d)*dtqsat;
 
                 // If water vapor content exceeds saturation value, then vapor condenses to water and latent heat is released, increasing temperature
-                if (qv_array(i,j,k) > qsat) {
-                    dq_vapor_to_clwater = std::min(qv_array(i,j,k), (qv_array(i,j,k)-qsat)/(1.0 + fac));
+                if (qv > qsat) {
+                    dq_vapor_to_clwater = std::min(qv, (qv-qsat)/(1.0 + fac));
                 }
 
                 // If water vapor is less than the saturated value, then the cloud water can evaporate,
                 // leading to evaporative cooling and reducing temperature
-                if (qv_array(i,j,k) < qsat && qc_array(i,j,k) > 0.0) {
-                    dq_clwater_to_vapor = std::min(qc_array(i,j,k), (qsat - qv_array(i,j,k))/(1.0 + fac));
+                if (qv < qsat && qc > 0.0) {
+                    dq_clwater_to_vapor = std::min(qc, (qsat - qv)/(1.0 + fac));
                 }
 
-                if (qp_array(i,j,k) > 0.0 && qv_array(i,j,k) < qsat) {
-                    Real C = 1.6 + 124.9*std::pow(0.001*rho_array(i,j,k)*qp_array(i,j,k),0.2046);
-                    dq_rain_to_vapor = 1.0/(0.001*rho_array(i,j,k))*(1.0 - qv_array(i,j,k)/qsat)*C*std::pow(0.001*rho_array(i,j,k)*qp_array(i,j,k),0.525)/
+                if (qp > 0.0 && qv < qsat) {
+                    Real C = 1.6 + 124.9*std::pow(0.001*rho*qp,0.2046);
+                    dq_rain_to_vapor = 1.0/(0.001*rho)*(1.0 - qv/qsat)*C*std::pow(0.001*rho*qp,0.525)/
                         (5.4e5 + 2.55e6/(pressure*qsat))*dtn;
                     // The negative sign is to make this variable (vapor formed from evaporation)
                     // a positive quantity (as qv/qs < 1)
-                    dq_rain_to_vapor = std::min({qp_array(i,j,k), dq_rain_to_vapor});
+                    dq_rain_to_vapor = std::min({qp, dq_rain_to_vapor});
 
                     // Removing latent heat due to evaporation from rain water to water vapor, reduces the (potential) temperature
                 }
 
                 // If there is cloud water present then do accretion and autoconversion to rain
-                if (qc_array(i,j,k) > 0.0) {
-                    qcc = qc_array(i,j,k);
+                if (qc > 0.0) {
+                    qcc = qc;
 
                     auto_r = 0.0;
                     if (qcc > qcw0) {
@@ -156,30 +185,41 @@ void Kessler::AdvanceKessler (const SolverChoice &solverChoice)
                     }
 
                     accrr = 0.0;
-                    accrr = 2.2 * std::pow(qp_array(i,j,k) , 0.875);
+                    accrr = 2.2 * std::pow(qp , 0.875);
                     dq_clwater_to_rain = dtn *(accrr*qcc + auto_r*(qcc - qcw0));
 
                     // If the amount of change is more than the amount of qc present, then dq = qc
-                    dq_clwater_to_rain = std::min(dq_clwater_to_rain, qc_array(i,j,k));
+                    dq_clwater_to_rain = std::min(dq_clwater_to_rain, qc);
                 }
 
-                if(std::fabs(fz_array(i,j,k+1)) < 1e-14) fz_array(i,j,k+1) = 0.0;
-                if(std::fabs(fz_array(i,j,k  )) < 1e-14) fz_array(i,j,k  ) = 0.0;
-                Real dq_sed = dtn * dJinv * (1.0/rho_array(i,j,k)) * (fz_array(i,j,k+1) - fz_array(i,j,k))/dz;
-                if(std::fabs(dq_sed) < 1e-14) dq_sed = 0.0;
+                Real dq_sed = 0.0;
+                if (fz_array) {
+                    if(std::fabs(fz_array(i,j,k+1)) < 1e-14) fz_array(i,j,k+1) = 0.0;
+                    if(std::fabs(fz_array(i,j,k  )) < 1e-14) fz_array(i,j,k  ) = 0.0;
+                    dq_sed = dtn * dJinv * (1.0/rho) * (fz_array(i,j,k+1) - fz_array(i,j,k))/dz;
+                    if(std::fabs(dq_sed) < 1e-14) dq_sed = 0.0;
+                }
+
+                qv += -dq_vapor_to_clwater + dq_clwater_to_vapor + dq_rain_to_vapor;
+                qc +=  dq_vapor_to_clwater - dq_clwater_to_vapor - dq_clwater_to_rain;
+                qp +=  dq_sed + dq_clwater_to_rain - dq_rain_to_vapor;
 
-                qv_array(i,j,k) += -dq_vapor_to_clwater + dq_clwater_to_vapor + dq_rain_to_vapor;
-                qc_array(i,j,k) +=  dq_vapor_to_clwater - dq_clwater_to_vapor - dq_clwater_to_rain;
-                qp_array(i,j,k) +=  dq_sed + dq_clwater_to_rain - dq_rain_to_vapor;
+                Real theta_over_T = theta/tabs;
+                theta += theta_over_T * d_fac_cond * (dq_vapor_to_clwater - dq_clwater_to_vapor - dq_rain_to_vapor);
 
-                Real theta_over_T = theta_array(i,j,k)/tabs_array(i,j,k);
-                theta_array(i,j,k) += theta_over_T * d_fac_cond * (dq_vapor_to_clwater - dq_clwater_to_vapor - dq_rain_to_vapor);
+                qv = std::max(0.0, qv);
+                qc = std::max(0.0, qc);
+                qp = std::max(0.0, qp);
 
-                qv_array(i,j,k) = std::max(0.0, qv_array(i,j,k));
-                qc_array(i,j,k) = std::max(0.0, qc_array(i,j,k));
-                qp_array(i,j,k) = std::max(0.0, qp_array(i,j,k));
+                states_array(i,j,k,RhoTheta_comp) = rho*theta;
+                states_array(i,j,k,RhoQ1_comp)    = rho*qv;
+                states_array(i,j,k,RhoQ2_comp)    = rho*qc;
+                states_array(i,j,k,RhoQ3_comp)    = rho*qp;
 
-                qt_array(i,j,k) = qv_array(i,j,k) + qc_array(i,j,k);
+                qv_array(i,j,k) = qv;
+                qc_array(i,j,k) = qc;
+                qp_array(i,j,k) = qp;
+                qt_array(i,j,k) = qv + qc;
             });
         }
     }
@@ -187,13 +227,14 @@ void Kessler::AdvanceKessler (const SolverChoice &solverChoice)
     if (solverChoice.moisture_type == MoistureType::Kessler_NoRain){
 
         // get the temperature, dentisy, theta, qt and qc from input
-        for ( MFIter mfi(*tabs,TilingIfNotGPU()); mfi.isValid(); ++mfi) {
+        for ( MFIter mfi(cons,TilingIfNotGPU()); mfi.isValid(); ++mfi) {
+            BoxCostTimer box_timer(m_box_cost, mfi);
+            auto states_array = cons.array(mfi);
+
             auto qv_array    = mic_fab_vars[MicVar_Kess::qv]->array(mfi);
             auto qc_array    = mic_fab_vars[MicVar_Kess::qcl]->array(mfi);
+            auto qp_array    = mic_fab_vars[MicVar_Kess::qp]->array(mfi);
             auto qt_array    = mic_fab_vars[MicVar_Kess::qt]->array(mfi);
-            auto tabs_array  = mic_fab_vars[MicVar_Kess::tabs]->array(mfi);
-            auto theta_array = mic_fab_vars[MicVar_Kess::theta]->array(mfi);
-            auto pres_array  = mic_fab_vars[MicVar_Kess::pres]->array(mfi);
 
             const auto& box3d = mfi.tilebox();
 
@@ -202,15 +243,23 @@ void Kessler::AdvanceKessler (const SolverChoice &solverChoice)
 
             ParallelFor(box3d, [=] AMREX_GPU_DEVICE(int i, int j, int k) noexcept
             {
-                qc_array(i,j,k) = std::max(0.0, qc_array(i,j,k));
+                Real rho   = states_array(i,j,k,Rho_comp);
+                Real theta = states_array(i,j,k,RhoTheta_comp)/rho;
+                Real qv    = states_array(i,j,k,RhoQ1_comp)/rho;
+                Real qc    = states_array(i,j,k,RhoQ2_comp)/rho;
+
+                // Temperature and pressure [mbar] before the update
+                Real tabs     = getTgivenRandRTh(rho, states_array(i,j,k,RhoTheta_comp), qv);
+                Real pressure = getPgivenRTh(states_array(i,j,k,RhoTheta_comp), qv)/100.;
+
+                qc = std::max(0.0, qc);
 
                 //------- Autoconversion/accretion
                 Real qsat, dtqsat;
                 Real dq_clwater_to_vapor, dq_vapor_to_clwater;
 
-                Real pressure = pres_array(i,j,k);
-                erf_qsatw(tabs_array(i,j,k), pressure, qsat);
-                erf_dtqsatw(tabs_array(i,j,k), pressure, dtqsat);
+                erf_qsatw(tabs, pressure, qsat, sat);
+                erf_dtqsatw(tabs, pressure, dtqsat, sat);
 
                 // If there is precipitating water (i.e. rain), and the cell is not saturated
                 // then the rain water can evaporate leading to extraction of latent heat, hence
@@ -219,32 +268,154 @@ void Kessler::AdvanceKessler (const SolverChoice &solverChoice)
                 dq_vapor_to_clwater = 0.0;
                 dq_clwater_to_vapor = 0.0;
 
-                //Real fac = qsat*4093.0*L_v/(Cp_d*std::pow(tabs_array(i,j,k)-36.0,2));
-                //Real fac = qsat*L_v*L_v/(Cp_d*R_v*tabs_array(i,j,k)*tabs_array(i,j,k));
+                //Real fac = qsat*4093.0*L_v/(Cp_d*std::pow(tabs-36.0,2));
+                //Real fac = qsat*L_v*L_v/(Cp_d*R_v*tabs*tabs);
                 Real fac = 1.0 + (L_v/Cp_d)*dtqsat;
 
                 // If water vapor content exceeds saturation value, then vapor condenses to water and latent heat is released, increasing temperature
-                if (qv_array(i,j,k) > qsat){
-                    dq_vapor_to_clwater = std::min(qv_array(i,j,k), (qv_array(i,j,k)-qsat)/(1.0 + fac));
+                if (qv > qsat){
+                    dq_vapor_to_clwater = std::min(qv, (qv-qsat)/(1.0 + fac));
                 }
                 // If water vapor is less than the saturated value, then the cloud water can evaporate, leading to evaporative cooling and
                 // reducing temperature
-                if (qv_array(i,j,k) < qsat && qc_array(i,j,k) > 0.0){
-                    dq_clwater_to_vapor = std::min(qc_array(i,j,k), (qsat - qv_array(i,j,k))/(1.0 + fac));
+                if (qv < qsat && qc > 0.0){
+                    dq_clwater_to_vapor = std::min(qc, (qsat - qv)/(1.0 + fac));
                 }
 
-                qv_array(i,j,k) += -dq_vapor_to_clwater + dq_clwater_to_vapor;
-                qc_array(i,j,k) +=  dq_vapor_to_clwater - dq_clwater_to_vapor;
+                qv += -dq_vapor_to_clwater + dq_clwater_to_vapor;
+                qc +=  dq_vapor_to_clwater - dq_clwater_to_vapor;
 
-                Real theta_over_T = theta_array(i,j,k)/tabs_array(i,j,k);
+                Real theta_over_T = theta/tabs;
 
-                theta_array(i,j,k) += theta_over_T * d_fac_cond * (dq_vapor_to_clwater - dq_clwater_to_vapor);
+                theta += theta_over_T * d_fac_cond * (dq_vapor_to_clwater - dq_clwater_to_vapor);
 
-                qv_array(i,j,k) = std::max(0.0, qv_array(i,j,k));
-                qc_array(i,j,k) = std::max(0.0, qc_array(i,j,k));
+                qv = std::max(0.0, qv);
+                qc = std::max(0.0, qc);
 
-                qt_array(i,j,k) = qv_array(i,j,k) + qc_array(i,j,k);
+                states_array(i,j,k,RhoTheta_comp) = rho*theta;
+                states_array(i,j,k,RhoQ1_comp)    = rho*qv;
+                states_array(i,j,k,RhoQ2_comp)    = rho*qc;
+
+                qv_array(i,j,k) = qv;
+                qc_array(i,j,k) = qc;
+                qp_array(i,j,k) = states_array(i,j,k,RhoQ3_comp)/rho;
+                qt_array(i,j,k) = qv + qc;
             });
         }
     }
 }
+
+/**
+ * Sedimentation of rain with substeps in each column, as many as the largest
+ * fall-speed CFL number of the column over the step needs. Each column is swept
+ * bottom to top, so the flux through the top of a cell is formed before that
+ * cell is updated.
+ *
+ * @param[in] cfl_max Largest CFL number of a substep
+ * @param[in] nsub_limit Largest number of substeps of a column
+ */
+void Kessler::RainFall (const Real& cfl_max, const int& nsub_limit)
+{
+    BL_PROFILE("Kessler::RainFall()");
+
+    MultiFab& cons = *m_cons;
+
+    Real dz    = m_geom.CellSize(2);
+    Real dzinv = 1.0/dz;
+    Real dtn   = dt;
+
+    auto domain = m_geom.Domain();
+    int k_lo = domain.smallEnd(2);
+    int k_hi = domain.bigEnd(2);
+
+    // Largest and summed numbers of substeps over the columns, and number of limited columns
+    ReduceOps<ReduceOpMax, ReduceOpSum, ReduceOpSum> reduce_op;
+    ReduceData<int, Long, Long> reduce_data(reduce_op);
+    using ReduceTuple = typename decltype(reduce_data)::Type;
+    Long ncol = 0;
+
+    for ( MFIter mfi(cons, TileNoZ()); mfi.isValid(); ++mfi ){
+        BoxCostTimer box_timer(m_box_cost, mfi);
+        auto states_array = cons.array(mfi);
+        auto rain_accum_array = mic_fab_vars[MicVar_Kess::rain_accum]->array(mfi);
+
+        const auto dJ_array = (m_detJ_cc) ? m_detJ_cc->const_array(mfi) : Array4<const Real>{};
+
+        const Box& box3d = mfi.tilebox();
+
+        // Substeps would lag the fluxes through faces shared with other boxes
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(box3d.smallEnd(2) == k_lo && box3d.bigEnd(2) == k_hi,
+                                         "erf.sedimentation_cfl requires grids that span the domain vertically");
+
+        const Box cbx = makeSlab(box3d, 2, k_lo);
+        ncol += cbx.numPts();
+
+        reduce_op.eval(cbx, reduce_data,
+        [=] AMREX_GPU_DEVICE (int i, int j, int) -> ReduceTuple
+        {
+            // Flux through the bottom face of cell k and the fall speed there
+            auto flux = [=] (int k, Real& rho_avg, Real& qp_avg, Real& V_terminal) {
+                if (k==k_lo) {
+                    rho_avg = states_array(i,j,k,Rho_comp);
+                    qp_avg  = states_array(i,j,k,RhoQ3_comp)/states_array(i,j,k,Rho_comp);
+                } else if (k==k_hi+1) {
+                    rho_avg = states_array(i,j,k-1,Rho_comp);
+                    qp_avg  = states_array(i,j,k-1,RhoQ3_comp)/states_array(i,j,k-1,Rho_comp);
+                } else {
+                    rho_avg = 0.5*(states_array(i,j,k-1,Rho_comp) + states_array(i,j,k,Rho_comp));
+                    qp_avg  = 0.5*(states_array(i,j,k-1,RhoQ3_comp)/states_array(i,j,k-1,Rho_comp)
+                                 + states_array(i,j,k  ,RhoQ3_comp)/states_array(i,j,k  ,Rho_comp));
+                }
+
+                qp_avg = std::max(0.0, qp_avg);
+
+                V_terminal = 36.34*std::pow(rho_avg*0.001*qp_avg, 0.1346)*std::pow(rho_avg/1.16, -0.5); // in m/s
+
+                return rho_avg*V_terminal*qp_avg;
+            };
+
+            Real rho_avg, qp_avg, V_terminal;
+
+            // Substeps from the largest CFL number of the column over the whole step
+            Real cfl = 0.0;
+            for (int k = k_lo; k <= k_hi; ++k) {
+                Real dJinv = (dJ_array) ? 1.0/dJ_array(i,j,k) : 1.0;
+                flux(k, rho_avg, qp_avg, V_terminal);
+                cfl = amrex::max(cfl, V_terminal * dtn * dzinv * dJinv);
+            }
+            int nsub = erf_sedimentation_substeps(cfl, cfl_max, nsub_limit);
+
+            Real dts = dtn/nsub;
+
+            for (int n = 0; n < nsub; ++n) {
+                Real fz_lo = flux(k_lo, rho_avg, qp_avg, V_terminal);
+
+                rain_accum_array(i,j,k_lo) = rain_accum_array(i,j,k_lo) + rho_avg*qp_avg*V_terminal*dts/1000.0*1000.0; // Divide by rho_water and convert to mm
+
+                for (int k = k_lo; k <= k_hi; ++k) {
+                    // The face above reads cell k before it is updated
+                    Real fz_hi = flux(k+1, rho_avg, qp_avg, V_terminal);
+
+                    // Jacobian determinant
+                    Real dJinv = (dJ_array) ? 1.0/dJ_array(i,j,k) : 1.0;
+
+                    Real rho = states_array(i,j,k,Rho_comp);
+                    Real qp  = std::max(0.0, states_array(i,j,k,RhoQ3_comp)/rho);
+
+                    Real dq_sed = dts * dJinv * (1.0/rho) * (fz_hi - fz_lo) * dzinv;
+
+                    states_array(i,j,k,RhoQ3_comp) = rho*std::max(0.0, qp + dq_sed);
+
+                    fz_lo = fz_hi;
+                }
+            }
+
+            return {nsub, static_cast<Long>(nsub),
+                    static_cast<Long>(erf_sedimentation_clamped(cfl, cfl_max, nsub_limit))};
+        });
+    }
+
+    ReduceTuple r = reduce_data.value(reduce_op);
+    erf_report_substeps("Kessler::RainFall()", amrex::get<0>(r), amrex::get<1>(r), ncol,
+                        amrex::get<2>(r), nsub_limit);
+}
@@ -2,15 +2,19 @@
 #include "ERF_IndexDefines.H"
 #include "ERF_TileNoZ.H"
 #include "ERF_EOS.H"
+#include "ERF_ParFunctions.H"
 
 using namespace amrex;
 
 /**
  * Split cloud components according to saturation pressures; source theta from latent heat.
+ *
+ * @param[in] sc Solver choice
  */
 void
 SAM::Cloud (const SolverChoice& sc)
 {
+    BL_PROFILE("SAM::Cloud()");
 
     constexpr Real an = 1.0/(tbgmax-tbgmin);
     constexpr Real bn = tbgmin*an;
@@ -26,22 +30,30 @@ SAM::Cloud (const SolverChoice& sc)
         SAM_moisture_type = 2;
     }
 
-    for ( MFIter mfi(*(mic_fab_vars[MicVar::tabs]), TilingIfNotGPU()); mfi.isValid(); ++mfi) {
-        auto  qt_array = mic_fab_vars[MicVar::qt]->array(mfi);
-        auto  qn_array = mic_fab_vars[MicVar::qn]->array(mfi);
-        auto  qv_array = mic_fab_vars[MicVar::qv]->array(mfi);
-        auto qcl_array = mic_fab_vars[MicVar::qcl]->array(mfi);
-        auto qci_array = mic_fab_vars[MicVar::qci]->array(mfi);
+    const SatTableView sat = m_sat_table.view();
 
-        auto   rho_array = mic_fab_vars[MicVar::rho]->array(mfi);
-        auto  tabs_array = mic_fab_vars[MicVar::tabs]->array(mfi);
-        auto theta_array = mic_fab_vars[MicVar::theta]->array(mfi);
-        auto  pres_array = mic_fab_vars[MicVar::pres]->array(mfi);
+    MultiFab& cons = *m_cons;
+
+    for ( MFIter mfi(cons, TilingIfNotGPU()); mfi.isValid(); ++mfi) {
+        BoxCostTimer box_timer(m_box_cost, mfi);
+        auto states_array = cons.array(mfi);
 
         const auto& box3d = mfi.tilebox();
 
         ParallelFor(box3d, [=] AMREX_GPU_DEVICE (int i, int j, int k)
         {
+            Real rho   = states_array(i,j,k,Rho_comp);
+            Real theta = states_array(i,j,k,RhoTheta_comp)/rho;
+            Real qv    = std::max(0.0,states_array(i,j,k,RhoQ1_comp)/rho);
+            Real qcl   = std::max(0.0,states_array(i,j,k,RhoQ2_comp)/rho);
+            Real qci   = std::max(0.0,states_array(i,j,k,RhoQ3_comp)/rho);
+            Real qn    = qcl + qci;
+            Real qt    = qv + qn;
+
+            // Temperature and pressure [mbar] of the cell
+            Real tabs_c = getTgivenRandRTh(rho, rho*theta, qv);
+            Real pres_c = getPgivenRTh(rho*theta, qv) * 0.01;
+
             // Saturation moisture fractions
             Real omn;
             Real qsat;
@@ -59,75 +71,71 @@ SAM::Cloud (const SolverChoice& sc)
             omn = 1.0;
             if (SAM_moisture_type == 1){
                 // Cloud ice not permitted (melt to form water)
-                if (tabs_array(i,j,k) >= tbgmax) {
+                if (tabs_c >= tbgmax) {
                     omn = 1.0;
-                    delta_qi = qci_array(i,j,k);
-                    qci_array(i,j,k)   = 0.0;
-                    qcl_array(i,j,k)  += delta_qi;
-                    tabs_array(i,j,k) -= fac_fus * delta_qi;
-                    pres_array(i,j,k)  = rho_array(i,j,k) * R_d * tabs_array(i,j,k)
-                                         * (1.0 + R_v/R_d * qv_array(i,j,k));
-                    theta_array(i,j,k) = getThgivenPandT(tabs_array(i,j,k), pres_array(i,j,k), rdOcp);
-                    pres_array(i,j,k) *= 0.01;
+                    delta_qi = qci;
+                    qci     = 0.0;
+                    qcl    += delta_qi;
+                    tabs_c -= fac_fus * delta_qi;
+                    pres_c  = rho * R_d * tabs_c * (1.0 + R_v/R_d * qv);
+                    theta   = getThgivenPandT(tabs_c, pres_c, rdOcp);
+                    pres_c *= 0.01;
                 }
                 // Cloud water not permitted (freeze to form ice)
-                else if (tabs_array(i,j,k) <= tbgmin) {
+                else if (tabs_c <= tbgmin) {
                     omn = 0.0;
-                    delta_qc = qcl_array(i,j,k);
-                    qcl_array(i,j,k)   = 0.0;
-                    qci_array(i,j,k)  += delta_qc;
-                    tabs_array(i,j,k) += fac_fus * delta_qc;
-                    pres_array(i,j,k)  = rho_array(i,j,k) * R_d * tabs_array(i,j,k)
-                                         * (1.0 + R_v/R_d * qv_array(i,j,k));
-                    theta_array(i,j,k) = getThgivenPandT(tabs_array(i,j,k), pres_array(i,j,k), rdOcp);
-                    pres_array(i,j,k) *= 0.01;
+                    delta_qc = qcl;
+                    qcl     = 0.0;
+                    qci    += delta_qc;
+                    tabs_c += fac_fus * delta_qc;
+                    pres_c  = rho * R_d * tabs_c * (1.0 + R_v/R_d * qv);
+                    theta   = getThgivenPandT(tabs_c, pres_c, rdOcp);
+                    pres_c *= 0.01;
                 }
                 // Mixed cloud phase (split according to omn)
                 else {
-                    omn = an*tabs_array(i,j,k)-bn;
-                    delta_qc = qcl_array(i,j,k) - qn_array(i,j,k) * omn;
-                    delta_qi = qci_array(i,j,k) - qn_array(i,j,k) * (1.0 - omn);
-                    qcl_array(i,j,k)   = qn_array(i,j,k) * omn;
-                    qci_array(i,j,k)   = qn_array(i,j,k) * (1.0 - omn);
-                    tabs_array(i,j,k) += fac_fus * delta_qc;
-                    pres_array(i,j,k)  = rho_array(i,j,k) * R_d * tabs_array(i,j,k)
-                                         * (1.0 + R_v/R_d * qv_array(i,j,k));
-                    theta_array(i,j,k) = getThgivenPandT(tabs_array(i,j,k), pres_array(i,j,k), rdOcp);
-                    pres_array(i,j,k) *= 0.01;
+                    omn = an*tabs_c-bn;
+                    delta_qc = qcl - qn * omn;
+                    delta_qi = qci - qn * (1.0 - omn);
+                    qcl     = qn * omn;
+                    qci     = qn * (1.0 - omn);
+                    tabs_c += fac_fus * delta_qc;
+                    pres_c  = rho * R_d * tabs_c * (1.0 + R_v/R_d * qv);
+                    theta   = getThgivenPandT(tabs_c, pres_c, rdOcp);
+                    pres_c *= 0.01;
                 }
             }
             else if (SAM_moisture_type == 2)
             {
                 // No ice. ie omn = 1.0
-                delta_qc = qcl_array(i,j,k) - qn_array(i,j,k);
+                delta_qc = qcl - qn;
                 delta_qi = 0.0;
-                qcl_array(i,j,k)   = qn_array(i,j,k);
-                qci_array(i,j,k)   = 0.0;
-                tabs_array(i,j,k) += fac_cond * delta_qc;
-                pres_array(i,j,k)  = rho_array(i,j,k) * R_d * tabs_array(i,j,k)
-                                     * (1.0 + R_v/R_d * qv_array(i,j,k));
-                theta_array(i,j,k) = getThgivenPandT(tabs_array(i,j,k), pres_array(i,j,k), rdOcp);
-                pres_array(i,j,k) *= 0.01;
+                qcl     = qn;
+                qci     = 0.0;
+                tabs_c += fac_cond * delta_qc;
+                pres_c  = rho * R_d * tabs_c * (1.0 + R_v/R_d * qv);
+                theta   = getThgivenPandT(tabs_c, pres_c, rdOcp);
+                pres_c *= 0.01;
             }
 
             // Saturation moisture fractions
-            erf_qsatw(tabs_array(i,j,k), pres_array(i,j,k), qsatw);
-            erf_qsati(tabs_array(i,j,k), pres_array(i,j,k), qsati);
+            erf_qsatw(tabs_c, pres_c, qsatw, sat);
+            erf_qsati(tabs_c, pres_c, qsati, sat);
             qsat = omn * qsatw  + (1.0-omn) * qsati;
 
             // We have enough total moisture to relax to equilibrium
-            if (qt_array(i,j,k) > qsat) {
+            if (qt > qsat) {
 
                 // Update temperature
-                tabs_array(i,j,k) = NewtonIterSat(i, j, k   , SAM_moisture_type   ,
-                                                  fac_cond  , fac_fus   , fac_sub ,
-                                                  an        , bn        ,
-                                                  tabs_array, pres_array,
-                                                  qv_array  , qcl_array  , qci_array,
-                                                  qn_array  , qt_array);
+                tabs_c = NewtonIterSat(SAM_moisture_type,
+                                       fac_cond, fac_fus, fac_sub,
+                                       an      , bn     , sat,
+                                       tabs_c  , pres_c ,
+                                       qv      , qcl    , qci    ,
+                                       qn      , qt);
 
                 // Update theta
-                theta_array(i,j,k) = getThgivenPandT(tabs_array(i,j,k), 100.0*pres_array(i,j,k), rdOcp);
+                theta = getThgivenPandT(tabs_c, 100.0*pres_c, rdOcp);
 
             //
             // We cannot blindly relax to qsat, but we can convert qc/qi -> qv.
@@ -138,42 +146,47 @@ SAM::Cloud (const SolverChoice& sc)
             //
             } else {
                 // Changes in each component
-                delta_qv = qcl_array(i,j,k) + qci_array(i,j,k);
-                delta_qc = qcl_array(i,j,k);
-                delta_qi = qci_array(i,j,k);
+                delta_qv = qcl + qci;
+                delta_qc = qcl;
+                delta_qi = qci;
 
                 // Partition the change in non-precipitating q
-                 qv_array(i,j,k) += delta_qv;
-                qcl_array(i,j,k)  = 0.0;
-                qci_array(i,j,k)  = 0.0;
-                 qn_array(i,j,k)  = 0.0;
-                 qt_array(i,j,k)  = qv_array(i,j,k);
+                qv  += delta_qv;
+                qcl  = 0.0;
+                qci  = 0.0;
+                qn   = 0.0;
+                qt   = qv;
 
                 // Update temperature (endothermic since we evap/sublime)
-                tabs_array(i,j,k) -= fac_cond * delta_qc + fac_sub * delta_qi;
+                tabs_c -= fac_cond * delta_qc + fac_sub * delta_qi;
 
                 // Update theta
-                theta_array(i,j,k) = getThgivenPandT(tabs_array(i,j,k), 100.0*pres_array(i,j,k), rdOcp);
+                theta = getThgivenPandT(tabs_c, 100.0*pres_c, rdOcp);
 
                 // Verify assumption that qv > qsat does not occur
-                erf_qsatw(tabs_array(i,j,k), pres_array(i,j,k), qsatw);
-                erf_qsati(tabs_array(i,j,k), pres_array(i,j,k), qsati);
+                erf_qsatw(tabs_c, pres_c, qsatw, sat);
+                erf_qsati(tabs_c, pres_c, qsati, sat);
                 qsat = omn * qsatw  + (1.0-omn) * qsati;
-                if (qt_array(i,j,k) > qsat) {
+                if (qt > qsat) {
 
                     // Update temperature
-                    tabs_array(i,j,k) = NewtonIterSat(i, j, k   , SAM_moisture_type   ,
-                                                      fac_cond  , fac_fus   , fac_sub ,
-                                                      an        , bn        ,
-                                                      tabs_array, pres_array,
-                                                      qv_array  , qcl_array  , qci_array,
-                                                      qn_array  , qt_array);
+                    tabs_c = NewtonIterSat(SAM_moisture_type,
+                                           fac_cond, fac_fus, fac_sub,
+                                           an      , bn     , sat,
+                                           tabs_c  , pres_c ,
+                                           qv      , qcl    , qci    ,
+                                           qn      , qt);
 
                     // Update theta
-                    theta_array(i,j,k) = getThgivenPandT(tabs_array(i,j,k), 100.0*pres_array(i,j,k), rdOcp);
+                    theta = getThgivenPandT(tabs_c, 100.0*pres_c, rdOcp);
 
                 }
             }
+
+            states_array(i,j,k,RhoTheta_comp) = rho*theta;
+            states_array(i,j,k,RhoQ1_comp)    = rho*std::max(0.0,qv);
+            states_array(i,j,k,RhoQ2_comp)    = rho*std::max(0.0,qcl);
+            states_array(i,j,k,RhoQ3_comp)    = rho*std::max(0.0,qci);
         });
     } // mfi
 }
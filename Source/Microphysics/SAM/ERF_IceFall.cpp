@@ -1,103 +1,146 @@
-#include <AMReX_ParReduce.H>
+#include <AMReX_Reduce.H>
 #include "ERF_SAM.H"
 #include "ERF_TileNoZ.H"
+#include "ERF_ParFunctions.H"
 
 using namespace amrex;
 
 /**
  * Sedimentation of cloud ice (A32)
+ *
+ * Each column is swept bottom to top, so the flux through the top of a cell is
+ * formed before that cell is updated. If erf.sedimentation_cfl is set, a column
+ * takes as many substeps as its largest fall-speed CFL number over the step needs.
  */
 void SAM::IceFall (const SolverChoice& sc) {
 
+    BL_PROFILE("SAM::IceFall()");
+
     if(sc.moisture_type == MoistureType::SAM_NoIce ||
        sc.moisture_type == MoistureType::SAM_NoPrecip_NoIce)
       return;
 
-    Real dz   = m_geom.CellSize(2);
-    Real dtn  = dt;
-    Real coef = dtn/dz;
+    Real dz    = m_geom.CellSize(2);
+    Real dzinv = 1.0/dz;
+    Real dtn   = dt;
+
+    Real cfl_max    = sc.sedimentation_cfl;
+    int  nsub_limit = sc.sedimentation_max_substeps;
 
     auto domain = m_geom.Domain();
     int k_lo = domain.smallEnd(2);
     int k_hi = domain.bigEnd(2);
 
-    auto qcl   = mic_fab_vars[MicVar::qcl];
-    auto qci   = mic_fab_vars[MicVar::qci];
-    auto qn    = mic_fab_vars[MicVar::qn];
-    auto qt    = mic_fab_vars[MicVar::qt];
-    auto rho   = mic_fab_vars[MicVar::rho];
-    auto tabs  = mic_fab_vars[MicVar::tabs];
-
-    MultiFab fz;
-    IntVect  ng = qcl->nGrowVect();
-    BoxArray ba = qcl->boxArray();
-    DistributionMapping dm = qcl->DistributionMap();
-    fz.define(convert(ba, IntVect(0,0,1)), dm, 1, ng);
-    fz.setVal(0.);
-
-    for (MFIter mfi(fz, TileNoZ()); mfi.isValid(); ++mfi) {
-        auto qci_array = qci->array(mfi);
-        auto rho_array = rho->array(mfi);
-        auto fz_array  = fz.array(mfi);
+    MultiFab& cons = *m_cons;
+
+    // Largest and summed numbers of substeps over the columns, and number of limited columns
+    ReduceOps<ReduceOpMax, ReduceOpSum, ReduceOpSum> reduce_op;
+    ReduceData<int, Long, Long> reduce_data(reduce_op);
+    using ReduceTuple = typename decltype(reduce_data)::Type;
+    Long ncol = 0;
+
+    for (MFIter mfi(cons, TileNoZ()); mfi.isValid(); ++mfi) {
+        BoxCostTimer box_timer(m_box_cost, mfi);
+        auto states_array = cons.array(mfi);
+
+        const auto dJ_array = (m_detJ_cc) ? m_detJ_cc->const_array(mfi) : Array4<const Real>{};
 
         const auto& box3d  = mfi.tilebox();
 
-        ParallelFor(box3d, [=] AMREX_GPU_DEVICE(int i, int j, int k) noexcept
+        // Substeps would lag the fluxes through faces shared with other boxes
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(cfl_max == 0.0 || (box3d.smallEnd(2) == k_lo && box3d.bigEnd(2) == k_hi),
+                                         "erf.sedimentation_cfl requires grids that span the domain vertically");
+
+        const int klo = box3d.smallEnd(2);
+        const int khi = box3d.bigEnd(2);
+        const Box cbx = makeSlab(box3d, 2, klo);
+        ncol += cbx.numPts();
+
+        reduce_op.eval(cbx, reduce_data,
+        [=] AMREX_GPU_DEVICE (int i, int j, int) -> ReduceTuple
         {
-            Real rho_avg, qci_avg;
-            if (k==k_lo) {
-                rho_avg = rho_array(i,j,k);
-                qci_avg = qci_array(i,j,k);
-            } else if (k==k_hi+1) {
-                rho_avg = rho_array(i,j,k-1);
-                qci_avg = qci_array(i,j,k-1);
-            } else {
-                rho_avg = 0.5*(rho_array(i,j,k-1) + rho_array(i,j,k));
-                qci_avg = 0.5*(qci_array(i,j,k-1) + qci_array(i,j,k));
+            auto qci = [=] (int kk) {
+                return std::max(0.0, states_array(i,j,kk,RhoQ3_comp)/states_array(i,j,kk,Rho_comp));
+            };
+
+            // Flux through the bottom face of cell k and the fall speed there
+            auto flux = [=] (int k, Real& vt_ice) {
+                Real rho_avg, qci_avg;
+                if (k==k_lo) {
+                    rho_avg = states_array(i,j,k,Rho_comp);
+                    qci_avg = qci(k);
+                } else if (k==k_hi+1) {
+                    rho_avg = states_array(i,j,k-1,Rho_comp);
+                    qci_avg = qci(k-1);
+                } else {
+                    rho_avg = 0.5*(states_array(i,j,k-1,Rho_comp) + states_array(i,j,k,Rho_comp));
+                    qci_avg = 0.5*(qci(k-1) + qci(k));
+                }
+                vt_ice = min( 0.4 , 8.66 * pow( (max(0.,qci_avg)+1.e-10) , 0.24) );
+
+                // NOTE: Fz is the sedimentation flux from the advective operator.
+                //       In the terrain-following coordinate system, the z-deriv in
+                //       the divergence uses the normal velocity (Omega). However,
+                //       there are no u/v components to the sedimentation velocity.
+                //       Therefore, we simply end up with a division by detJ when
+                //       evaluating the source term: dJinv * (flux_hi - flux_lo) * dzinv.
+                return rho_avg*vt_ice*qci_avg;
+            };
+
+            Real vt_ice;
+
+            // Substeps from the largest CFL number of the column over the whole step
+            int nsub = 1;
+            Real cfl = 0.0;
+            if (cfl_max > 0.0) {
+                for (int k = klo; k <= khi; ++k) {
+                    Real dJinv = (dJ_array) ? 1.0/dJ_array(i,j,k) : 1.0;
+                    flux(k, vt_ice);
+                    cfl = amrex::max(cfl, vt_ice * dtn * dzinv * dJinv);
+                }
+                nsub = erf_sedimentation_substeps(cfl, cfl_max, nsub_limit);
             }
-            Real vt_ice = min( 0.4 , 8.66 * pow( (max(0.,qci_avg)+1.e-10) , 0.24) );
-
-            // NOTE: Fz is the sedimentation flux from the advective operator.
-            //       In the terrain-following coordinate system, the z-deriv in
-            //       the divergence uses the normal velocity (Omega). However,
-            //       there are no u/v components to the sedimentation velocity.
-            //       Therefore, we simply end up with a division by detJ when
-            //       evaluating the source term: dJinv * (flux_hi - flux_lo) * dzinv.
-            fz_array(i,j,k) = rho_avg*vt_ice*qci_avg;
-        });
-    }
 
-    for (MFIter mfi(*qci, TileNoZ()); mfi.isValid(); ++mfi) {
-        auto qci_array   = qci->array(mfi);
-        auto qn_array    = qn->array(mfi);
-        auto qt_array    = qt->array(mfi);
-        auto rho_array   = rho->array(mfi);
-        auto fz_array    = fz.array(mfi);
+            Real coef = (dtn/nsub)/dz;
 
-        const auto dJ_array = (m_detJ_cc) ? m_detJ_cc->const_array(mfi) : Array4<const Real>{};
+            for (int n = 0; n < nsub; ++n) {
+                Real fz_lo = flux(klo, vt_ice);
 
-        const auto& box3d  = mfi.tilebox();
+                for (int k = klo; k <= khi; ++k) {
+                    // The face above reads cell k before it is updated
+                    Real fz_hi = flux(k+1, vt_ice);
 
-        ParallelFor(box3d, [=] AMREX_GPU_DEVICE(int i, int j, int k) noexcept
-        {
-            // Jacobian determinant
-            Real dJinv = (dJ_array) ? 1.0/dJ_array(i,j,k) : 1.0;
-
-            //==================================================
-            // Cloud ice sedimentation (A32)
-            //==================================================
-            Real dqi  = dJinv * (1.0/rho_array(i,j,k)) * ( fz_array(i,j,k+1) - fz_array(i,j,k) ) * coef;
-            dqi = std::max(-qci_array(i,j,k), dqi);
-
-            // Add this increment to both non-precipitating and total water.
-            qci_array(i,j,k) += dqi;
-             qn_array(i,j,k) += dqi;
-             qt_array(i,j,k) += dqi;
-
-            // NOTE: Sedimentation does not affect the potential temperature,
-            //       but it does affect the liquid/ice static energy.
-            //       No source to Theta occurs here.
+                    // Jacobian determinant
+                    Real dJinv = (dJ_array) ? 1.0/dJ_array(i,j,k) : 1.0;
+
+                    //==================================================
+                    // Cloud ice sedimentation (A32)
+                    //==================================================
+                    Real rho = states_array(i,j,k,Rho_comp);
+                    Real qci_k = std::max(0.0, states_array(i,j,k,RhoQ3_comp)/rho);
+
+                    Real dqi  = dJinv * (1.0/rho) * ( fz_hi - fz_lo ) * coef;
+                    dqi = std::max(-qci_k, dqi);
+
+                    // Add this increment to the cloud ice (and so the non-precipitating and total water).
+                    states_array(i,j,k,RhoQ3_comp) = rho*(qci_k + dqi);
+
+                    // NOTE: Sedimentation does not affect the potential temperature,
+                    //       but it does affect the liquid/ice static energy.
+                    //       No source to Theta occurs here.
+
+                    fz_lo = fz_hi;
+                }
+            }
+
+            return {nsub, static_cast<Long>(nsub),
+                    static_cast<Long>(erf_sedimentation_clamped(cfl, cfl_max, nsub_limit))};
         });
     }
-}
 
+    if (cfl_max > 0.0) {
+        ReduceTuple r = reduce_data.value(reduce_op);
+        erf_report_substeps("SAM::IceFall()", amrex::get<0>(r), amrex::get<1>(r), ncol,
+                            amrex::get<2>(r), nsub_limit);
+    }
+}
@@ -80,24 +80,24 @@ SAM::Init (const MultiFab& cons_in,
 
 
 /**
- * Initializes the Microphysics module.
+ * Sets the moisture fractions of the microphysics module from the state;
+ * the advance works on the state itself.
  *
  * @param[in] cons_in Conserved variables input
  */
 void
 SAM::Copy_State_to_Micro (const MultiFab& cons_in)
 {
-    // Get the temperature, density, theta, qt and qp from input
+    // Get qt and qp from input
     for ( MFIter mfi(cons_in); mfi.isValid(); ++mfi) {
         const auto& box3d = mfi.growntilebox();
 
-        auto states_array = cons_in.array(mfi);
+        auto states_array = cons_in.const_array(mfi);
 
         // Non-precipitating
         auto qv_array    = mic_fab_vars[MicVar::qv]->array(mfi);
         auto qc_array    = mic_fab_vars[MicVar::qcl]->array(mfi);
         auto qi_array    = mic_fab_vars[MicVar::qci]->array(mfi);
-        auto qn_array    = mic_fab_vars[MicVar::qn]->array(mfi);
         auto qt_array    = mic_fab_vars[MicVar::qt]->array(mfi);
 
         // Precipitating
@@ -106,34 +106,20 @@ SAM::Copy_State_to_Micro (const MultiFab& cons_in)
         auto qpg_array   = mic_fab_vars[MicVar::qpg]->array(mfi);
         auto qp_array    = mic_fab_vars[MicVar::qp]->array(mfi);
 
-        auto rho_array   = mic_fab_vars[MicVar::rho]->array(mfi);
-        auto theta_array = mic_fab_vars[MicVar::theta]->array(mfi);
-        auto tabs_array  = mic_fab_vars[MicVar::tabs]->array(mfi);
-        auto pres_array  = mic_fab_vars[MicVar::pres]->array(mfi);
-
-        // Get pressure, theta, temperature, density, and qt, qp
         ParallelFor( box3d, [=] AMREX_GPU_DEVICE (int i, int j, int k)
         {
-            rho_array(i,j,k)   = states_array(i,j,k,Rho_comp);
-            theta_array(i,j,k) = states_array(i,j,k,RhoTheta_comp)/states_array(i,j,k,Rho_comp);
-
             qv_array(i,j,k)    = std::max(0.0,states_array(i,j,k,RhoQ1_comp)/states_array(i,j,k,Rho_comp));
             qc_array(i,j,k)    = std::max(0.0,states_array(i,j,k,RhoQ2_comp)/states_array(i,j,k,Rho_comp));
             qi_array(i,j,k)    = std::max(0.0,states_array(i,j,k,RhoQ3_comp)/states_array(i,j,k,Rho_comp));
-            qn_array(i,j,k)    = qc_array(i,j,k) + qi_array(i,j,k);
-            qt_array(i,j,k)    = qv_array(i,j,k) + qn_array(i,j,k);
+            qt_array(i,j,k)    = qv_array(i,j,k) + qc_array(i,j,k) + qi_array(i,j,k);
 
             qpr_array(i,j,k)   = std::max(0.0,states_array(i,j,k,RhoQ4_comp)/states_array(i,j,k,Rho_comp));
             qps_array(i,j,k)   = std::max(0.0,states_array(i,j,k,RhoQ5_comp)/states_array(i,j,k,Rho_comp));
             qpg_array(i,j,k)   = std::max(0.0,states_array(i,j,k,RhoQ6_comp)/states_array(i,j,k,Rho_comp));
              qp_array(i,j,k)   = qpr_array(i,j,k) + qps_array(i,j,k) + qpg_array(i,j,k);
-
-            tabs_array(i,j,k)  = getTgivenRandRTh(states_array(i,j,k,Rho_comp),
-                                                  states_array(i,j,k,RhoTheta_comp),
-                                                  qv_array(i,j,k));
-            pres_array(i,j,k)  = getPgivenRTh(states_array(i,j,k,RhoTheta_comp), qv_array(i,j,k)) * 0.01;
         });
     }
+    m_qmoist_stale = false;
 }
 
 
@@ -170,21 +156,22 @@ void SAM::Compute_Coefficients ()
     Real gamg1 = erf_gammafff(3.0+b_grau      );
     Real gamg2 = erf_gammafff((5.0+b_grau)/2.0);
 
-    // calculate the plane average variables
-    PlaneAverage rho_ave(mic_fab_vars[MicVar::rho].get(), m_geom, m_axis);
-    PlaneAverage theta_ave(mic_fab_vars[MicVar::theta].get(), m_geom, m_axis);
-    PlaneAverage qv_ave(mic_fab_vars[MicVar::qv].get(), m_geom, m_axis);
-    rho_ave.compute_averages(ZDir(), rho_ave.field());
-    theta_ave.compute_averages(ZDir(), theta_ave.field());
-    qv_ave.compute_averages(ZDir(), qv_ave.field());
+    // calculate the plane averages of rho, rho*theta and rho*qv on the state
+    MultiFab cons_alias(*m_cons, make_alias, 0, RhoQ1_comp+1);
+    PlaneAverage cons_ave(&cons_alias, m_geom, m_axis);
+    cons_ave.compute_averages(ZDir(), cons_ave.field());
 
-    // get host variable rho, and rhotheta
-    int ncell = rho_ave.ncell_line();
+    // get host variable rho, theta and qv (density weighted)
+    int ncell = cons_ave.ncell_line();
 
     Gpu::HostVector<Real> rho_h(ncell), theta_h(ncell), qv_h(ncell);
-    rho_ave.line_average(0, rho_h);
-    theta_ave.line_average(0, theta_h);
-    qv_ave.line_average(0, qv_h);
+    cons_ave.line_average(Rho_comp, rho_h);
+    cons_ave.line_average(RhoTheta_comp, theta_h);
+    cons_ave.line_average(RhoQ1_comp, qv_h);
+    for (int k = 0; k < ncell; ++k) {
+        theta_h[k] /= rho_h[k];
+        qv_h[k]     = std::max(0.0, qv_h[k]/rho_h[k]);
+    }
 
     // copy data to device
     Gpu::DeviceVector<Real> rho_d(ncell), theta_d(ncell), qv_d(ncell);
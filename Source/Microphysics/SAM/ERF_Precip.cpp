@@ -1,14 +1,18 @@
 #include "ERF_SAM.H"
 #include "ERF_EOS.H"
+#include "ERF_ParFunctions.H"
 
 using namespace amrex;
 
 /**
  * Autoconversion (A30), Accretion (A28), Evaporation (A24)
+ *
+ * @param[in] sc Solver choice
  */
 void
 SAM::Precip (const SolverChoice& sc)
 {
+    BL_PROFILE("SAM::Precip()");
 
     if (sc.moisture_type == MoistureType::SAM_NoPrecip_NoIce) return;
 
@@ -46,29 +50,39 @@ SAM::Precip (const SolverChoice& sc)
         SAM_moisture_type = 2;
     }
 
+    const SatTableView sat = m_sat_table.view();
+
+    MultiFab& cons = *m_cons;
+
     // get the temperature, dentisy, theta, qt and qp from input
-    for ( MFIter mfi(*(mic_fab_vars[MicVar::tabs]),TilingIfNotGPU()); mfi.isValid(); ++mfi) {
-        auto theta_array = mic_fab_vars[MicVar::theta]->array(mfi);
-        auto tabs_array  = mic_fab_vars[MicVar::tabs]->array(mfi);
-        auto pres_array  = mic_fab_vars[MicVar::pres]->array(mfi);
-
-        // Non-precipitating
-        auto qv_array    = mic_fab_vars[MicVar::qv]->array(mfi);
-        auto qcl_array   = mic_fab_vars[MicVar::qcl]->array(mfi);
-        auto qci_array   = mic_fab_vars[MicVar::qci]->array(mfi);
-        auto qn_array    = mic_fab_vars[MicVar::qn]->array(mfi);
-        auto qt_array    = mic_fab_vars[MicVar::qt]->array(mfi);
-
-        // Precipitating
-        auto qpr_array   = mic_fab_vars[MicVar::qpr]->array(mfi);
-        auto qps_array   = mic_fab_vars[MicVar::qps]->array(mfi);
-        auto qpg_array   = mic_fab_vars[MicVar::qpg]->array(mfi);
-        auto qp_array    = mic_fab_vars[MicVar::qp]->array(mfi);
+    for ( MFIter mfi(cons,TilingIfNotGPU()); mfi.isValid(); ++mfi) {
+        BoxCostTimer box_timer(m_box_cost, mfi);
+        auto states_array = cons.array(mfi);
 
         const auto& box3d = mfi.tilebox();
 
         ParallelFor(box3d, [=] AMREX_GPU_DEVICE(int i, int j, int k) noexcept
         {
+            // Values of the cell
+            Real rho     = states_array(i,j,k,Rho_comp);
+            Real theta_c = states_array(i,j,k,RhoTheta_comp)/rho;
+
+            // Non-precipitating
+            Real qv_c    = std::max(0.0,states_array(i,j,k,RhoQ1_comp)/rho);
+            Real qcl_c   = std::max(0.0,states_array(i,j,k,RhoQ2_comp)/rho);
+            Real qci_c   = std::max(0.0,states_array(i,j,k,RhoQ3_comp)/rho);
+            Real qn_c    = qcl_c + qci_c;
+
+            // Precipitating
+            Real qpr_c   = std::max(0.0,states_array(i,j,k,RhoQ4_comp)/rho);
+            Real qps_c   = std::max(0.0,states_array(i,j,k,RhoQ5_comp)/rho);
+            Real qpg_c   = std::max(0.0,states_array(i,j,k,RhoQ6_comp)/rho);
+            Real qp_c    = qpr_c + qps_c + qpg_c;
+
+            // Temperature and pressure [mbar]
+            Real tabs_c  = getTgivenRandRTh(rho, rho*theta_c, qv_c);
+            Real pres_c  = getPgivenRTh(rho*theta_c, qv_c) * 0.01;
+
             //------- Autoconversion/accretion
             Real omn, omp, omg;
             Real qsat, qsatw, qsati;
@@ -84,28 +98,28 @@ SAM::Precip (const SolverChoice& sc)
             Real accrcr, accrcs, accris, accrcg, accrig;
 
             // Work to be done for autoc/accr or evap
-            if (qn_array(i,j,k)+qp_array(i,j,k) > 0.0) {
+            if (qn_c+qp_c > 0.0) {
                 if (SAM_moisture_type == 2) {
                     omn = 1.0;
                     omp = 1.0;
                     omg = 0.0;
                 } else {
-                    omn = std::max(0.0,std::min(1.0,(tabs_array(i,j,k)-tbgmin)*a_bg));
-                    omp = std::max(0.0,std::min(1.0,(tabs_array(i,j,k)-tprmin)*a_pr));
-                    omg = std::max(0.0,std::min(1.0,(tabs_array(i,j,k)-tgrmin)*a_gr));
+                    omn = std::max(0.0,std::min(1.0,(tabs_c-tbgmin)*a_bg));
+                    omp = std::max(0.0,std::min(1.0,(tabs_c-tprmin)*a_pr));
+                    omg = std::max(0.0,std::min(1.0,(tabs_c-tgrmin)*a_gr));
                 }
 
-                qcc = qcl_array(i,j,k);
-                qii = qci_array(i,j,k);
+                qcc = qcl_c;
+                qii = qci_c;
 
-                qpr = qpr_array(i,j,k);
-                qps = qps_array(i,j,k);
-                qpg = qpg_array(i,j,k);
+                qpr = qpr_c;
+                qps = qps_c;
+                qpg = qpg_c;
 
                 //==================================================
                 // Autoconversion (A30/A31) and accretion (A27)
                 //==================================================
-                if (qn_array(i,j,k) > 0.0) {
+                if (qn_c > 0.0) {
                     accrcr = 0.0;
                     accrcs = 0.0;
                     accris = 0.0;
@@ -151,8 +165,8 @@ SAM::Precip (const SolverChoice& sc)
                     // Rescale sinks to avoid negative cloud fractions
                     dqc  = dqca + dprc + dpsc + dpgc;
                     dqi  = dqia + dpsi + dpgi;
-                    Real scalec = std::min(qcl_array(i,j,k),dqc) / (dqc + eps);
-                    Real scalei = std::min(qci_array(i,j,k),dqi) / (dqi + eps);
+                    Real scalec = std::min(qcl_c,dqc) / (dqc + eps);
+                    Real scalei = std::min(qci_c,dqi) / (dqi + eps);
                     dqca *= scalec; dprc *= scalec; dpsc *= scalec; dpgc *= scalec;
                     dqia *= scalei; dpsi *= scalei; dpgi *= scalei;
                     dqc   = dqca + dprc + dpsc + dpgc;
@@ -170,31 +184,30 @@ SAM::Precip (const SolverChoice& sc)
                     dqpg = (dqca + dqia) * (1.0 - omp) * omg         + dpgc + dpgi;
 
                     // Update the primitive state variables
-                    qcl_array(i,j,k) -= dqc;
-                    qci_array(i,j,k) -= dqi;
-                    qpr_array(i,j,k) += dqpr;
-                    qps_array(i,j,k) += dqps;
-                    qpg_array(i,j,k) += dqpg;
+                    qcl_c -= dqc;
+                    qci_c -= dqi;
+                    qpr_c += dqpr;
+                    qps_c += dqps;
+                    qpg_c += dqpg;
 
                     // Update the primitive derived vars
-                    qn_array(i,j,k) = qcl_array(i,j,k) + qci_array(i,j,k);
-                    qt_array(i,j,k) =  qv_array(i,j,k) +  qn_array(i,j,k);
-                    qp_array(i,j,k) = qpr_array(i,j,k) + qps_array(i,j,k) + qpg_array(i,j,k);
+                    qn_c = qcl_c + qci_c;
+                    qp_c = qpr_c + qps_c + qpg_c;
 
                     // Update temperature
-                    tabs_array(i,j,k) += fac_fus * ( dqca * (1.0 - omp) - dqia * omp );
+                    tabs_c += fac_fus * ( dqca * (1.0 - omp) - dqia * omp );
 
                     // Update theta
-                    theta_array(i,j,k) = getThgivenPandT(tabs_array(i,j,k), 100.0*pres_array(i,j,k), rdOcp);
+                    theta_c = getThgivenPandT(tabs_c, 100.0*pres_c, rdOcp);
                 }
 
                 //==================================================
                 // Evaporation (A24)
                 //==================================================
-                erf_qsatw(tabs_array(i,j,k),pres_array(i,j,k),qsatw);
-                erf_qsati(tabs_array(i,j,k),pres_array(i,j,k),qsati);
+                erf_qsatw(tabs_c,pres_c,qsatw,sat);
+                erf_qsati(tabs_c,pres_c,qsati,sat);
                 qsat = qsatw * omn + qsati * (1.0-omn);
-                if((qp_array(i,j,k) > 0.0) && (qv_array(i,j,k) < qsat)) {
+                if((qp_c > 0.0) && (qv_c < qsat)) {
 
                     dqpr = evapr1_t(k)*sqrt(qpr) + evapr2_t(k)*pow(qpr,powr2);
                     dqps = evaps1_t(k)*sqrt(qps) + evaps2_t(k)*pow(qps,pows2);
@@ -204,33 +217,40 @@ SAM::Precip (const SolverChoice& sc)
                     //       since qv<qsat and thus (1 - qv/qsat)>0. If we are
                     //       in a super-saturated state (qv>qsat) the Newton
                     //       iterations in Cloud() will have handled condensation.
-                    dqpr *= dtn * (1.0 - qv_array(i,j,k)/qsat);
-                    dqps *= dtn * (1.0 - qv_array(i,j,k)/qsat);
-                    dqpg *= dtn * (1.0 - qv_array(i,j,k)/qsat);
+                    dqpr *= dtn * (1.0 - qv_c/qsat);
+                    dqps *= dtn * (1.0 - qv_c/qsat);
+                    dqpg *= dtn * (1.0 - qv_c/qsat);
 
                     // Limit to avoid negative moisture fractions
-                    dqpr = std::min(qpr_array(i,j,k),dqpr);
-                    dqps = std::min(qps_array(i,j,k),dqps);
-                    dqpg = std::min(qpg_array(i,j,k),dqpg);
+                    dqpr = std::min(qpr_c,dqpr);
+                    dqps = std::min(qps_c,dqps);
+                    dqpg = std::min(qpg_c,dqpg);
                     dqp  = dqpr + dqps + dqpg;
 
                     // Update the primitive state variables
-                     qv_array(i,j,k) += dqp;
-                    qpr_array(i,j,k) -= dqpr;
-                    qps_array(i,j,k) -= dqps;
-                    qpg_array(i,j,k) -= dqpg;
+                    qv_c  += dqp;
+                    qpr_c -= dqpr;
+                    qps_c -= dqps;
+                    qpg_c -= dqpg;
 
                     // Update the primitive derived vars
-                    qt_array(i,j,k) =  qv_array(i,j,k) +  qn_array(i,j,k);
-                    qp_array(i,j,k) = qpr_array(i,j,k) + qps_array(i,j,k) + qpg_array(i,j,k);
+                    qp_c = qpr_c + qps_c + qpg_c;
 
                     // Update temperature
-                    tabs_array(i,j,k) -= fac_cond * dqpr + fac_sub * (dqps + dqpg);
+                    tabs_c -= fac_cond * dqpr + fac_sub * (dqps + dqpg);
 
                     // Update theta
-                    theta_array(i,j,k) = getThgivenPandT(tabs_array(i,j,k), 100.0*pres_array(i,j,k), rdOcp);
+                    theta_c = getThgivenPandT(tabs_c, 100.0*pres_c, rdOcp);
                 }
             }
+
+            states_array(i,j,k,RhoTheta_comp) = rho*theta_c;
+            states_array(i,j,k,RhoQ1_comp)    = rho*std::max(0.0,qv_c);
+            states_array(i,j,k,RhoQ2_comp)    = rho*std::max(0.0,qcl_c);
+            states_array(i,j,k,RhoQ3_comp)    = rho*std::max(0.0,qci_c);
+            states_array(i,j,k,RhoQ4_comp)    = rho*std::max(0.0,qpr_c);
+            states_array(i,j,k,RhoQ5_comp)    = rho*std::max(0.0,qps_c);
+            states_array(i,j,k,RhoQ6_comp)    = rho*std::max(0.0,qpg_c);
         });
     }
 }
@@ -1,6 +1,9 @@
+#include <AMReX_Reduce.H>
 #include "ERF_Constants.H"
 #include "ERF_SAM.H"
 #include "ERF_TileNoZ.H"
+#include "ERF_EOS.H"
+#include "ERF_ParFunctions.H"
 
 using namespace amrex;
 
@@ -9,11 +12,16 @@ using namespace amrex;
  *
  * Code modified from SAMXX, the C++ version of the SAM code.
  *
- * @param[in] hydro_type Type selection for the precipitation advection hydrodynamics scheme (0-3)
+ * Each column is swept bottom to top, so the flux through the top of a cell is
+ * formed before that cell is updated. If erf.sedimentation_cfl is set, a column
+ * takes as many substeps as its largest fall-speed CFL number over the step needs.
+ *
+ * @param[in] sc Solver choice
  */
 void
 SAM::PrecipFall (const SolverChoice& sc)
 {
+    BL_PROFILE("SAM::PrecipFall()");
     if(sc.moisture_type == MoistureType::SAM_NoPrecip_NoIce) return;
 
     Real rho_0 = 1.29;
@@ -26,151 +34,190 @@ SAM::PrecipFall (const SolverChoice& sc)
     Real vsnow = (a_snow*gams3/6.0)*pow((PI*rhos*nzeros),-csnow);
     Real vgrau = (a_grau*gamg3/6.0)*pow((PI*rhog*nzerog),-cgrau);
 
-    auto dz   = m_geom.CellSize(2);
-    Real dtn  = dt;
-    Real coef = dtn/dz;
+    auto dz    = m_geom.CellSize(2);
+    Real dzinv = 1.0/dz;
+    Real dtn   = dt;
+
+    Real cfl_max    = sc.sedimentation_cfl;
+    int  nsub_limit = sc.sedimentation_max_substeps;
 
     auto domain = m_geom.Domain();
     int k_lo = domain.smallEnd(2);
     int k_hi = domain.bigEnd(2);
 
-    auto qpr   = mic_fab_vars[MicVar::qpr];
-    auto qps   = mic_fab_vars[MicVar::qps];
-    auto qpg   = mic_fab_vars[MicVar::qpg];
-    auto qp    = mic_fab_vars[MicVar::qp];
-    auto rho   = mic_fab_vars[MicVar::rho];
-    auto tabs  = mic_fab_vars[MicVar::tabs];
-    auto theta = mic_fab_vars[MicVar::theta];
+    MultiFab& cons = *m_cons;
+
     auto rain_accum = mic_fab_vars[MicVar::rain_accum];
     auto snow_accum = mic_fab_vars[MicVar::snow_accum];
     auto graup_accum = mic_fab_vars[MicVar::graup_accum];
 
-    auto ba    = tabs->boxArray();
-    auto dm    = tabs->DistributionMap();
-    auto ngrow = tabs->nGrowVect();
-
-    MultiFab fz;
-    fz.define(convert(ba, IntVect(0,0,1)), dm, 1, ngrow);
-
     int SAM_moisture_type = 1;
     if (sc.moisture_type == MoistureType::SAM_NoIce) {
         SAM_moisture_type = 2;
     }
 
-    //  Add sedimentation of precipitation field to the vert. vel.
-    for (MFIter mfi(fz, TilingIfNotGPU()); mfi.isValid(); ++mfi) {
-        auto qp_array   = qp->array(mfi);
-        auto rho_array  = rho->array(mfi);
-        auto tabs_array = tabs->array(mfi);
-        auto fz_array   = fz.array(mfi);
+    // Largest and summed numbers of substeps over the columns, and number of limited columns
+    ReduceOps<ReduceOpMax, ReduceOpSum, ReduceOpSum> reduce_op;
+    ReduceData<int, Long, Long> reduce_data(reduce_op);
+    using ReduceTuple = typename decltype(reduce_data)::Type;
+    Long ncol = 0;
+
+    for (MFIter mfi(cons, TileNoZ()); mfi.isValid(); ++mfi) {
+        BoxCostTimer box_timer(m_box_cost, mfi);
+        auto states_array = cons.array(mfi);
         auto rain_accum_array = rain_accum->array(mfi);
         auto snow_accum_array = snow_accum->array(mfi);
         auto graup_accum_array = graup_accum->array(mfi);
 
+        const auto dJ_array = (m_detJ_cc) ? m_detJ_cc->const_array(mfi) : Array4<const Real>{};
+
         const auto& box3d = mfi.tilebox();
 
-        ParallelFor(box3d, [=] AMREX_GPU_DEVICE(int i, int j, int k) noexcept
-        {
-            Real rho_avg, tab_avg, qp_avg;
-            if (k==k_lo) {
-                rho_avg =  rho_array(i,j,k);
-                tab_avg = tabs_array(i,j,k);
-                 qp_avg =   qp_array(i,j,k);
-            } else if (k==k_hi+1) {
-                rho_avg =  rho_array(i,j,k-1);
-                tab_avg = tabs_array(i,j,k-1);
-                 qp_avg =   qp_array(i,j,k-1);
-            } else {
-                rho_avg = 0.5*( rho_array(i,j,k-1) +  rho_array(i,j,k));
-                tab_avg = 0.5*(tabs_array(i,j,k-1) + tabs_array(i,j,k));
-                 qp_avg = 0.5*(  qp_array(i,j,k-1) +   qp_array(i,j,k));
-            }
+        // Substeps would lag the fluxes through faces shared with other boxes
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(cfl_max == 0.0 || (box3d.smallEnd(2) == k_lo && box3d.bigEnd(2) == k_hi),
+                                         "erf.sedimentation_cfl requires grids that span the domain vertically");
+
+        const int klo = box3d.smallEnd(2);
+        const int khi = box3d.bigEnd(2);
+        const Box cbx = makeSlab(box3d, 2, klo);
+        ncol += cbx.numPts();
 
-            Real Pprecip = 0.0;
-            if(qp_avg > qp_threshold) {
-                Real omp, omg;
+        reduce_op.eval(cbx, reduce_data,
+        [=] AMREX_GPU_DEVICE (int i, int j, int) -> ReduceTuple
+        {
+            auto qp = [=] (int kk) {
+                Real rho = states_array(i,j,kk,Rho_comp);
+                return std::max(0.0, states_array(i,j,kk,RhoQ4_comp)/rho)
+                     + std::max(0.0, states_array(i,j,kk,RhoQ5_comp)/rho)
+                     + std::max(0.0, states_array(i,j,kk,RhoQ6_comp)/rho);
+            };
+
+            // Sedimentation changes neither rho, rho*theta nor rho*qv, so the
+            // temperature of a cell holds over the whole sweep
+            auto tabs = [=] (int kk) {
+                Real rho = states_array(i,j,kk,Rho_comp);
+                Real qv  = std::max(0.0, states_array(i,j,kk,RhoQ1_comp)/rho);
+                return getTgivenRandRTh(rho, states_array(i,j,kk,RhoTheta_comp), qv);
+            };
+
+            auto fractions = [=] (Real tab, Real& omp, Real& omg) {
                 if (SAM_moisture_type == 2) {
                     omp = 1.0;
                     omg = 0.0;
                 } else {
-                    omp = std::max(0.0,std::min(1.0,(tab_avg-tprmin)*a_pr));
-                    omg = std::max(0.0,std::min(1.0,(tab_avg-tgrmin)*a_gr));
+                    omp = std::max(0.0,std::min(1.0,(tab-tprmin)*a_pr));
+                    omg = std::max(0.0,std::min(1.0,(tab-tgrmin)*a_gr));
+                }
+            };
+
+            // Flux through the bottom face of cell k and the fall speed there
+            auto flux = [=] (int k, Real& rho_avg, Real& tab_avg, Real& qp_avg, Real& vfall) {
+                if (k==k_lo) {
+                    rho_avg = states_array(i,j,k,Rho_comp);
+                    tab_avg = tabs(k);
+                     qp_avg = qp(k);
+                } else if (k==k_hi+1) {
+                    rho_avg = states_array(i,j,k-1,Rho_comp);
+                    tab_avg = tabs(k-1);
+                     qp_avg = qp(k-1);
+                } else {
+                    rho_avg = 0.5*(states_array(i,j,k-1,Rho_comp) + states_array(i,j,k,Rho_comp));
+                    tab_avg = 0.5*(tabs(k-1) + tabs(k));
+                     qp_avg = 0.5*(qp(k-1) + qp(k));
                 }
-                Real qrr = omp*qp_avg;
-                Real qss = (1.0-omp)*(1.0-omg)*qp_avg;
-                Real qgg = (1.0-omp)*(omg)*qp_avg;
-                Pprecip = omp*vrain*std::pow(rho_avg*qrr,1.0+crain)
-                        + (1.0-omp)*( (1.0-omg)*vsnow*std::pow(rho_avg*qss,1.0+csnow)
-                                    +      omg *vgrau*std::pow(rho_avg*qgg,1.0+cgrau) );
-            }
 
-            // NOTE: Fz is the sedimentation flux from the advective operator.
-            //       In the terrain-following coordinate system, the z-deriv in
-            //       the divergence uses the normal velocity (Omega). However,
-            //       there are no u/v components to the sedimentation velocity.
-            //       Therefore, we simply end up with a division by detJ when
-            //       evaluating the source term: dJinv * (flux_hi - flux_lo) * dzinv.
-            fz_array(i,j,k) = Pprecip * std::sqrt(rho_0/rho_avg);
+                Real Pprecip = 0.0;
+                vfall = 0.0;
+                if(qp_avg > qp_threshold) {
+                    Real omp, omg;
+                    fractions(tab_avg, omp, omg);
+                    Real qrr = omp*qp_avg;
+                    Real qss = (1.0-omp)*(1.0-omg)*qp_avg;
+                    Real qgg = (1.0-omp)*(omg)*qp_avg;
+                    Pprecip = omp*vrain*std::pow(rho_avg*qrr,1.0+crain)
+                            + (1.0-omp)*( (1.0-omg)*vsnow*std::pow(rho_avg*qss,1.0+csnow)
+                                        +      omg *vgrau*std::pow(rho_avg*qgg,1.0+cgrau) );
+                    vfall = Pprecip * std::sqrt(rho_0/rho_avg) / (rho_avg*qp_avg);
+                }
 
-            if(k==k_lo){
-                Real omp, omg;
-                if (SAM_moisture_type == 2) {
-                    omp = 1.0;
-                    omg = 0.0;
-                } else {
-                    omp = std::max(0.0,std::min(1.0,(tab_avg-tprmin)*a_pr));
-                    omg = std::max(0.0,std::min(1.0,(tab_avg-tgrmin)*a_gr));
+                // NOTE: Fz is the sedimentation flux from the advective operator.
+                //       In the terrain-following coordinate system, the z-deriv in
+                //       the divergence uses the normal velocity (Omega). However,
+                //       there are no u/v components to the sedimentation velocity.
+                //       Therefore, we simply end up with a division by detJ when
+                //       evaluating the source term: dJinv * (flux_hi - flux_lo) * dzinv.
+                return Pprecip * std::sqrt(rho_0/rho_avg);
+            };
+
+            Real rho_avg, tab_avg, qp_avg, vfall;
+
+            // Substeps from the largest CFL number of the column over the whole step
+            int nsub = 1;
+            Real cfl = 0.0;
+            if (cfl_max > 0.0) {
+                for (int k = klo; k <= khi; ++k) {
+                    Real dJinv = (dJ_array) ? 1.0/dJ_array(i,j,k) : 1.0;
+                    flux(k, rho_avg, tab_avg, qp_avg, vfall);
+                    cfl = amrex::max(cfl, vfall * dtn * dzinv * dJinv);
                 }
-                rain_accum_array(i,j,k)  = rain_accum_array(i,j,k) +  rho_avg*(omp*qp_avg)*vrain*dtn/rhor*1000.0; // Divide by rho_water and convert to mm
-                snow_accum_array(i,j,k)  = snow_accum_array(i,j,k) +  rho_avg*(1.0-omp)*(1.0-omg)*qp_avg*vrain*dtn/rhos*1000.0; // Divide by rho_snow and convert to mm
-                graup_accum_array(i,j,k) = graup_accum_array(i,j,k) + rho_avg*(1.0-omp)*(omg)*qp_avg*vrain*dtn/rhog*1000.0; // Divide by rho_graupel and convert to mm
+                nsub = erf_sedimentation_substeps(cfl, cfl_max, nsub_limit);
             }
 
-        });
-    }
+            Real dts  = dtn/nsub;
+            Real coef = dts/dz;
 
-    for (MFIter mfi(*qp, TileNoZ()); mfi.isValid(); ++mfi) {
-        auto qpr_array    = qpr->array(mfi);
-        auto qps_array    = qps->array(mfi);
-        auto qpg_array    = qpg->array(mfi);
-        auto qp_array     = qp->array(mfi);
-        auto rho_array    = rho->array(mfi);
-        auto tabs_array   = tabs->array(mfi);
-        auto fz_array     = fz.array(mfi);
+            for (int n = 0; n < nsub; ++n) {
+                Real fz_lo = flux(klo, rho_avg, tab_avg, qp_avg, vfall);
 
-        const auto dJ_array = (m_detJ_cc) ? m_detJ_cc->const_array(mfi) : Array4<const Real>{};
+                if (klo==k_lo) {
+                    Real omp, omg;
+                    fractions(tab_avg, omp, omg);
+                    rain_accum_array(i,j,klo)  = rain_accum_array(i,j,klo) +  rho_avg*(omp*qp_avg)*vrain*dts/rhor*1000.0; // Divide by rho_water and convert to mm
+                    snow_accum_array(i,j,klo)  = snow_accum_array(i,j,klo) +  rho_avg*(1.0-omp)*(1.0-omg)*qp_avg*vrain*dts/rhos*1000.0; // Divide by rho_snow and convert to mm
+                    graup_accum_array(i,j,klo) = graup_accum_array(i,j,klo) + rho_avg*(1.0-omp)*(omg)*qp_avg*vrain*dts/rhog*1000.0; // Divide by rho_graupel and convert to mm
+                }
 
-        const auto& box3d = mfi.tilebox();
+                // Update precipitation mass fraction and liquid-ice static
+                // energy using precipitation fluxes computed in this column.
+                for (int k = klo; k <= khi; ++k) {
+                    // The face above reads cell k before it is updated
+                    Real fz_hi = flux(k+1, rho_avg, tab_avg, qp_avg, vfall);
 
-        // Update precipitation mass fraction and liquid-ice static
-        // energy using precipitation fluxes computed in this column.
-        ParallelFor(box3d, [=] AMREX_GPU_DEVICE (int i, int j, int k)
-        {
-            // Jacobian determinant
-            Real dJinv = (dJ_array) ? 1.0/dJ_array(i,j,k) : 1.0;
-
-            //==================================================
-            // Precipitating sedimentation (A19)
-            //==================================================
-            Real dqp = dJinv * (1.0/rho_array(i,j,k)) * ( fz_array(i,j,k+1) - fz_array(i,j,k) ) * coef;
-            Real omp, omg;
-            if (SAM_moisture_type == 2) {
-                omp = 1.0;
-                omg = 0.0;
-            } else {
-                omp = std::max(0.0,std::min(1.0,(tabs_array(i,j,k)-tprmin)*a_pr));
-                omg = std::max(0.0,std::min(1.0,(tabs_array(i,j,k)-tgrmin)*a_gr));
-            }
+                    // Jacobian determinant
+                    Real dJinv = (dJ_array) ? 1.0/dJ_array(i,j,k) : 1.0;
 
-            qpr_array(i,j,k) = std::max(0.0, qpr_array(i,j,k) + dqp*omp);
-            qps_array(i,j,k) = std::max(0.0, qps_array(i,j,k) + dqp*(1.0-omp)*(1.0-omg));
-            qpg_array(i,j,k) = std::max(0.0, qpg_array(i,j,k) + dqp*(1.0-omp)*omg);
-             qp_array(i,j,k) = qpr_array(i,j,k) + qps_array(i,j,k) + qpg_array(i,j,k);
+                    //==================================================
+                    // Precipitating sedimentation (A19)
+                    //==================================================
+                    Real rho = states_array(i,j,k,Rho_comp);
+                    Real dqp = dJinv * (1.0/rho) * ( fz_hi - fz_lo ) * coef;
+                    Real omp, omg;
+                    fractions(tabs(k), omp, omg);
 
-            // NOTE: Sedimentation does not affect the potential temperature,
-            //       but it does affect the liquid/ice static energy.
-            //       No source to Theta occurs here.
+                    Real qpr = std::max(0.0, states_array(i,j,k,RhoQ4_comp)/rho);
+                    Real qps = std::max(0.0, states_array(i,j,k,RhoQ5_comp)/rho);
+                    Real qpg = std::max(0.0, states_array(i,j,k,RhoQ6_comp)/rho);
+
+                    states_array(i,j,k,RhoQ4_comp) = rho*std::max(0.0, qpr + dqp*omp);
+                    states_array(i,j,k,RhoQ5_comp) = rho*std::max(0.0, qps + dqp*(1.0-omp)*(1.0-omg));
+                    states_array(i,j,k,RhoQ6_comp) = rho*std::max(0.0, qpg + dqp*(1.0-omp)*omg);
+
+                    // NOTE: Sedimentation does not affect the potential temperature,
+                    //       but it does affect the liquid/ice static energy.
+                    //       No source to Theta occurs here.
+
+                    fz_lo = fz_hi;
+                }
+            }
+
+            return {nsub, static_cast<Long>(nsub),
+                    static_cast<Long>(erf_sedimentation_clamped(cfl, cfl_max, nsub_limit))};
         });
     } // mfi
-}
 
+    if (cfl_max > 0.0) {
+        ReduceTuple r = reduce_data.value(reduce_op);
+        erf_report_substeps("SAM::PrecipFall()", amrex::get<0>(r), amrex::get<1>(r), ncol,
+                            amrex::get<2>(r), nsub_limit);
+    }
+}
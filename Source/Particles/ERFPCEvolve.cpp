@@ -5,6 +5,7 @@
 #include <ERF_IndexDefines.H>
 #include <ERF_Constants.H>
 #include <AMReX_TracerParticle_mod_K.H>
+#include <AMReX_Reduce.H>
 
 using namespace amrex;
 
@@ -25,10 +26,71 @@ void ERFPC::EvolveParticles ( int                                        a_lev,
         AdvectWithGravity( a_lev, a_dt_lev, a_z_phys_nd[a_lev] );
     }
 
-    Redistribute();
+    // Cells a particle may stray from its grid and still be interpolated to at the
+    // next step, keeping one ghost cell for the motion over that step
+    int halo = m_redistribute_halo;
+    if (m_advect_w_flow) {
+        for (int i = 0; i < AMREX_SPACEDIM; i++) {
+            halo = std::min(halo, a_flow_vars[a_lev][Vars::xvel+i].nGrow() - 2);
+        }
+    }
+    if (a_z_phys_nd[a_lev]) {
+        halo = std::min(halo, a_z_phys_nd[a_lev]->nGrow() - 2);
+    }
+
+    if (halo <= 0) {
+        Redistribute();
+        m_in_place = true;
+    } else {
+        const int max_cells = MaxCellsOutsideGrids(a_lev);
+        if (max_cells > halo) {
+            // No particle is further than max_cells from its grid, so only the ranks
+            // owning neighbouring grids exchange particles
+            if (finestLevel() == 0) {
+                Redistribute(0, 0, 0, max_cells);
+            } else {
+                Redistribute();
+            }
+            m_in_place = true;
+        } else if (max_cells > 0) {
+            m_in_place = false;
+        }
+    }
+
+    if (a_lev == 0) {
+        ++m_num_steps;
+        SortParticlesByCellIfDue(m_num_steps);
+    }
     return;
 }
 
+/*! Sort the particles of each tile by cell every sort_int level-0 steps, so that
+ *  the interpolation and deposition kernels visit the mesh in memory order */
+void ERFPC::SortParticlesByCellIfDue (int a_step)
+{
+    if (m_sort_int <= 0 || a_step % m_sort_int != 0) { return; }
+
+    BL_PROFILE("ERFPC::SortParticlesByCellIfDue()");
+
+    // The bins are the cells of the grid that owns each particle
+    RedistributeIfNotInPlace();
+
+    const auto strttime = amrex::second();
+
+    SortParticlesByCell();
+
+    if (m_verbose > 1)
+    {
+        Gpu::streamSynchronize();
+        auto stoptime = amrex::second() - strttime;
+
+        ParallelReduce::Max(stoptime, ParallelContext::IOProcessorNumberSub(),
+                            ParallelContext::CommunicatorSub());
+
+        Print() << "ERFPC::SortParticlesByCell() time: " << stoptime << '\n';
+    }
+}
+
 /*! Uses midpoint method to advance particles using flow velocity. */
 void ERFPC::AdvectWithFlow ( MultiFab*                           a_umac,
                              int                                 a_lev,
@@ -52,7 +114,6 @@ void ERFPC::AdvectWithFlow ( MultiFab*                           a_umac,
     const auto plo = geom.ProbLoArray();
     const auto dxi = geom.InvCellSizeArray();
 
-    Vector<std::unique_ptr<MultiFab> > raii_umac(AMREX_SPACEDIM);
     Vector<MultiFab*> umac_pointer(AMREX_SPACEDIM);
     if (OnSameGrids(a_lev, a_umac[0]))
     {
@@ -62,13 +123,23 @@ void ERFPC::AdvectWithFlow ( MultiFab*                           a_umac,
     }
     else
     {
+        // Velocities on the particle grids, allocated again only when those grids change
+        if (m_umac_cache.size() <= a_lev) { m_umac_cache.resize(a_lev+1); }
+        auto& umac_cache = m_umac_cache[a_lev];
+        umac_cache.resize(AMREX_SPACEDIM);
+
         for (int i = 0; i < AMREX_SPACEDIM; i++)
         {
             IntVect ng = a_umac[i].nGrowVect();
-            raii_umac[i] = std::make_unique<MultiFab>
-                (convert(m_gdb->ParticleBoxArray(a_lev), IntVect::TheDimensionVector(i)),
-                 m_gdb->ParticleDistributionMap(a_lev), a_umac[i].nComp(), ng);
-            umac_pointer[i] = raii_umac[i].get();
+            BoxArray ba = convert(m_gdb->ParticleBoxArray(a_lev), IntVect::TheDimensionVector(i));
+            const DistributionMapping& dm = m_gdb->ParticleDistributionMap(a_lev);
+            if ( !umac_cache[i] ||
+                 umac_cache[i]->boxArray() != ba || umac_cache[i]->DistributionMap() != dm ||
+                 umac_cache[i]->nComp() != a_umac[i].nComp() || umac_cache[i]->nGrowVect() != ng )
+            {
+                umac_cache[i] = std::make_unique<MultiFab>(ba, dm, a_umac[i].nComp(), ng);
+            }
+            umac_pointer[i] = umac_cache[i].get();
             umac_pointer[i]->ParallelCopy(a_umac[i],0,0,a_umac[i].nComp(),ng,ng);
         }
     }
@@ -140,21 +211,69 @@ void ERFPC::AdvectWithFlow ( MultiFab*                           a_umac,
 
     if (m_verbose > 1)
     {
+        Gpu::streamSynchronize();
         auto stoptime = amrex::second() - strttime;
 
+        // Each particle is interpolated to once per pass
+        Long np = NumberOfParticlesAtLevel(a_lev);
+
 #ifdef AMREX_LAZY
         Lazy::QueueReduction( [=] () mutable {
 #endif
                 ParallelReduce::Max(stoptime, ParallelContext::IOProcessorNumberSub(),
                                     ParallelContext::CommunicatorSub());
 
-                Print() << "ERFPC::AdvectWithFlow() time: " << stoptime << '\n';
+                Print() << "ERFPC::AdvectWithFlow() time: " << stoptime
+                        << ", interpolations per second: " << 2.0*static_cast<Real>(np)/stoptime << '\n';
 #ifdef AMREX_LAZY
         });
 #endif
     }
 }
 
+/*! Largest number of cells by which a particle at a level lies outside the valid
+ *  box of the grid that owns it (zero if all particles are in place) */
+int ERFPC::MaxCellsOutsideGrids (int a_lev) const
+{
+    BL_PROFILE("ERFPC::MaxCellsOutsideGrids()");
+
+    const Geometry& geom = Geom(a_lev);
+    const auto plo = geom.ProbLoArray();
+    const auto dxi = geom.InvCellSizeArray();
+    const Box domain = geom.Domain();
+
+    ReduceOps<ReduceOpMax> reduce_op;
+    ReduceData<int> reduce_data(reduce_op);
+    using ReduceTuple = typename decltype(reduce_data)::Type;
+
+    for (ParConstIterType pti(*this, a_lev); pti.isValid(); ++pti)
+    {
+        const Box vbx = pti.validbox();
+        const auto& aos = pti.GetArrayOfStructs();
+        const int n = aos.numParticles();
+        const auto *p_pbox = aos().data();
+
+        reduce_op.eval(n, reduce_data,
+        [=] AMREX_GPU_DEVICE (int i) -> ReduceTuple
+        {
+            const ParticleType& p = p_pbox[i];
+            if (p.id() <= 0) { return {0}; }
+
+            IntVect iv = ERFParticlesAssignor{}(p, plo, dxi, domain);
+            int ncells = 0;
+            for (int dim = 0; dim < AMREX_SPACEDIM; dim++) {
+                ncells = amrex::max(ncells, amrex::max(vbx.smallEnd(dim) - iv[dim],
+                                                       iv[dim] - vbx.bigEnd(dim)));
+            }
+            return {ncells};
+        });
+    }
+
+    int max_cells = amrex::get<0>(reduce_data.value(reduce_op));
+    ParallelDescriptor::ReduceIntMax(max_cells);
+    return max_cells;
+}
+
 void ERFPC::AdvectWithGravity (  int                                 a_lev,
                                  Real                                a_dt,
                                  const std::unique_ptr<MultiFab>&    a_z_height )
@@ -49,6 +49,16 @@ void ERFPC::readInputs ()
     m_advect_w_gravity = (m_name == ERFParticleNames::hydro ? true : false);
     pp.query("advect_with_gravity", m_advect_w_gravity);
 
+    // Sorting the particles of each tile by cell makes the mesh accesses of
+    // interpolation and deposition contiguous
+    m_sort_int = -1;
+    pp.query("sort_int", m_sort_int);
+
+    // Particles may stray this many cells from their grids before they are redistributed;
+    // the velocity and height ghost cells cap it
+    m_redistribute_halo = 0;
+    pp.query("redistribute_halo", m_redistribute_halo);
+
     return;
 }
 
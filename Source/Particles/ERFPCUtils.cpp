@@ -19,6 +19,8 @@ void ERFPC::massDensity ( MultiFab&  a_mf,
     const auto plo = geom.ProbLoArray();
     const auto dxi = geom.InvCellSizeArray();
 
+    const auto strttime = amrex::second();
+
     const Real inv_cell_volume = dxi[0]*dxi[1]*dxi[2];
     a_mf.setVal(0.0);
 
@@ -36,6 +38,20 @@ void ERFPC::massDensity ( MultiFab&  a_mf,
                 });
         });
 
+    if (m_verbose > 1)
+    {
+        Gpu::streamSynchronize();
+        auto stoptime = amrex::second() - strttime;
+
+        Long np = NumberOfParticlesAtLevel(a_lev);
+
+        ParallelReduce::Max(stoptime, ParallelContext::IOProcessorNumberSub(),
+                            ParallelContext::CommunicatorSub());
+
+        Print() << "ERFPC::massDensity() time: " << stoptime
+                << ", depositions per second: " << static_cast<Real>(np)/stoptime << '\n';
+    }
+
     return;
 }
 
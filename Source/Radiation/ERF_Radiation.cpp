@@ -115,13 +115,22 @@ void Radiation::initialize (const MultiFab& cons_in,
                             const bool& do_snow_opt,
                             const bool& is_cmip6_volcano)
 {
-    m_geom = geom;
-    m_box = grids;
+    if (m_coarsen > 1) {
+        coarsen_inputs(cons_in, lsm_fluxes, qheating_rates, lat, lon, qmoist, geom);
+    } else {
+        m_geom = geom;
+        m_box = grids;
 
-    qrad_src = qheating_rates;
+        qrad_src = qheating_rates;
 
-    auto dz   = m_geom.CellSize(2);
-    auto lowz = m_geom.ProbLo(2);
+        m_cons   = &cons_in;
+        m_qmoist = qmoist;
+
+        m_lat = lat;
+        m_lon = lon;
+
+        m_lsm_fluxes = lsm_fluxes;
+    }
 
     dt = dt_advance;
 
@@ -131,55 +140,191 @@ void Radiation::initialize (const MultiFab& cons_in,
     do_snow_optics    = do_snow_opt;
     is_cmip6_volc     = is_cmip6_volcano;
 
-    m_lat = lat;
-    m_lon = lon;
-
-    m_lsm_fluxes = lsm_fluxes;
     m_lsm_zenith = lsm_zenith;
 
-    rrtmgp_data_path = getRadiationDataDir() + "/";
-    rrtmgp_coefficients_file_sw = rrtmgp_data_path + rrtmgp_coefficients_file_name_sw;
-    rrtmgp_coefficients_file_lw = rrtmgp_data_path + rrtmgp_coefficients_file_name_lw;
-
-    ParmParse pp("erf");
-    pp.query("fixed_total_solar_irradiance", fixed_total_solar_irradiance);
-    pp.query("radiation_uniform_angle"     , uniform_angle);
-    pp.query("moisture_model", moisture_type); // TODO: get from SolverChoice?
-    has_qmoist = (moisture_type != "None");
-
-    nlev = geom.Domain().length(2);
-    ncol = 0;
-    rank_offsets.resize(cons_in.local_size());
-    for (MFIter mfi(cons_in, TileNoZ()); mfi.isValid(); ++mfi) {
-        const auto& box3d = mfi.tilebox();
-        int nx = box3d.length(0);
-        int ny = box3d.length(1);
-        rank_offsets[mfi.LocalIndex()] = ncol;
-        ncol += nx * ny;
+    if (!rrtmgp_loaded) {
+        rrtmgp_data_path = getRadiationDataDir() + "/";
+        rrtmgp_coefficients_file_sw = rrtmgp_data_path + rrtmgp_coefficients_file_name_sw;
+        rrtmgp_coefficients_file_lw = rrtmgp_data_path + rrtmgp_coefficients_file_name_lw;
+
+        ParmParse pp("erf");
+        pp.query("fixed_total_solar_irradiance", fixed_total_solar_irradiance);
+        pp.query("radiation_uniform_angle"     , uniform_angle);
+        pp.query("moisture_model", moisture_type); // TODO: get from SolverChoice?
+        has_qmoist = (moisture_type != "None");
+
+        // The diagnostics written to the radiation plotfile need all the columns at once
+        pp.query("radiation_column_chunk", column_chunk);
+        bool plot_rad = false;
+        pp.query("plot_rad", plot_rad);
+        if (plot_rad) column_chunk = 0;
+
+        ngas = active_gases.size();
+
+        // initialize cloud, aerosol, and radiation
+        radiation.initialize(ngas, active_gases,
+                             rrtmgp_coefficients_file_sw.c_str(),
+                             rrtmgp_coefficients_file_lw.c_str());
+
+        // initialize the radiation data
+        nswbands = radiation.get_nband_sw();
+        nswgpts  = radiation.get_ngpt_sw();
+        nlwbands = radiation.get_nband_lw();
+        nlwgpts  = radiation.get_ngpt_lw();
+
+        rrtmg_to_rrtmgp = int1d("rrtmg_to_rrtmgp",14);
+        parallel_for(14, YAKL_LAMBDA (int i)
+        {
+            if (i == 1) {
+                rrtmg_to_rrtmgp(i) = 13;
+            } else {
+                rrtmg_to_rrtmgp(i) = i - 1;
+            }
+        });
+
+        amrex::Print() << "LW coefficients file: " << rrtmgp_coefficients_file_lw
+                       << "\nSW coefficients file: " << rrtmgp_coefficients_file_sw
+                       << "\nFrequency (timesteps) of Shortwave Radiation calc: " << dt
+                       << "\nFrequency (timesteps) of Longwave Radiation calc:  " << dt
+                       << "\nDo aerosol radiative calculations: " << do_aerosol_rad << std::endl;
+
+        rrtmgp_loaded = true;
     }
 
-    ngas = active_gases.size();
+    if (m_ws_ba != m_cons->boxArray() || m_ws_dm != m_cons->DistributionMap()) {
+        m_ws_ba = m_cons->boxArray();
+        m_ws_dm = m_cons->DistributionMap();
+
+        nlev = m_geom.Domain().length(2);
+        ncol_rank = 0;
+        rank_offsets.resize(m_cons->local_size());
+        for (MFIter mfi(*m_cons); mfi.isValid(); ++mfi) {
+            const auto& box3d = mfi.validbox();
+            rank_offsets[mfi.LocalIndex()] = ncol_rank;
+            ncol_rank += box3d.length(0) * box3d.length(1);
+        }
+
+        // Chunks of equal size, the last one padded with copies of the last column
+        if (column_chunk > 0 && column_chunk < ncol_rank) {
+            int nchunk = (ncol_rank + column_chunk - 1) / column_chunk;
+            ncol = (ncol_rank + nchunk - 1) / nchunk;
+        } else {
+            ncol = std::max(ncol_rank, 1);
+        }
+
+        allocate_workspace();
+    }
+}
 
-    // initialize cloud, aerosol, and radiation
-    radiation.initialize(ngas, active_gases,
-                         rrtmgp_coefficients_file_sw.c_str(),
-                         rrtmgp_coefficients_file_lw.c_str());
+// average the inputs down to the coarsened grids on which RRTMGP runs
+void Radiation::coarsen_inputs (const MultiFab& cons_in,
+                                MultiFab* lsm_fluxes,
+                                MultiFab* qheating_rates,
+                                MultiFab* lat,
+                                MultiFab* lon,
+                                const Vector<MultiFab*>& qmoist,
+                                const Geometry& geom)
+{
+    BL_PROFILE("Radiation::coarsen_inputs()");
 
-    // initialize the radiation data
-    nswbands = radiation.get_nband_sw();
-    nswgpts  = radiation.get_ngpt_sw();
-    nlwbands = radiation.get_nband_lw();
-    nlwgpts  = radiation.get_ngpt_lw();
+    const IntVect ratio(m_coarsen, m_coarsen, 1);
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(cons_in.boxArray().coarsenable(ratio),
+                                     "erf.radiation_coarsen must divide the horizontal size of every grid");
 
-    rrtmg_to_rrtmgp = int1d("rrtmg_to_rrtmgp",14);
-    parallel_for(14, YAKL_LAMBDA (int i)
+    // (Re)allocate the coarse version of mf when its grids change
+    auto make_coarse = [&ratio] (std::unique_ptr<MultiFab>& mf_c, const MultiFab& mf, int ngrow)
     {
-        if (i == 1) {
-            rrtmg_to_rrtmgp(i) = 13;
-        } else {
-            rrtmg_to_rrtmgp(i) = i - 1;
+        BoxArray ba_c = amrex::coarsen(mf.boxArray(), ratio);
+        if (!mf_c || mf_c->boxArray() != ba_c || mf_c->DistributionMap() != mf.DistributionMap()) {
+            mf_c = std::make_unique<MultiFab>(ba_c, mf.DistributionMap(), mf.nComp(), ngrow);
         }
-    });
+        return mf_c.get();
+    };
+
+    m_geom = amrex::coarsen(geom, ratio);
+
+    m_cons = make_coarse(m_cons_c, cons_in, 0);
+    average_down(cons_in, *m_cons_c, 0, cons_in.nComp(), ratio);
+    m_box = m_cons_c->boxArray();
+
+    m_qmoist_c.resize(qmoist.size());
+    m_qmoist.assign(qmoist.size(), nullptr);
+    for (int n = 0; n < qmoist.size(); ++n) {
+        if (!qmoist[n]) continue;
+        m_qmoist[n] = make_coarse(m_qmoist_c[n], *qmoist[n], 0);
+        average_down(*qmoist[n], *m_qmoist_c[n], 0, qmoist[n]->nComp(), ratio);
+    }
+
+    m_lat = nullptr;
+    m_lon = nullptr;
+    if (lat && lon) {
+        m_lat = make_coarse(m_lat_c, *lat, 0);
+        m_lon = make_coarse(m_lon_c, *lon, 0);
+        average_down(*lat, *m_lat_c, 0, 1, ratio);
+        average_down(*lon, *m_lon_c, 0, 1, ratio);
+    }
+
+    // One ghost cell for the interpolation back to the grids of the caller
+    m_qrad_fine = qheating_rates;
+    qrad_src = make_coarse(m_qrad_c, *qheating_rates, 1);
+
+    m_lsm_fluxes_fine = lsm_fluxes;
+    m_lsm_fluxes = (lsm_fluxes) ? make_coarse(m_lsm_fluxes_c, *lsm_fluxes, 1) : nullptr;
+}
+
+// bilinear interpolation in the horizontal from the coarsened grids to the valid cells of fine
+void Radiation::interp_to_fine (MultiFab& crse, MultiFab& fine)
+{
+    BL_PROFILE("Radiation::interp_to_fine()");
+
+    crse.FillBoundary(m_geom.periodicity());
+
+    const int r = m_coarsen;
+    const Box& cdomain = m_geom.Domain();
+    const int ilo = cdomain.smallEnd(0);
+    const int ihi = cdomain.bigEnd(0);
+    const int jlo = cdomain.smallEnd(1);
+    const int jhi = cdomain.bigEnd(1);
+    const bool per_x = m_geom.isPeriodic(0);
+    const bool per_y = m_geom.isPeriodic(1);
+
+    // The coarse grids are the fine grids coarsened, so the boxes have the same indices
+    for (MFIter mfi(fine, TilingIfNotGPU()); mfi.isValid(); ++mfi) {
+        const Box& bx = mfi.tilebox();
+        auto const& crse_arr = crse.const_array(mfi);
+        auto const& fine_arr = fine.array(mfi);
+        ParallelFor(bx, fine.nComp(), [=] AMREX_GPU_DEVICE (int i, int j, int k, int n)
+        {
+            // Fine cell center in coarse cell units; the values on non-periodic
+            // domain edges are extended to the half coarse cell next to them
+            const Real x = (i + 0.5) / r - 0.5;
+            const Real y = (j + 0.5) / r - 0.5;
+            int i0 = static_cast<int>(std::floor(x));
+            int j0 = static_cast<int>(std::floor(y));
+            const Real wx = x - i0;
+            const Real wy = y - j0;
+            int i1 = i0 + 1;
+            int j1 = j0 + 1;
+            if (!per_x) {
+                i0 = amrex::Clamp(i0, ilo, ihi);
+                i1 = amrex::Clamp(i1, ilo, ihi);
+            }
+            if (!per_y) {
+                j0 = amrex::Clamp(j0, jlo, jhi);
+                j1 = amrex::Clamp(j1, jlo, jhi);
+            }
+            fine_arr(i,j,k,n) = (1.0-wx) * ((1.0-wy)*crse_arr(i0,j0,k,n) + wy*crse_arr(i0,j1,k,n))
+                              +      wx  * ((1.0-wy)*crse_arr(i1,j0,k,n) + wy*crse_arr(i1,j1,k,n));
+        });
+    }
+}
+
+// allocate the arrays of a chunk of columns
+void Radiation::allocate_workspace ()
+{
+    BL_PROFILE("Radiation::allocate_workspace()");
+
+    coszrs_rank = real1d("coszrs_rank", std::max(ncol_rank, 1));
 
     tmid = real2d("tmid", ncol, nlev);
     pmid = real2d("pmid", ncol, nlev);
@@ -194,54 +339,6 @@ void Radiation::initialize (const MultiFab& cons_in,
     qn   = real2d("qn", ncol, nlev);
     zi   = real2d("zi", ncol, nlev);
 
-    // Get the temperature, density, theta, qt and qp from input
-    for (MFIter mfi(cons_in, TileNoZ()); mfi.isValid(); ++mfi) {
-        const auto& box3d = mfi.tilebox();
-        auto nx = box3d.length(0);
-
-        auto states_array = cons_in.array(mfi);
-        auto qt_array = (has_qmoist) ? qmoist[0]->array(mfi) : Array4<Real> {};
-        auto qv_array = (has_qmoist) ? qmoist[1]->array(mfi) : Array4<Real> {};
-        auto qc_array = (has_qmoist) ? qmoist[2]->array(mfi) : Array4<Real> {};
-        auto qi_array = (has_qmoist && qmoist.size()>=8) ? qmoist[3]->array(mfi) : Array4<Real> {};
-        const int offset = rank_offsets[mfi.LocalIndex()];
-
-        // Get pressure, theta, temperature, density, and qt, qp
-        ParallelFor(box3d, [=] AMREX_GPU_DEVICE (int i, int j, int k)
-        {
-            auto icol = (j-box3d.smallEnd(1))*nx + (i-box3d.smallEnd(0)) + 1 + offset;
-            auto ilev = k+1;
-            Real qv         = (qv_array) ? qv_array(i,j,k): 0.0;
-            qt(icol,ilev)   = (qt_array) ? qt_array(i,j,k): 0.0;
-            qc(icol,ilev)   = (qc_array) ? qc_array(i,j,k): 0.0;
-            qi(icol,ilev)   = (qi_array) ? qi_array(i,j,k): 0.0;
-            qn(icol,ilev)   = qc(icol,ilev) + qi(icol,ilev);
-            tmid(icol,ilev) = getTgivenRandRTh(states_array(i,j,k,Rho_comp),states_array(i,j,k,RhoTheta_comp),qv);
-            // NOTE: RRTMGP code expects pressure in pa
-            pmid(icol,ilev) = getPgivenRTh(states_array(i,j,k,RhoTheta_comp),qv);
-        });
-    }
-
-    parallel_for(SimpleBounds<2>(ncol, nlev+1), YAKL_LAMBDA (int icol, int ilev)
-    {
-        if (ilev == 1) {
-            pint(icol, 1) = -0.5*pmid(icol, 2) + 1.5*pmid(icol, 1);
-            tint(icol, 1) = -0.5*tmid(icol, 2) + 1.5*tmid(icol, 1);
-        } else if (ilev <= nlev) {
-            pint(icol, ilev) = 0.5*(pmid(icol, ilev-1) + pmid(icol, ilev));
-            tint(icol, ilev) = 0.5*(tmid(icol, ilev-1) + tmid(icol, ilev));
-        } else {
-            pint(icol, nlev+1) = -0.5*pmid(icol, nlev-1) + 1.5*pmid(icol, nlev);
-            tint(icol, nlev+1) = -0.5*tmid(icol, nlev-1) + 1.5*tmid(icol, nlev);
-        }
-    });
-
-    parallel_for(SimpleBounds<2>(ncol, nlev), YAKL_LAMBDA (int icol, int ilev)
-    {
-        zi(icol, ilev)  = lowz + (ilev+0.5)*dz;
-        pdel(icol,ilev) = pint(icol,ilev+1) - pint(icol,ilev);
-    });
-
     albedo_dir = real2d("albedo_dir", nswbands, ncol);
     albedo_dif = real2d("albedo_dif", nswbands, ncol);
 
@@ -253,30 +350,6 @@ void Radiation::initialize (const MultiFab& cons_in,
     qrsc = real2d("qrsc", ncol, nlev);
     qrlc = real2d("qrlc", ncol, nlev);
 
-    int nmodes = 3;
-    int nrh = 1;
-    int top_lev = 1;
-    naer = 4;
-    std::vector<std::string> aero_names {"H2O", "N2", "O2", "O3"};
-    auto geom_radius = real2d("geom_radius", ncol, nlev);
-    yakl::memset(geom_radius, 0.1);
-
-    optics.initialize(ngas, nmodes, naer, nswbands, nlwbands,
-                      ncol, nlev, nrh, top_lev, aero_names, zi,
-                      pmid, pdel, tmid, qt, geom_radius);
-
-    amrex::Print() << "LW coefficients file: " << rrtmgp_coefficients_file_lw
-                   << "\nSW coefficients file: " << rrtmgp_coefficients_file_sw
-                   << "\nFrequency (timesteps) of Shortwave Radiation calc: " << dt
-                   << "\nFrequency (timesteps) of Longwave Radiation calc:  " << dt
-                   << "\nDo aerosol radiative calculations: " << do_aerosol_rad << std::endl;
-
-}
-
-
-// run radiation model
-void Radiation::run ()
-{
     // Cosine solar zenith angle for all columns in chunk
     coszrs = real1d("coszrs", ncol);
 
@@ -323,39 +396,171 @@ void Radiation::run ()
     gas_vmr = real3d("gas_vmr", ngas, ncol, nlev);
 
     // Needed for shortwave aerosol;
-    //int nday, nnight;     // Number of daylight columns
-    int1d day_indices("day_indices", ncol), night_indices("night_indices", ncol);   // Indices of daylight coumns
+    day_indices   = int1d("day_indices", ncol);
+    night_indices = int1d("night_indices", ncol);
 
-    // Flag to carry (QRS,QRL)*dp across time steps.
-    // TODO: what does this mean?
-    bool conserve_energy = true;
+    gpoint_bands_sw = int1d("gpoint_bands_sw", nswgpts);
+    gpoint_bands_lw = int1d("gpoint_bands_lw", nlwgpts);
 
-    // For loops over diagnostic calls
-    //bool active_calls(0:N_DIAG)
+    cld_tau_bnd_sw_1d = real1d("cld_tau_bnd_sw_1d", nswbands);
+    cld_ssa_bnd_sw_1d = real1d("cld_ssa_bnd_sw_1d", nswbands);
+    cld_asm_bnd_sw_1d = real1d("cld_asm_bnd_sw_1d", nswbands);
+    cld_tau_bnd_sw_o_1d = real1d("cld_tau_bnd_sw_1d", nswbands);
+    cld_ssa_bnd_sw_o_1d = real1d("cld_ssa_bnd_sw_1d", nswbands);
+    cld_asm_bnd_sw_o_1d = real1d("cld_asm_bnd_sw_1d", nswbands);
+
+    // Radiative fluxes
+    // NOTE: fluxes defined at interfaces, so initialize to have vertical dimension nlev_rad+1
+    internal::initial_fluxes(ncol, nlev+1, nswbands, sw_fluxes_allsky);
+    internal::initial_fluxes(ncol, nlev+1, nswbands, sw_fluxes_clrsky);
+    internal::initial_fluxes(ncol, nlev, nlwbands, lw_fluxes_allsky);
+    internal::initial_fluxes(ncol, nlev, nlwbands, lw_fluxes_clrsky);
+
+    // The aerosol optics keep the state arrays, which are refilled for every chunk
+    int nmodes = 3;
+    int nrh = 1;
+    int top_lev = 1;
+    naer = 4;
+    std::vector<std::string> aero_names {"H2O", "N2", "O2", "O3"};
+    auto geom_radius = real2d("geom_radius", ncol, nlev);
+    yakl::memset(geom_radius, 0.1);
 
-    // Zero-array for cloud properties if not diagnosed by microphysics
-    real2d zeros("zeros", ncol, nlev);
+    optics.initialize(ngas, nmodes, naer, nswbands, nlwbands,
+                      ncol, nlev, nrh, top_lev, aero_names, zi,
+                      pmid, pdel, tmid, qt, geom_radius);
+}
 
-    gpoint_bands_sw = int1d("gpoint_bands_sw", nswgpts);
-    gpoint_bands_lw = int1d("gpoint_bands_lw", nlwgpts);
+// fill the state of the columns of the current chunk
+void Radiation::fill_chunk_state ()
+{
+    auto dz   = m_geom.CellSize(2);
+    auto lowz = m_geom.ProbLo(2);
+
+    const int c_lo = chunk_lo;
+    const int c_hi = chunk_lo + ncol_valid;
+
+    // Get the temperature, density, theta, qt and qp from input
+    for (MFIter mfi(*m_cons); mfi.isValid(); ++mfi) {
+        const auto& vbx = mfi.validbox();
+        const int offset = rank_offsets[mfi.LocalIndex()];
+        const Box box3d = chunk_rows(vbx, offset);
+        if (!box3d.ok()) continue;
+        auto nx = vbx.length(0);
+        auto ylo = vbx.smallEnd(1);
+        auto xlo = vbx.smallEnd(0);
+
+        auto states_array = m_cons->const_array(mfi);
+        auto qt_array = (has_qmoist) ? m_qmoist[0]->array(mfi) : Array4<Real> {};
+        auto qv_array = (has_qmoist) ? m_qmoist[1]->array(mfi) : Array4<Real> {};
+        auto qc_array = (has_qmoist) ? m_qmoist[2]->array(mfi) : Array4<Real> {};
+        auto qi_array = (has_qmoist && m_qmoist.size()>=8) ? m_qmoist[3]->array(mfi) : Array4<Real> {};
+
+        // Get pressure, theta, temperature, density, and qt, qp
+        ParallelFor(box3d, [=] AMREX_GPU_DEVICE (int i, int j, int k)
+        {
+            auto rcol = (j-ylo)*nx + (i-xlo) + offset;
+            if (rcol < c_lo || rcol >= c_hi) return;
+            auto icol = rcol - c_lo + 1;
+            auto ilev = k+1;
+            Real qv         = (qv_array) ? qv_array(i,j,k): 0.0;
+            qt(icol,ilev)   = (qt_array) ? qt_array(i,j,k): 0.0;
+            qc(icol,ilev)   = (qc_array) ? qc_array(i,j,k): 0.0;
+            qi(icol,ilev)   = (qi_array) ? qi_array(i,j,k): 0.0;
+            qn(icol,ilev)   = qc(icol,ilev) + qi(icol,ilev);
+            tmid(icol,ilev) = getTgivenRandRTh(states_array(i,j,k,Rho_comp),states_array(i,j,k,RhoTheta_comp),qv);
+            // NOTE: RRTMGP code expects pressure in pa
+            pmid(icol,ilev) = getPgivenRTh(states_array(i,j,k,RhoTheta_comp),qv);
+        });
+    }
+
+    // Pad the last chunk with copies of its last column; their results are not used
+    const int nvalid = ncol_valid;
+    const int c_rank = ncol_rank;
+    if (nvalid < ncol) {
+        parallel_for(SimpleBounds<2>(ncol-nvalid, nlev), YAKL_LAMBDA (int ipad, int ilev)
+        {
+            auto icol = nvalid + ipad;
+            qt(icol,ilev)   = qt(nvalid,ilev);
+            qc(icol,ilev)   = qc(nvalid,ilev);
+            qi(icol,ilev)   = qi(nvalid,ilev);
+            qn(icol,ilev)   = qn(nvalid,ilev);
+            tmid(icol,ilev) = tmid(nvalid,ilev);
+            pmid(icol,ilev) = pmid(nvalid,ilev);
+        });
+    }
 
-    // Do shortwave stuff...
     if (do_short_wave_rad) {
-        // Radiative fluxes
-        internal::initial_fluxes(ncol, nlev+1, nswbands, sw_fluxes_allsky);
-        internal::initial_fluxes(ncol, nlev+1, nswbands, sw_fluxes_clrsky);
+        auto coszrs_all = coszrs_rank;
+        parallel_for(SimpleBounds<1>(ncol), YAKL_LAMBDA (int icol)
+        {
+            coszrs(icol) = coszrs_all(std::min(c_lo + icol, c_rank));
+        });
+    }
+
+    parallel_for(SimpleBounds<2>(ncol, nlev+1), YAKL_LAMBDA (int icol, int ilev)
+    {
+        if (ilev == 1) {
+            pint(icol, 1) = -0.5*pmid(icol, 2) + 1.5*pmid(icol, 1);
+            tint(icol, 1) = -0.5*tmid(icol, 2) + 1.5*tmid(icol, 1);
+        } else if (ilev <= nlev) {
+            pint(icol, ilev) = 0.5*(pmid(icol, ilev-1) + pmid(icol, ilev));
+            tint(icol, ilev) = 0.5*(tmid(icol, ilev-1) + tmid(icol, ilev));
+        } else {
+            pint(icol, nlev+1) = -0.5*pmid(icol, nlev-1) + 1.5*pmid(icol, nlev);
+            tint(icol, nlev+1) = -0.5*tmid(icol, nlev-1) + 1.5*tmid(icol, nlev);
+        }
+    });
+
+    parallel_for(SimpleBounds<2>(ncol, nlev), YAKL_LAMBDA (int icol, int ilev)
+    {
+        zi(icol, ilev)  = lowz + (ilev+0.5)*dz;
+        pdel(icol,ilev) = pint(icol,ilev+1) - pint(icol,ilev);
+    });
+}
+
 
+// run radiation model
+void Radiation::run ()
+{
+    BL_PROFILE("Radiation::run()");
+
+    // Get cosine solar zenith angle for current time step.
+    if (do_short_wave_rad && ncol_rank > 0) {
         // TODO: Integrate calendar day computation
         int calday = 1;
-        // Get cosine solar zenith angle for current time step.
         if (m_lat) {
-            zenith(calday, m_lat, m_lon, rank_offsets, coszrs, ncol,
+            zenith(calday, m_lat, m_lon, rank_offsets, coszrs_rank, ncol_rank,
                    eccen,  mvelpp, lambm0, obliqr);
         } else {
-            zenith(calday, m_lat, m_lon, rank_offsets, coszrs, ncol,
+            zenith(calday, m_lat, m_lon, rank_offsets, coszrs_rank, ncol_rank,
                    eccen,  mvelpp, lambm0, obliqr, uniform_angle);
         }
+    }
+
+    for (chunk_lo = 0; chunk_lo < ncol_rank; chunk_lo += ncol) {
+        ncol_valid = std::min(ncol, ncol_rank - chunk_lo);
+        fill_chunk_state();
+        run_chunk();
+    }
+
+    if (m_coarsen > 1) {
+        interp_to_fine(*m_qrad_c, *m_qrad_fine);
+        if (m_lsm_fluxes_fine) interp_to_fine(*m_lsm_fluxes_c, *m_lsm_fluxes_fine);
+    }
+}
+
+// run radiation model on the current chunk of columns
+void Radiation::run_chunk ()
+{
+    // Flag to carry (QRS,QRL)*dp across time steps.
+    // TODO: what does this mean?
+    bool conserve_energy = true;
+
+    // For loops over diagnostic calls
+    //bool active_calls(0:N_DIAG)
 
+    // Do shortwave stuff...
+    if (do_short_wave_rad) {
         // Get albedo. This uses CAM routines internally and just provides a
         // wrapper to improve readability of the code here.
         set_albedo(coszrs, albedo_dir, albedo_dif);
@@ -390,13 +595,6 @@ void Radiation::run ()
         // We need to fix band ordering because the old input files assume RRTMG
         // band ordering, but this has changed in RRTMGP.
         // TODO: fix the input files themselves!
-        cld_tau_bnd_sw_1d = real1d("cld_tau_bnd_sw_1d", nswbands);
-        cld_ssa_bnd_sw_1d = real1d("cld_ssa_bnd_sw_1d", nswbands);
-        cld_asm_bnd_sw_1d = real1d("cld_asm_bnd_sw_1d", nswbands);
-        cld_tau_bnd_sw_o_1d = real1d("cld_tau_bnd_sw_1d", nswbands);
-        cld_ssa_bnd_sw_o_1d = real1d("cld_ssa_bnd_sw_1d", nswbands);
-        cld_asm_bnd_sw_o_1d = real1d("cld_asm_bnd_sw_1d", nswbands);
-
         parallel_for(SimpleBounds<2>(ncol, nlev), YAKL_LAMBDA (int icol, int ilay)
         {
             for (auto ibnd = 1; ibnd <= nswbands; ++ibnd) {
@@ -513,11 +711,6 @@ void Radiation::run ()
 
     // Do longwave stuff...
     if (do_long_wave_rad) {
-        // Allocate longwave outputs; why is this not part of the fluxes_t object?
-        internal::initial_fluxes(ncol, nlev, nlwbands, lw_fluxes_allsky);
-        internal::initial_fluxes(ncol, nlev, nlwbands, lw_fluxes_clrsky);
-
-        // NOTE: fluxes defined at interfaces, so initialize to have vertical dimension nlev_rad+1
         yakl::memset(cld_tau_gpt_lw, 0.);
 
         optics.get_cloud_optics_lw(ncol, nlev, nlwbands, do_snow_optics, cld, cldfsnow, iclwp, iciwp, icswp,
@@ -558,15 +751,23 @@ void Radiation::run ()
     } // dolw
 
     // Populate source term for theta dycore variable
+    const int c_lo = chunk_lo;
+    const int c_hi = chunk_lo + ncol_valid;
     for (MFIter mfi(*(qrad_src)); mfi.isValid(); ++mfi) {
         auto qrad_src_array = qrad_src->array(mfi);
-        const auto& box3d = mfi.tilebox();
-        auto nx = box3d.length(0);
+        const auto& vbx = mfi.validbox();
         int const offset = rank_offsets[mfi.LocalIndex()];
+        const Box box3d = chunk_rows(vbx, offset);
+        if (!box3d.ok()) continue;
+        auto nx = vbx.length(0);
+        auto xlo = vbx.smallEnd(0);
+        auto ylo = vbx.smallEnd(1);
         amrex::ParallelFor(box3d, [=] AMREX_GPU_DEVICE (int i, int j, int k)
         {
             // Map (col,lev) to (i,j,k)
-            auto icol = (j-box3d.smallEnd(1))*nx + (i-box3d.smallEnd(0)) + 1 + offset;
+            auto rcol = (j-ylo)*nx + (i-xlo) + offset;
+            if (rcol < c_lo || rcol >= c_hi) return;
+            auto icol = rcol - c_lo + 1;
             auto ilev = k+1;
 
             // TODO: We do not include the cloud source term qrsc/qrlc.
@@ -878,8 +1079,6 @@ void Radiation::get_gas_vmr (const std::vector<std::string>& gas_names, const re
     // subset for daytime-only indices if needed.
     for (auto igas = 0; igas < gas_names.size(); ++igas) {
 
-        std::cout << "gas_name: " << gas_names[igas] << "; igas: " << igas << std::endl;
-
         if (gas_names[igas] == "CO"){
             // CO not available, use default
             parallel_for(SimpleBounds<2>(ncol, nlev), YAKL_LAMBDA (int icol, int ilev)
@@ -995,6 +1194,10 @@ Radiation::export_surface_fluxes(FluxesByband& fluxes,
     // No work to be done if we don't have valid pointers
     if (!m_lsm_fluxes) return;
 
+    // Only the columns of the current chunk that are not padding
+    const int c_lo = chunk_lo;
+    const int c_hi = chunk_lo + ncol_valid;
+
     if (band == "shortwave") {
         real3d flux_dn_diffuse("flux_dn_diffuse", ncol, nlev+1, nswbands);
 
@@ -1009,13 +1212,19 @@ Radiation::export_surface_fluxes(FluxesByband& fluxes,
         // Populate the LSM data structure (this is a 2D MF)
         for (MFIter mfi(*(m_lsm_fluxes)); mfi.isValid(); ++mfi) {
             auto lsm_array = m_lsm_fluxes->array(mfi);
-            const auto& box3d = mfi.tilebox();
-            auto nx = box3d.length(0);
+            const auto& vbx = mfi.validbox();
             const int offset = rank_offsets[mfi.LocalIndex()];
+            const Box box3d = chunk_rows(vbx, offset);
+            if (!box3d.ok()) continue;
+            auto nx = vbx.length(0);
+            auto xlo = vbx.smallEnd(0);
+            auto ylo = vbx.smallEnd(1);
             amrex::ParallelFor(box3d, [=] AMREX_GPU_DEVICE (int i, int j, int k)
             {
                 // Map (col,lev) to (i,j,k)
-                auto icol = (j-box3d.smallEnd(1))*nx + (i-box3d.smallEnd(0)) + 1 + offset;
+                auto rcol = (j-ylo)*nx + (i-xlo) + offset;
+                if (rcol < c_lo || rcol >= c_hi) return;
+                auto icol = rcol - c_lo + 1;
                 auto ilev = k+1;
 
                 // Direct fluxes
@@ -1052,13 +1261,19 @@ Radiation::export_surface_fluxes(FluxesByband& fluxes,
         // Populate the LSM data structure (this is a 2D MF)
         for (MFIter mfi(*(m_lsm_fluxes)); mfi.isValid(); ++mfi) {
             auto lsm_array = m_lsm_fluxes->array(mfi);
-            const auto& box3d = mfi.tilebox();
-            auto nx = box3d.length(0);
+            const auto& vbx = mfi.validbox();
             const int offset = rank_offsets[mfi.LocalIndex()];
+            const Box box3d = chunk_rows(vbx, offset);
+            if (!box3d.ok()) continue;
+            auto nx = vbx.length(0);
+            auto xlo = vbx.smallEnd(0);
+            auto ylo = vbx.smallEnd(1);
             amrex::ParallelFor(box3d, [=] AMREX_GPU_DEVICE (int i, int j, int k)
             {
                 // Map (col,lev) to (i,j,k)
-                auto icol = (j-box3d.smallEnd(1))*nx + (i-box3d.smallEnd(0)) + 1 + offset;
+                auto rcol = (j-ylo)*nx + (i-xlo) + offset;
+                if (rcol < c_lo || rcol >= c_hi) return;
+                auto icol = rcol - c_lo + 1;
                 auto ilev = k+1;
 
                 // Net fluxes
@@ -1076,7 +1291,9 @@ void Radiation::on_complete () { }
 void Radiation::yakl_to_mf(const real2d &data, amrex::MultiFab &mf)
 {
     // creates a MF from a YAKL real2d mapping from [col, lev] to [x,y,z]
-    // by reshaping the yakl array to the geometry of the output qsrc multifab
+    // by reshaping the yakl array to the geometry of the output qsrc multifab;
+    // the columns of the rank must all be in one chunk (erf.plot_rad sets this)
+    AMREX_ASSERT(ncol_valid == ncol_rank);
     mf = amrex::MultiFab(m_box, qrad_src->DistributionMap(), 1, 0);
     if (!data.initialized())
     {
@@ -1087,7 +1304,7 @@ void Radiation::yakl_to_mf(const real2d &data, amrex::MultiFab &mf)
 
     for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
         auto mf_arr = mf.array(mfi);
-        const auto& box3d = mfi.tilebox();
+        const auto& box3d = mfi.validbox();
         const int nx = box3d.length(0);
         const int offset = rank_offsets[mfi.LocalIndex()];
         amrex::ParallelFor(box3d, [=] AMREX_GPU_DEVICE (int i, int j, int k)
@@ -1104,8 +1321,9 @@ void Radiation::yakl_to_mf(const real2d &data, amrex::MultiFab &mf)
 
 void Radiation::expand_yakl1d_to_mf(const real1d &data, amrex::MultiFab &mf)
 {
-    // copies the 1D yakl data to a 3D MF
+    // copies the 1D yakl data to a 3D MF; all the columns of the rank are in one chunk
     AMREX_ASSERT(data.get_dimensions()(1) == ncol);
+    AMREX_ASSERT(ncol_valid == ncol_rank);
     mf = amrex::MultiFab(m_box, qrad_src->DistributionMap(), 1, 0);
     if (!data.initialized())
     {
@@ -1116,7 +1334,7 @@ void Radiation::expand_yakl1d_to_mf(const real1d &data, amrex::MultiFab &mf)
 
     for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
         auto mf_arr = mf.array(mfi);
-        const auto& box3d = mfi.tilebox();
+        const auto& box3d = mfi.validbox();
         const int nx = box3d.length(0);
         const int offset = rank_offsets[mfi.LocalIndex()];
         amrex::ParallelFor(box3d, [=] AMREX_GPU_DEVICE (int i, int j, int k)
@@ -73,6 +73,12 @@ moist_set_rhs (const Box& tbx,
                                   bx_ylo, bx_yhi,
                                   ng_vect, true);
 
+    // Skip the sides for which this rank holds no boundary data (see WRFBdyStream)
+    if (!bdy_data_xlo[n_time][WRFBdyVars::QV].box().ok()) bx_xlo = Box();
+    if (!bdy_data_xhi[n_time][WRFBdyVars::QV].box().ok()) bx_xhi = Box();
+    if (!bdy_data_ylo[n_time][WRFBdyVars::QV].box().ok()) bx_ylo = Box();
+    if (!bdy_data_yhi[n_time][WRFBdyVars::QV].box().ok()) bx_yhi = Box();
+
     // Temporary FABs for storage (owned/filled on all ranks)
     FArrayBox QV_xlo, QV_xhi, QV_ylo, QV_yhi;
     QV_xlo.resize(bx_xlo,1,The_Async_Arena()); QV_xhi.resize(bx_xhi,1,The_Async_Arena());
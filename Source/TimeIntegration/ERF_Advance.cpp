@@ -103,8 +103,12 @@ ERF::Advance (int lev, Real time, Real dt_lev, int iteration, int /*ncycle*/)
 
 #if defined(ERF_USE_WINDFARM)
     if (solverChoice.windfarm_type != WindFarmType::None) {
+        windfarm->set_box_cost(getBoxCost(lev));
         advance_windfarm(Geom(lev), dt_lev, S_old,
                          U_old, V_old, W_old, vars_windfarm[lev], Nturb[lev], SMark[lev]);
+        if (!solverChoice.windfarm_freestream_log.empty()) {
+            windfarm->write_freestream_log(solverChoice.windfarm_freestream_log, lev, time);
+        }
     }
 
 #endif
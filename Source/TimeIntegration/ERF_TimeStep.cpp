@@ -53,6 +53,16 @@ ERF::timeStep (int lev, Real time, int /*iteration*/)
         } // lev
     }
 
+    // Redistribute all levels on the costs measured since the last balancing
+    if (load_balance_int > 0 && lev == 0 &&
+        istep[0] > 0 && istep[0] % load_balance_int == 0)
+    {
+        rebalance(time);
+#ifdef ERF_USE_PARTICLES
+        particleData.Redistribute();
+#endif
+    }
+
     // Update what we call "old" and "new" time
     t_old[lev] = t_new[lev];
     t_new[lev] += dt[lev];
@@ -9,7 +9,8 @@ void ERF::advance_microphysics (int lev,
                                 const Real& time )
 {
     if (solverChoice.moisture_type != MoistureType::None) {
-        micro->Update_Micro_Vars_Lev(lev, cons);
+        micro->Set_State_Lev(lev, cons);
+        micro->Set_Box_Cost_Lev(lev, getBoxCost(lev));
         micro->Advance(lev, dt_advance, iteration, time, solverChoice, vars_new, z_phys_nd);
         micro->Update_State_Vars_Lev(lev, cons);
     }
@@ -3,6 +3,33 @@
 using namespace amrex;
 
 #if defined(ERF_USE_RRTMGP)
+namespace {
+/**
+ * Print the max and relative L2 errors of a component of the radiation outputs
+ *
+ * @param name Name of the field
+ * @param approx Result on the coarsened columns
+ * @param exact Result on the full resolution columns
+ * @param comp Component to compare
+ */
+void report_radiation_error (const std::string& name,
+                             const MultiFab& approx,
+                             const MultiFab& exact,
+                             int comp)
+{
+    MultiFab diff(exact.boxArray(), exact.DistributionMap(), 1, 0);
+    MultiFab::Copy(diff, approx, comp, 0, 1, 0);
+    MultiFab::Subtract(diff, exact, comp, 0, 1, 0);
+
+    const Real err_max = diff.norm0(0);
+    const Real err_l2  = diff.norm2(0);
+    const Real ref_l2  = exact.norm2(comp);
+
+    Print() << "    " << name << ": max error " << err_max
+            << ", relative L2 error " << ((ref_l2 > 0.0) ? err_l2/ref_l2 : err_l2) << "\n";
+}
+}
+
 void ERF::advance_radiation (int lev,
                              MultiFab& cons,
                              const Real& dt_advance)
@@ -13,22 +40,72 @@ void ERF::advance_radiation (int lev,
    bool do_snow_opt {true};
    bool is_cmip6_volcano {false};
 
-    rad.initialize(cons,
-                   sw_lw_fluxes[lev].get(),
-                   solar_zenith[lev].get(),
-                   qheating_rates[lev].get(),
-                   lat_m[lev].get(),
-                   lon_m[lev].get(),
-                   qmoist[lev],
-                   grids[lev],
-                   Geom(lev),
-                   dt_advance,
-                   do_sw_rad,
-                   do_lw_rad,
-                   do_aero_rad,
-                   do_snow_opt,
-                   is_cmip6_volcano);
-    rad.run();
-    rad.on_complete();
+    // The moisture variables may lag the state the microphysics updated
+    if (solverChoice.moisture_type != MoistureType::None) micro->Update_Qmoist_Lev(lev, cons);
+
+    if (!rad[lev]) rad[lev] = std::make_unique<Radiation>(rad_coarsen);
+
+    rad[lev]->initialize(cons,
+                         sw_lw_fluxes[lev].get(),
+                         solar_zenith[lev].get(),
+                         qheating_rates[lev].get(),
+                         lat_m[lev].get(),
+                         lon_m[lev].get(),
+                         qmoist[lev],
+                         grids[lev],
+                         Geom(lev),
+                         dt_advance,
+                         do_sw_rad,
+                         do_lw_rad,
+                         do_aero_rad,
+                         do_snow_opt,
+                         is_cmip6_volcano);
+    rad[lev]->run();
+    rad[lev]->on_complete();
+
+    // Compare with the radiation on all the columns, for the same state
+    if (rad_coarsen > 1 && rad_coarsen_check) {
+        if (!rad_check[lev]) rad_check[lev] = std::make_unique<Radiation>(1);
+
+        const MultiFab& qheat = *qheating_rates[lev];
+        MultiFab qheat_full(qheat.boxArray(), qheat.DistributionMap(), qheat.nComp(), 0);
+        qheat_full.setVal(0.);
+
+        std::unique_ptr<MultiFab> fluxes_full;
+        if (sw_lw_fluxes[lev]) {
+            fluxes_full = std::make_unique<MultiFab>(sw_lw_fluxes[lev]->boxArray(),
+                                                     sw_lw_fluxes[lev]->DistributionMap(),
+                                                     sw_lw_fluxes[lev]->nComp(), 0);
+            fluxes_full->setVal(0.);
+        }
+
+        rad_check[lev]->initialize(cons,
+                                   fluxes_full.get(),
+                                   solar_zenith[lev].get(),
+                                   &qheat_full,
+                                   lat_m[lev].get(),
+                                   lon_m[lev].get(),
+                                   qmoist[lev],
+                                   grids[lev],
+                                   Geom(lev),
+                                   dt_advance,
+                                   do_sw_rad,
+                                   do_lw_rad,
+                                   do_aero_rad,
+                                   do_snow_opt,
+                                   is_cmip6_volcano);
+        rad_check[lev]->run();
+        rad_check[lev]->on_complete();
+
+        Print() << "Radiation on columns coarsened by " << rad_coarsen
+                << " at level " << lev << " vs. full resolution:\n";
+        report_radiation_error("qsrc_sw", qheat, qheat_full, 0);
+        report_radiation_error("qsrc_lw", qheat, qheat_full, 1);
+        if (fluxes_full) {
+            for (int n = 0; n < fluxes_full->nComp(); ++n) {
+                report_radiation_error("sw_lw_fluxes " + std::to_string(n), *sw_lw_fluxes[lev], *fluxes_full, n);
+            }
+        }
+    }
 }
 #endif
@@ -44,6 +44,7 @@ using namespace amrex;
  * @param[in] mapfac_v map factor at y-faces
  * @param[inout] fr_as_crse YAFluxRegister at level l at level l   / l+1 interface
  * @param[inout] fr_as_fine YAFluxRegister at level l at level l-1 / l   interface
+ * @param[inout] box_cost   time spent on each box, accumulated if not null
  */
 
 void erf_slow_rhs_post (int level, int finest_level,
@@ -100,7 +101,8 @@ void erf_slow_rhs_post (int level, int finest_level,
                         Vector<Vector<FArrayBox>>& bdy_data_yhi,
 #endif
                         YAFluxRegister* fr_as_crse,
-                        YAFluxRegister* fr_as_fine)
+                        YAFluxRegister* fr_as_fine,
+                        LayoutData<Real>* box_cost)
 {
     BL_PROFILE_REGION("erf_slow_rhs_post()");
 
@@ -227,6 +229,13 @@ void erf_slow_rhs_post (int level, int finest_level,
 
       for ( MFIter mfi(S_data[IntVars::cons],TilingIfNotGPU()); mfi.isValid(); ++mfi) {
 
+        // Time the work on this box for the load balancing
+        Real box_wt = 0.0;
+        if (box_cost) {
+            Gpu::streamSynchronize();
+            box_wt = ParallelDescriptor::second();
+        }
+
         Box tbx  = mfi.tilebox();
 
         // *************************************************************************
@@ -553,6 +562,11 @@ void erf_slow_rhs_post (int level, int finest_level,
 
         } // two-way coupling
         } // end profile
+
+        if (box_cost) {
+            Gpu::streamSynchronize();
+            HostDevice::Atomic::Add(&(*box_cost)[mfi], ParallelDescriptor::second() - box_wt);
+        }
       } // mfi
     } // OMP
 }
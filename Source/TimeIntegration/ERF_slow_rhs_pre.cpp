@@ -62,6 +62,7 @@ using namespace amrex;
  * @param[in] mapfac_v map factor at y-faces
  * @param[inout] fr_as_crse YAFluxRegister at level l at level l   / l+1 interface
  * @param[inout] fr_as_fine YAFluxRegister at level l at level l-1 / l   interface
+ * @param[inout] box_cost   time spent on each box, accumulated if not null
  */
 
 void erf_slow_rhs_pre (int level, int finest_level,
@@ -115,7 +116,8 @@ void erf_slow_rhs_pre (int level, int finest_level,
                        EBFArrayBoxFactory const& ebfact,
 #endif
                        YAFluxRegister* fr_as_crse,
-                       YAFluxRegister* fr_as_fine)
+                       YAFluxRegister* fr_as_fine,
+                       LayoutData<Real>* box_cost)
 {
     BL_PROFILE_REGION("erf_slow_rhs_pre()");
 
@@ -249,6 +251,13 @@ void erf_slow_rhs_pre (int level, int finest_level,
 
     for ( MFIter mfi(S_data[IntVars::cons],TileNoZ()); mfi.isValid(); ++mfi)
     {
+        // Time the work on this box for the load balancing
+        Real box_wt = 0.0;
+        if (box_cost) {
+            Gpu::streamSynchronize();
+            box_wt = ParallelDescriptor::second();
+        }
+
         Box bx  = mfi.tilebox();
         Box tbx = mfi.nodaltilebox(0);
         Box tby = mfi.nodaltilebox(1);
@@ -773,6 +782,11 @@ void erf_slow_rhs_pre (int level, int finest_level,
 
         } // two-way coupling
         } // end profile
+
+        if (box_cost) {
+            Gpu::streamSynchronize();
+            HostDevice::Atomic::Add(&(*box_cost)[mfi], ParallelDescriptor::second() - box_wt);
+        }
     } // mfi
     } // OMP
 }
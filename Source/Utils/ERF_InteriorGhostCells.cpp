@@ -168,6 +168,11 @@ realbdy_compute_interior_ghost_rhs (const std::string& /*init_type*/,
     int  ivarR = RealBdyVars::R;
     int  ivarT = RealBdyVars::T;
 
+    // Sides for which this rank holds boundary data (all of them unless streaming)
+    const bool has_xlo = bdy_data_xlo[n_time][ivarR].box().ok();
+    const bool has_xhi = bdy_data_xhi[n_time][ivarR].box().ok();
+    const bool has_ylo = bdy_data_ylo[n_time][ivarR].box().ok();
+    const bool has_yhi = bdy_data_yhi[n_time][ivarR].box().ok();
 
     // Size the FABs
     //==========================================================
@@ -185,6 +190,10 @@ realbdy_compute_interior_ghost_rhs (const std::string& /*init_type*/,
                                       bx_xlo, bx_xhi,
                                       bx_ylo, bx_yhi,
                                       ng_vect, true);
+        if (!has_xlo) bx_xlo = Box();
+        if (!has_xhi) bx_xhi = Box();
+        if (!has_ylo) bx_ylo = Box();
+        if (!has_yhi) bx_yhi = Box();
 
         // Size the FABs
         if (ivar  == ivarU) {
@@ -224,6 +233,10 @@ realbdy_compute_interior_ghost_rhs (const std::string& /*init_type*/,
                                       bx_xlo, bx_xhi,
                                       bx_ylo, bx_yhi,
                                       ng_vect, true);
+        if (!has_xlo) bx_xlo = Box();
+        if (!has_xhi) bx_xhi = Box();
+        if (!has_ylo) bx_ylo = Box();
+        if (!has_yhi) bx_yhi = Box();
 
         Array4<Real> arr_xlo;  Array4<Real> arr_xhi;
         Array4<Real> arr_ylo;  Array4<Real> arr_yhi;
@@ -321,6 +334,10 @@ realbdy_compute_interior_ghost_rhs (const std::string& /*init_type*/,
                                       bx_xlo, bx_xhi,
                                       bx_ylo, bx_yhi,
                                       ng_vect, true);
+        if (!has_xlo) bx_xlo = Box();
+        if (!has_xhi) bx_xhi = Box();
+        if (!has_ylo) bx_ylo = Box();
+        if (!has_yhi) bx_yhi = Box();
 
         Array4<Real> rarr_xlo = R_xlo.array();  Array4<Real> rarr_xhi = R_xhi.array();
         Array4<Real> rarr_ylo = R_ylo.array();  Array4<Real> rarr_yhi = R_yhi.array();
@@ -193,10 +193,22 @@ WindFarm::read_windfarm_spec_table(const std::string windfarm_spec_table)
 
 }
 
+/**
+ * Fill the number of turbines in each cell, visiting in each box only the turbines
+ * that the turbine index bins with it
+ *
+ * @param lev Level of mf_Nturb
+ * @param geom Geometry at that level
+ * @param mf_Nturb MultiFab holding the number of turbines in each cell
+ */
 void
-WindFarm::fill_Nturb_multifab(const Geometry& geom,
+WindFarm::fill_Nturb_multifab(int lev,
+                              const Geometry& geom,
                               MultiFab& mf_Nturb)
 {
+    // A turbine only affects the cell holding its location
+    TurbineIndex& index = turb_index(lev, false);
+    index.build(mf_Nturb, geom, xloc, xloc, yloc, yloc);
 
     amrex::Gpu::DeviceVector<Real> d_xloc(xloc.size());
     amrex::Gpu::DeviceVector<Real> d_yloc(yloc.size());
@@ -216,10 +228,13 @@ WindFarm::fill_Nturb_multifab(const Geometry& geom,
               "It should be usually of order 1 m");
     }
     auto ProbLoArr = geom.ProbLoArray();
-    int num_turb = xloc.size();
 
      // Initialize wind farm
     for ( MFIter mfi(mf_Nturb,TilingIfNotGPU()); mfi.isValid(); ++mfi) {
+        const int n_box_turb = index.count(mfi.LocalIndex());
+        if (n_box_turb == 0) continue;
+        const int* box_turb = index.ids(mfi.LocalIndex());
+
         const Box& bx     = mfi.tilebox();
         auto  Nturb_array = mf_Nturb.array(mfi);
         ParallelFor(bx, [=] AMREX_GPU_DEVICE(int i, int j, int k) noexcept {
@@ -231,7 +246,8 @@ WindFarm::fill_Nturb_multifab(const Geometry& geom,
             Real y1 = ProbLoArr[1] + lj*dx[1];
             Real y2 = ProbLoArr[1] + (lj+1)*dx[1];
 
-            for(int it=0; it<num_turb; it++){
+            for(int m=0; m<n_box_turb; m++){
+                const int it = box_turb[m];
                 if( d_xloc_ptr[it]+1e-3 > x1 and d_xloc_ptr[it]+1e-3 < x2 and
                     d_yloc_ptr[it]+1e-3 > y1 and d_yloc_ptr[it]+1e-3 < y2){
                        Nturb_array(i,j,k,0) = Nturb_array(i,j,k,0) + 1;
@@ -241,8 +257,20 @@ WindFarm::fill_Nturb_multifab(const Geometry& geom,
     }
 }
 
+/**
+ * Mark the cells of the actuator disks (component 1) and of the disks where the
+ * freestream velocity is sampled (component 0) with the index of their turbine,
+ * visiting in each box only the turbines that the disk index bins with it
+ *
+ * @param lev Level of mf_SMark
+ * @param geom Geometry at that level
+ * @param mf_SMark MultiFab holding the markers
+ * @param sampling_distance_by_D Upstream distance of the sampling disk in rotor diameters
+ * @param turb_disk_angle Orientation of the disks in degrees
+ */
 void
-WindFarm::fill_SMark_multifab(const Geometry& geom,
+WindFarm::fill_SMark_multifab(int lev,
+                              const Geometry& geom,
                               MultiFab& mf_SMark,
                               const Real& sampling_distance_by_D,
                               const Real& turb_disk_angle)
@@ -276,8 +304,29 @@ WindFarm::fill_SMark_multifab(const Geometry& geom,
     Real nx = -std::cos(theta);
     Real ny = -std::sin(theta);
 
+    // Horizontal extent of the cells find_if_marked can mark around a disk centre: within
+    // a rotor radius across y, and as far as the disk plane reaches in x over that range
+    const Real ext_y = rotor_rad;
+    const Real ext_x = std::min(rotor_rad*std::abs(ny)/std::max(std::abs(nx), Real(1e-10)),
+                                geom.ProbLength(0));
+    Vector<Real> xlo(num_turb), xhi(num_turb), ylo(num_turb), yhi(num_turb);
+    for (int it = 0; it < num_turb; ++it) {
+        Real xs = xloc[it] + d_sampling_distance*nx;
+        Real ys = yloc[it] + d_sampling_distance*ny;
+        xlo[it] = std::min(xloc[it], xs) - ext_x;
+        xhi[it] = std::max(xloc[it], xs) + ext_x;
+        ylo[it] = std::min(yloc[it], ys) - ext_y;
+        yhi[it] = std::max(yloc[it], ys) + ext_y;
+    }
+    TurbineIndex& index = turb_index(lev, true);
+    index.build(mf_SMark, geom, xlo, xhi, ylo, yhi);
+
      // Initialize wind farm
     for ( MFIter mfi(mf_SMark,TilingIfNotGPU()); mfi.isValid(); ++mfi) {
+        const int n_box_turb = index.count(mfi.LocalIndex());
+        if (n_box_turb == 0) continue;
+        const int* box_turb = index.ids(mfi.LocalIndex());
+
         const Box& bx     = mfi.tilebox();
         auto  SMark_array = mf_SMark.array(mfi);
         ParallelFor(bx, [=] AMREX_GPU_DEVICE(int i, int j, int k) noexcept {
@@ -292,7 +341,8 @@ WindFarm::fill_SMark_multifab(const Geometry& geom,
 
             Real z = ProbLoArr[2] + (kk+0.5) * dx[2];
 
-            for(int it=0; it<num_turb; it++){
+            for(int m=0; m<n_box_turb; m++){
+                const int it = box_turb[m];
                 Real x0 = d_xloc_ptr[it] + d_sampling_distance*nx;
                 Real y0 = d_yloc_ptr[it] + d_sampling_distance*ny;
 
@@ -0,0 +1,127 @@
+#include <ERF_TurbineIndex.H>
+#include <AMReX_Reduce.H>
+
+#include <limits>
+
+using namespace amrex;
+
+/**
+ * Bin the turbines onto the local boxes of a MultiFab
+ *
+ * @param mf MultiFab whose grids (grown by its ghost cells) are binned
+ * @param geom Geometry at the level of mf
+ * @param xlo Lower x extent of the footprint of each turbine
+ * @param xhi Upper x extent of the footprint of each turbine
+ * @param ylo Lower y extent of the footprint of each turbine
+ * @param yhi Upper y extent of the footprint of each turbine
+ */
+void
+TurbineIndex::build (const MultiFab& mf,
+                     const Geometry& geom,
+                     const Vector<Real>& xlo, const Vector<Real>& xhi,
+                     const Vector<Real>& ylo, const Vector<Real>& yhi)
+{
+    BL_PROFILE("ERF::TurbineIndex::build()");
+
+    m_domain = geom.Domain();
+    m_ba = mf.boxArray();
+    m_dm = mf.DistributionMap();
+
+    const Box& domain = geom.Domain();
+    auto dxi = geom.InvCellSizeArray();
+    auto plo = geom.ProbLoArray();
+
+    // Cells touched by each footprint, padded by one cell for the tolerances of the kernels
+    const int num_turb = xlo.size();
+    Vector<int> ilo(num_turb), ihi(num_turb), jlo(num_turb), jhi(num_turb);
+    for (int it = 0; it < num_turb; ++it) {
+        ilo[it] = static_cast<int>(std::floor((xlo[it] - plo[0]) * dxi[0])) - 1;
+        ihi[it] = static_cast<int>(std::floor((xhi[it] - plo[0]) * dxi[0])) + 1;
+        jlo[it] = static_cast<int>(std::floor((ylo[it] - plo[1]) * dxi[1])) - 1;
+        jhi[it] = static_cast<int>(std::floor((yhi[it] - plo[1]) * dxi[1])) + 1;
+    }
+
+    auto clamp = [] (int i, int lo, int hi) { return std::min(std::max(i, lo), hi); };
+
+    const int nlocal = mf.local_size();
+    Vector<Vector<int>> box_ids(nlocal);
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi)
+    {
+        const Box bx = amrex::grow(mfi.validbox(), mf.nGrowVect());
+
+        // Cells outside the domain see the turbines of the nearest cell inside it
+        const int bilo = clamp(bx.smallEnd(0), domain.smallEnd(0), domain.bigEnd(0));
+        const int bihi = clamp(bx.bigEnd(0)  , domain.smallEnd(0), domain.bigEnd(0));
+        const int bjlo = clamp(bx.smallEnd(1), domain.smallEnd(1), domain.bigEnd(1));
+        const int bjhi = clamp(bx.bigEnd(1)  , domain.smallEnd(1), domain.bigEnd(1));
+
+        auto& ids = box_ids[mfi.LocalIndex()];
+        for (int it = 0; it < num_turb; ++it) {
+            if (ilo[it] <= bihi && ihi[it] >= bilo && jlo[it] <= bjhi && jhi[it] >= bjlo) {
+                ids.push_back(it);
+            }
+        }
+    }
+
+    m_offsets.assign(nlocal+1, 0);
+    for (int li = 0; li < nlocal; ++li) {
+        m_offsets[li+1] = m_offsets[li] + static_cast<int>(box_ids[li].size());
+    }
+
+    m_host_ids.clear();
+    m_host_ids.reserve(m_offsets[nlocal]);
+    for (const auto& ids : box_ids) {
+        m_host_ids.insert(m_host_ids.end(), ids.begin(), ids.end());
+    }
+
+    m_ids.resize(m_host_ids.size());
+    Gpu::copy(Gpu::hostToDevice, m_host_ids.begin(), m_host_ids.end(), m_ids.begin());
+}
+
+/**
+ * Find, for each local box, the bounding box of the cells holding turbines
+ *
+ * @param mf_Nturb MultiFab holding the number of turbines in each cell
+ * @param geom Geometry at the level of mf_Nturb
+ */
+void
+TurbineActiveRegion::build (const MultiFab& mf_Nturb, const Geometry& geom)
+{
+    BL_PROFILE("ERF::TurbineActiveRegion::build()");
+
+    AMREX_ALWAYS_ASSERT(mf_Nturb.nGrow() >= 1);
+
+    m_domain = geom.Domain();
+    m_ba = mf_Nturb.boxArray();
+    m_dm = mf_Nturb.DistributionMap();
+    m_boxes.assign(mf_Nturb.local_size(), Box());
+
+    constexpr int imax = std::numeric_limits<int>::max();
+    constexpr int imin = std::numeric_limits<int>::lowest();
+
+    for (MFIter mfi(mf_Nturb); mfi.isValid(); ++mfi)
+    {
+        const Box gbx = amrex::grow(mfi.validbox(), 1);
+        auto const& Nturb_array = mf_Nturb.const_array(mfi);
+
+        ReduceOps<ReduceOpMin, ReduceOpMin, ReduceOpMin,
+                  ReduceOpMax, ReduceOpMax, ReduceOpMax> reduce_op;
+        ReduceData<int, int, int, int, int, int> reduce_data(reduce_op);
+        using ReduceTuple = typename decltype(reduce_data)::Type;
+
+        reduce_op.eval(gbx, reduce_data,
+        [=] AMREX_GPU_DEVICE (int i, int j, int k) -> ReduceTuple
+        {
+            if (Nturb_array(i,j,k) != 0.) {
+                return {i, j, k, i, j, k};
+            }
+            return {imax, imax, imax, imin, imin, imin};
+        });
+
+        ReduceTuple r = reduce_data.value(reduce_op);
+        if (amrex::get<0>(r) <= amrex::get<3>(r)) {
+            m_boxes[mfi.LocalIndex()] = Box(IntVect(amrex::get<0>(r), amrex::get<1>(r), amrex::get<2>(r)),
+                                            IntVect(amrex::get<3>(r), amrex::get<4>(r), amrex::get<5>(r)));
+        }
+    }
+}
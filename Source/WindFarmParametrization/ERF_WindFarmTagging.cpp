@@ -0,0 +1,209 @@
+/**
+ * \file ERF_WindFarmTagging.cpp
+ */
+
+#include <ERF_WindFarm.H>
+
+#include <limits>
+
+using namespace amrex;
+
+/**
+ * Wind direction at each turbine, from the freestream the model samples if it does
+ * (SimpleAD) and otherwise from the velocity at the hub of the turbine
+ *
+ * @param geom Geometry at the level of the velocities
+ * @param U_old x-velocity
+ * @param V_old y-velocity
+ * @param phi Wind direction w.r.t. the x-direction of each turbine
+ */
+void
+WindFarm::turbine_wind_direction (const Geometry& geom,
+                                  const MultiFab& U_old,
+                                  const MultiFab& V_old,
+                                  Vector<Real>& phi)
+{
+    const int num_turb = xloc.size();
+
+    // Freestream of the model; only the I/O rank contributes it so that the sums are not repeated
+    Vector<Real> freestream_phi, freestream_ncells;
+    get_freestream_direction(freestream_phi, freestream_ncells);
+
+    // Per turbine: u and v at the hub, freestream direction sum and sampling cell count
+    Vector<Real> sums(4*num_turb, 0.0);
+    if (ParallelDescriptor::IOProcessor() && freestream_phi.size() == num_turb) {
+        for (int it = 0; it < num_turb; ++it) {
+            sums[4*it+2] = freestream_phi[it];
+            sums[4*it+3] = freestream_ncells[it];
+        }
+    }
+
+    const Box& domain = geom.Domain();
+    auto dxi = geom.InvCellSizeArray();
+    auto plo = geom.ProbLoArray();
+
+    // Cell holding the hub of each turbine
+    Vector<IntVect> hub(num_turb);
+    for (int it = 0; it < num_turb; ++it) {
+        IntVect iv(static_cast<int>(std::floor((xloc[it]     - plo[0]) * dxi[0])),
+                   static_cast<int>(std::floor((yloc[it]     - plo[1]) * dxi[1])),
+                   static_cast<int>(std::floor((hub_height   - plo[2]) * dxi[2])));
+        iv.min(domain.bigEnd());
+        iv.max(domain.smallEnd());
+        hub[it] = iv;
+    }
+
+    Gpu::DeviceVector<Real> d_uv(2*num_turb, 0.0);
+    Real* d_uv_ptr = d_uv.data();
+
+    // Each hub cell lies in exactly one valid box, so the writes do not collide
+    for (MFIter mfi(U_old); mfi.isValid(); ++mfi)
+    {
+        const Box vbx = amrex::enclosedCells(mfi.validbox());
+        Vector<int> h_ids;
+        for (int it = 0; it < num_turb; ++it) {
+            if (vbx.contains(hub[it])) h_ids.push_back(it);
+        }
+        if (h_ids.empty()) continue;
+
+        const int n_box_turb = h_ids.size();
+        Gpu::DeviceVector<int> d_ids(n_box_turb);
+        Gpu::DeviceVector<IntVect> d_hub(n_box_turb);
+        Vector<IntVect> h_hub(n_box_turb);
+        for (int m = 0; m < n_box_turb; ++m) h_hub[m] = hub[h_ids[m]];
+        Gpu::copy(Gpu::hostToDevice, h_ids.begin(), h_ids.end(), d_ids.begin());
+        Gpu::copy(Gpu::hostToDevice, h_hub.begin(), h_hub.end(), d_hub.begin());
+        const int* d_ids_ptr = d_ids.data();
+        const IntVect* d_hub_ptr = d_hub.data();
+
+        auto u_vel = U_old.const_array(mfi);
+        auto v_vel = V_old.const_array(mfi);
+
+        ParallelFor(n_box_turb, [=] AMREX_GPU_DEVICE (int m) noexcept
+        {
+            const int it = d_ids_ptr[m];
+            const int i = d_hub_ptr[m][0];
+            const int j = d_hub_ptr[m][1];
+            const int k = d_hub_ptr[m][2];
+            d_uv_ptr[2*it  ] = 0.5*(u_vel(i,j,k) + u_vel(i+1,j,k));
+            d_uv_ptr[2*it+1] = 0.5*(v_vel(i,j,k) + v_vel(i,j+1,k));
+        });
+        Gpu::streamSynchronize();
+    }
+
+    Vector<Real> h_uv(2*num_turb);
+    Gpu::copy(Gpu::deviceToHost, d_uv.begin(), d_uv.end(), h_uv.begin());
+    for (int it = 0; it < num_turb; ++it) {
+        sums[4*it  ] = h_uv[2*it  ];
+        sums[4*it+1] = h_uv[2*it+1];
+    }
+
+    ParallelDescriptor::ReduceRealSum(sums.data(), static_cast<int>(sums.size()));
+
+    phi.resize(num_turb);
+    for (int it = 0; it < num_turb; ++it) {
+        if (sums[4*it+3] > 0.0) {
+            phi[it] = sums[4*it+2]/sums[4*it+3];
+        } else {
+            phi[it] = std::atan2(sums[4*it+1], sums[4*it]);
+        }
+    }
+}
+
+/**
+ * Fill a tagging field that is one in the cells of the rotor-swept columns and of
+ * the downstream wake of each turbine, and zero elsewhere
+ *
+ * The region of a turbine is a rectangle aligned with the wind direction at the
+ * turbine, from one rotor radius upstream to wake_length_by_D diameters plus one
+ * radius downstream and wake_width_by_D diameters wide, extending from the ground to
+ * the top of the rotor. Cells the region touches are tagged.
+ *
+ * @param geom Geometry at the level of mf
+ * @param mf MultiFab (one component) to fill
+ * @param U_old x-velocity
+ * @param V_old y-velocity
+ * @param wake_length_by_D Length of the wake downstream of the rotor in rotor diameters
+ * @param wake_width_by_D Width of the refined region in rotor diameters
+ */
+void
+WindFarm::fill_wake_tags (const Geometry& geom,
+                          MultiFab& mf,
+                          const MultiFab& U_old,
+                          const MultiFab& V_old,
+                          const Real& wake_length_by_D,
+                          const Real& wake_width_by_D)
+{
+    BL_PROFILE("ERF::WindFarm::fill_wake_tags()");
+
+    Vector<Real> phi;
+    turbine_wind_direction(geom, U_old, V_old, phi);
+
+    mf.setVal(0.0);
+
+    const int num_turb = xloc.size();
+    if (num_turb == 0) return;
+
+    auto dx  = geom.CellSizeArray();
+    auto dxi = geom.InvCellSizeArray();
+    auto plo = geom.ProbLoArray();
+
+    const Real s_lo = -rotor_rad;
+    const Real s_hi =  rotor_rad + 2.0*rotor_rad*wake_length_by_D;
+    const Real t_hw = std::max(rotor_rad*wake_width_by_D, rotor_rad);
+    const Real z_hi = hub_height + rotor_rad;
+
+    // Half a cell diagonal, so that any cell the region touches is tagged
+    const Real pad = 0.5*std::sqrt(dx[0]*dx[0] + dx[1]*dx[1]);
+
+    // Cells covering the region of each turbine
+    Vector<Box> turb_box(num_turb);
+    const int khi = static_cast<int>(std::floor((z_hi - plo[2]) * dxi[2]));
+    for (int it = 0; it < num_turb; ++it) {
+        const Real c = std::cos(phi[it]);
+        const Real s = std::sin(phi[it]);
+        Real xmin = xloc[it], xmax = xloc[it], ymin = yloc[it], ymax = yloc[it];
+        for (Real sv : {s_lo, s_hi}) {
+            for (Real tv : {-t_hw, t_hw}) {
+                xmin = std::min(xmin, xloc[it] + sv*c - tv*s);
+                xmax = std::max(xmax, xloc[it] + sv*c - tv*s);
+                ymin = std::min(ymin, yloc[it] + sv*s + tv*c);
+                ymax = std::max(ymax, yloc[it] + sv*s + tv*c);
+            }
+        }
+        turb_box[it] = Box(IntVect(static_cast<int>(std::floor((xmin - pad - plo[0]) * dxi[0])),
+                                   static_cast<int>(std::floor((ymin - pad - plo[1]) * dxi[1])),
+                                   std::numeric_limits<int>::lowest()),
+                           IntVect(static_cast<int>(std::floor((xmax + pad - plo[0]) * dxi[0])),
+                                   static_cast<int>(std::floor((ymax + pad - plo[1]) * dxi[1])),
+                                   khi));
+    }
+
+    for (MFIter mfi(mf,TilingIfNotGPU()); mfi.isValid(); ++mfi)
+    {
+        const Box& bx = mfi.tilebox();
+        auto tag_array = mf.array(mfi);
+
+        for (int it = 0; it < num_turb; ++it)
+        {
+            const Box tbx = bx & turb_box[it];
+            if (!tbx.ok()) continue;
+
+            const Real xt = xloc[it];
+            const Real yt = yloc[it];
+            const Real c  = std::cos(phi[it]);
+            const Real s  = std::sin(phi[it]);
+
+            ParallelFor(tbx, [=] AMREX_GPU_DEVICE (int i, int j, int k) noexcept
+            {
+                const Real x = plo[0] + (i+0.5)*dx[0] - xt;
+                const Real y = plo[1] + (j+0.5)*dx[1] - yt;
+                const Real sv =  x*c + y*s;
+                const Real tv = -x*s + y*c;
+                if (sv >= s_lo - pad && sv <= s_hi + pad && std::abs(tv) <= t_hw + pad) {
+                    tag_array(i,j,k) = 1.0;
+                }
+            });
+        }
+    }
+}
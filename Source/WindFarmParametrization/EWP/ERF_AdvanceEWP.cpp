@@ -1,5 +1,6 @@
 #include <ERF_EWP.H>
 #include <ERF_IndexDefines.H>
+#include <ERF_ParFunctions.H>
 #include <ERF_Constants.H>
 #include <ERF_Interpolation_1D.H>
 
@@ -30,6 +31,7 @@ EWP::update (const Real& dt_advance,
 {
 
     for ( MFIter mfi(cons_in,TilingIfNotGPU()); mfi.isValid(); ++mfi) {
+        BoxCostTimer box_timer(m_box_cost, mfi);
 
         Box bx  = mfi.tilebox();
         Box tbx = mfi.nodaltilebox(0);
@@ -92,9 +94,20 @@ EWP::source_terms_cellcentered (const Geometry& geom,
   // The order of variables are - Vabs dVabsdt, dudt, dvdt, dTKEdt
   mf_vars_ewp.setVal(0.0);
 
+  // The sources vanish in the columns without turbines, so only the columns around
+  // the turbines of each box are visited; the Gaussian spreads them over the full height
+  const TurbineActiveRegion& region = active_region(mf_Nturb, geom);
+
   for ( MFIter mfi(cons_in,TilingIfNotGPU()); mfi.isValid(); ++mfi) {
+        BoxCostTimer box_timer(m_box_cost, mfi);
+
+        Box gbx = mfi.growntilebox(1) & region.box(mfi.LocalIndex());
+        if (!gbx.ok()) continue;
+
+        Box col = mfi.growntilebox(1);
+        gbx.setSmall(2, col.smallEnd(2));
+        gbx.setBig  (2, col.bigEnd(2));
 
-        const Box& gbx = mfi.growntilebox(1);
         auto ewp_array = mf_vars_ewp.array(mfi);
         auto Nturb_array = mf_Nturb.array(mfi);
         auto u_vel       = U_old.array(mfi);
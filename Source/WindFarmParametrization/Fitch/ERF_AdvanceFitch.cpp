@@ -1,8 +1,11 @@
 #include <ERF_Fitch.H>
 #include <ERF_IndexDefines.H>
+#include <ERF_ParFunctions.H>
 #include <ERF_Constants.H>
 #include <ERF_Interpolation_1D.H>
 
+#include <limits>
+
 using namespace amrex;
 
 AMREX_FORCE_INLINE
@@ -70,6 +73,7 @@ Fitch::update (const Real& dt_advance,
 {
 
     for ( MFIter mfi(cons_in,TilingIfNotGPU()); mfi.isValid(); ++mfi) {
+        BoxCostTimer box_timer(m_box_cost, mfi);
 
         Box bx  = mfi.tilebox();
         Box tbx = mfi.nodaltilebox(0);
@@ -131,9 +135,25 @@ Fitch::source_terms_cellcentered (const Geometry& geom,
     Gpu::copy(Gpu::hostToDevice, wind_speed.begin(), wind_speed.end(), d_wind_speed.begin());
     Gpu::copy(Gpu::hostToDevice, thrust_coeff.begin(), thrust_coeff.end(), d_thrust_coeff.begin());
 
+  // The sources vanish away from the turbines and outside the rotor height,
+  // so only the cells around the turbines of each box are visited
+  const TurbineActiveRegion& region = active_region(mf_Nturb, geom);
+
+  // Cells (padded by one) whose height range overlaps the rotor; a range reaching the
+  // domain boundary also covers the ghost cells that are clamped onto it
+  int k_rotor_lo = static_cast<int>(std::floor((hub_height - rotor_rad)/dx[2])) - 1;
+  int k_rotor_hi = static_cast<int>(std::floor((hub_height + rotor_rad)/dx[2])) + 1;
+  if (k_rotor_lo <= domlo_z) k_rotor_lo = std::numeric_limits<int>::lowest();
+  if (k_rotor_hi >= domhi_z) k_rotor_hi = std::numeric_limits<int>::max();
+
   for ( MFIter mfi(cons_in,TilingIfNotGPU()); mfi.isValid(); ++mfi) {
+        BoxCostTimer box_timer(m_box_cost, mfi);
+
+        Box gbx = mfi.growntilebox(1) & region.box(mfi.LocalIndex());
+        gbx.setSmall(2, amrex::max(gbx.smallEnd(2), k_rotor_lo));
+        gbx.setBig  (2, amrex::min(gbx.bigEnd(2)  , k_rotor_hi));
+        if (!gbx.ok()) continue;
 
-        const Box& gbx = mfi.growntilebox(1);
         auto fitch_array = mf_vars_fitch.array(mfi);
         auto Nturb_array = mf_Nturb.array(mfi);
         auto u_vel       = U_old.array(mfi);
@@ -1,5 +1,12 @@
 #include <ERF_SimpleAD.H>
 #include <ERF_IndexDefines.H>
+#include <ERF_ParFunctions.H>
+#include <AMReX_Reduce.H>
+#include <AMReX_Utility.H>
+
+#include <fstream>
+#include <iomanip>
+#include <limits>
 
 using namespace amrex;
 
@@ -16,7 +23,7 @@ SimpleAD::advance (const Geometry& geom,
 {
     AMREX_ALWAYS_ASSERT(W_old.nComp() > 0);
     AMREX_ALWAYS_ASSERT(mf_Nturb.nComp() > 0);
-    compute_freestream_velocity(cons_in, U_old, V_old, mf_SMark);
+    compute_freestream_velocity(geom, cons_in, U_old, V_old, mf_SMark);
     source_terms_cellcentered(geom, cons_in, mf_SMark, mf_vars_simpleAD);
     update(dt_advance, cons_in, U_old, V_old, mf_vars_simpleAD);
 }
@@ -29,6 +36,7 @@ SimpleAD::update (const Real& dt_advance,
 {
 
     for ( MFIter mfi(cons_in,TilingIfNotGPU()); mfi.isValid(); ++mfi) {
+        BoxCostTimer box_timer(m_box_cost, mfi);
 
         Box tbx = mfi.nodaltilebox(0);
         Box tby = mfi.nodaltilebox(1);
@@ -49,80 +57,233 @@ SimpleAD::update (const Real& dt_advance,
     }
 }
 
-void SimpleAD::compute_freestream_velocity(const MultiFab& cons_in,
-                                           const MultiFab& U_old,
-                                           const MultiFab& V_old,
-                                           const MultiFab& mf_SMark)
+SimpleAD::~SimpleAD ()
 {
-     get_turb_loc(xloc, yloc);
-     freestream_velocity.clear();
-     freestream_phi.clear();
-     disk_cell_count.clear();
-     freestream_velocity.resize(xloc.size(),0.0);
-     freestream_phi.resize(xloc.size(),0.0);
-     disk_cell_count.resize(xloc.size(),0.0);
-
-     Gpu::DeviceVector<Real> d_freestream_velocity(xloc.size());
-     Gpu::DeviceVector<Real> d_freestream_phi(yloc.size());
-     Gpu::DeviceVector<Real> d_disk_cell_count(yloc.size());
-     Gpu::copy(Gpu::hostToDevice, freestream_velocity.begin(), freestream_velocity.end(), d_freestream_velocity.begin());
-     Gpu::copy(Gpu::hostToDevice, freestream_phi.begin(), freestream_phi.end(), d_freestream_phi.begin());
-     Gpu::copy(Gpu::hostToDevice, disk_cell_count.begin(), disk_cell_count.end(), d_disk_cell_count.begin());
+#ifdef AMREX_USE_MPI
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+    if (!finalized) {
+        for (auto& planes : m_sampling_planes) {
+            if (planes.comm != MPI_COMM_NULL) MPI_Comm_free(&planes.comm);
+        }
+    }
+#endif
+}
 
-     Real* d_freestream_velocity_ptr = d_freestream_velocity.data();
-     Real* d_freestream_phi_ptr = d_freestream_phi.data();
-     Real* d_disk_cell_count_ptr     = d_disk_cell_count.data();
+/**
+ * Sampling planes for the grids of mf_SMark, rebuilt when the grids of its level change
+ *
+ * @param mf_SMark MultiFab marking the sampling (component 0) and actuator (component 1) disks
+ * @param geom Geometry at the level of mf_SMark
+ */
+const SamplingPlanes&
+SimpleAD::sampling_planes (const MultiFab& mf_SMark, const Geometry& geom)
+{
+    for (auto& planes : m_sampling_planes) {
+        if (planes.domain == geom.Domain() &&
+            planes.ba == mf_SMark.boxArray() &&
+            planes.dm == mf_SMark.DistributionMap()) return planes;
+    }
+    for (auto& planes : m_sampling_planes) {
+        if (planes.domain == geom.Domain()) {
+            build_sampling_planes(mf_SMark, geom, planes);
+            return planes;
+        }
+    }
+    m_sampling_planes.emplace_back();
+    build_sampling_planes(mf_SMark, geom, m_sampling_planes.back());
+    return m_sampling_planes.back();
+}
 
+/**
+ * Find the cells of each local box that sample the freestream of each turbine
+ *
+ * @param mf_SMark MultiFab marking the sampling (component 0) and actuator (component 1) disks
+ * @param geom Geometry at the level of mf_SMark
+ * @param planes Sampling planes to fill
+ */
+void
+SimpleAD::build_sampling_planes (const MultiFab& mf_SMark,
+                                 const Geometry& geom,
+                                 SamplingPlanes& planes)
+{
+    BL_PROFILE("ERF::SimpleAD::build_sampling_planes()");
 
-     for ( MFIter mfi(cons_in,TilingIfNotGPU()); mfi.isValid(); ++mfi) {
+    AMREX_ALWAYS_ASSERT(mf_SMark.nGrow() >= 1);
 
-        auto SMark_array    = mf_SMark.array(mfi);
-        auto u_vel          = U_old.array(mfi);
-        auto v_vel          = V_old.array(mfi);
-        Box tbx = mfi.nodaltilebox(0);
+    planes.domain = geom.Domain();
+    planes.ba = mf_SMark.boxArray();
+    planes.dm = mf_SMark.DistributionMap();
+    planes.planes.assign(mf_SMark.local_size(), {});
 
-        ParallelFor(tbx, [=] AMREX_GPU_DEVICE(int i, int j, int k) noexcept {
+    const TurbineIndex& index = find_turb_index(mf_SMark, geom, true);
 
-            if(SMark_array(i,j,k,0) != -1.0) {
-                int turb_index = static_cast<int>(SMark_array(i,j,k,0));
-                Real phi = std::atan2(v_vel(i,j,k),u_vel(i,j,k)); // Wind direction w.r.t the x-dreiction
-                Gpu::Atomic::Add(&d_freestream_velocity_ptr[turb_index],std::pow(u_vel(i,j,k)*u_vel(i,j,k) + v_vel(i,j,k)*v_vel(i,j,k),0.5));
-                Gpu::Atomic::Add(&d_disk_cell_count_ptr[turb_index],1.0);
-                Gpu::Atomic::Add(&d_freestream_phi_ptr[turb_index],phi);
+    constexpr int imax = std::numeric_limits<int>::max();
+    constexpr int imin = std::numeric_limits<int>::lowest();
+
+    bool owns_disks = false;
+    for (MFIter mfi(mf_SMark); mfi.isValid(); ++mfi)
+    {
+        const int n_box_turb = index.count(mfi.LocalIndex());
+        if (n_box_turb == 0) continue;
+        owns_disks = true;
+
+        // Cells up to the nodal high face of the box are sampled
+        const Box gbx = amrex::grow(mfi.validbox(), 1);
+        auto const& SMark_array = mf_SMark.const_array(mfi);
+
+        for (int m = 0; m < n_box_turb; ++m)
+        {
+            const Real turb = index.host_ids(mfi.LocalIndex())[m];
+
+            ReduceOps<ReduceOpMin, ReduceOpMin, ReduceOpMin,
+                      ReduceOpMax, ReduceOpMax, ReduceOpMax> reduce_op;
+            ReduceData<int, int, int, int, int, int> reduce_data(reduce_op);
+            using ReduceTuple = typename decltype(reduce_data)::Type;
+
+            reduce_op.eval(gbx, reduce_data,
+            [=] AMREX_GPU_DEVICE (int i, int j, int k) -> ReduceTuple
+            {
+                if (SMark_array(i,j,k,0) == turb) {
+                    return {i, j, k, i, j, k};
+                }
+                return {imax, imax, imax, imin, imin, imin};
+            });
+
+            ReduceTuple r = reduce_data.value(reduce_op);
+            if (amrex::get<0>(r) <= amrex::get<3>(r)) {
+                planes.planes[mfi.LocalIndex()].emplace_back(static_cast<int>(turb),
+                    Box(IntVect(amrex::get<0>(r), amrex::get<1>(r), amrex::get<2>(r)),
+                        IntVect(amrex::get<3>(r), amrex::get<4>(r), amrex::get<5>(r))));
             }
-        });
+        }
     }
 
-    // Copy back to host
-    Gpu::copy(Gpu::deviceToHost, d_freestream_velocity.begin(), d_freestream_velocity.end(), freestream_velocity.begin());
-    Gpu::copy(Gpu::deviceToHost, d_freestream_phi.begin(), d_freestream_phi.end(), freestream_phi.begin());
-    Gpu::copy(Gpu::deviceToHost, d_disk_cell_count.begin(), d_disk_cell_count.end(), disk_cell_count.begin());
+    planes.uses_freestream = owns_disks || ParallelDescriptor::IOProcessor();
 
-    // Reduce the data on every processor
-    amrex::ParallelAllReduce::Sum(freestream_velocity.data(),
-                                  freestream_velocity.size(),
-                                  amrex::ParallelContext::CommunicatorAll());
+#ifdef AMREX_USE_MPI
+    if (planes.comm != MPI_COMM_NULL) MPI_Comm_free(&planes.comm);
+    MPI_Comm_split(ParallelDescriptor::Communicator(),
+                   (planes.uses_freestream) ? 0 : MPI_UNDEFINED,
+                   ParallelDescriptor::MyProc(), &planes.comm);
+#endif
+}
+
+/**
+ * Average the velocity magnitude and direction over the sampling disk of each turbine
+ *
+ * Each box sums over the sampling cells of the turbines binned with it, and the sums
+ * of all turbines are combined across the ranks that use them in a single reduction.
+ *
+ * @param geom Geometry at the level of the MultiFabs
+ * @param cons_in Cell-centered conserved state
+ * @param U_old x-velocity
+ * @param V_old y-velocity
+ * @param mf_SMark MultiFab marking the sampling (component 0) and actuator (component 1) disks
+ */
+void SimpleAD::compute_freestream_velocity(const Geometry& geom,
+                                           const MultiFab& cons_in,
+                                           const MultiFab& U_old,
+                                           const MultiFab& V_old,
+                                           const MultiFab& mf_SMark)
+{
+    BL_PROFILE("ERF::SimpleAD::compute_freestream_velocity()");
 
-    amrex::ParallelAllReduce::Sum(freestream_phi.data(),
-                                  freestream_phi.size(),
-                                  amrex::ParallelContext::CommunicatorAll());
+    get_turb_loc(xloc, yloc);
+    const int nturbs = xloc.size();
 
+    const SamplingPlanes& planes = sampling_planes(mf_SMark, geom);
 
-   amrex::ParallelAllReduce::Sum(disk_cell_count.data(),
-                                 disk_cell_count.size(),
-                                 amrex::ParallelContext::CommunicatorAll());
+    // Sums of the velocity magnitude, the wind direction and the number of cells
+    // over the sampling disk of each turbine, packed for a single reduction
+    Vector<Real> sums(3*nturbs, 0.0);
 
-    get_turb_loc(xloc, yloc);
-    std::cout << "xloc size is " << xloc.size() << "\n";
-    if (ParallelDescriptor::IOProcessor()){
-        for(int it=0; it<xloc.size(); it++){
-
-            std::cout << "turbine index, freestream velocity is " << it << " " << freestream_velocity[it] << " " <<
-                                                               disk_cell_count[it]  <<  " " <<
-                                                                freestream_velocity[it]/(disk_cell_count[it] + 1e-10) << " " <<
-                                                                freestream_phi[it]/(disk_cell_count[it] + 1e-10) << "\n";
+    for ( MFIter mfi(cons_in); mfi.isValid(); ++mfi) {
+        BoxCostTimer box_timer(m_box_cost, mfi);
+
+        const auto& box_planes = planes.planes[mfi.LocalIndex()];
+        if (box_planes.empty()) continue;
+
+        auto SMark_array    = mf_SMark.const_array(mfi);
+        auto u_vel          = U_old.const_array(mfi);
+        auto v_vel          = V_old.const_array(mfi);
+        const Box tbx = mfi.nodaltilebox(0);
+
+        for (const auto& plane : box_planes) {
+            const Box pbx = tbx & amrex::convert(plane.second, tbx.ixType());
+            if (!pbx.ok()) continue;
+            const Real turb = plane.first;
+
+            ReduceOps<ReduceOpSum, ReduceOpSum, ReduceOpSum> reduce_op;
+            ReduceData<Real, Real, Real> reduce_data(reduce_op);
+            using ReduceTuple = typename decltype(reduce_data)::Type;
+
+            reduce_op.eval(pbx, reduce_data,
+            [=] AMREX_GPU_DEVICE (int i, int j, int k) -> ReduceTuple
+            {
+                if (SMark_array(i,j,k,0) == turb) {
+                    Real vel = std::pow(u_vel(i,j,k)*u_vel(i,j,k) + v_vel(i,j,k)*v_vel(i,j,k),0.5);
+                    Real phi = std::atan2(v_vel(i,j,k),u_vel(i,j,k)); // Wind direction w.r.t the x-dreiction
+                    return {vel, phi, 1.0};
+                }
+                return {0.0, 0.0, 0.0};
+            });
+
+            ReduceTuple r = reduce_data.value(reduce_op);
+            sums[3*plane.first  ] += amrex::get<0>(r);
+            sums[3*plane.first+1] += amrex::get<1>(r);
+            sums[3*plane.first+2] += amrex::get<2>(r);
         }
     }
+
+#ifdef AMREX_USE_MPI
+    // Ranks without actuator disks need no freestream
+    if (planes.comm != MPI_COMM_NULL) {
+        ParallelAllReduce::Sum(sums.data(), static_cast<int>(sums.size()), planes.comm);
+    }
+#endif
+
+    freestream_velocity.resize(nturbs);
+    freestream_phi.resize(nturbs);
+    disk_cell_count.resize(nturbs);
+    for (int it = 0; it < nturbs; ++it) {
+        freestream_velocity[it] = sums[3*it  ];
+        freestream_phi[it]      = sums[3*it+1];
+        disk_cell_count[it]     = sums[3*it+2];
+    }
+}
+
+/**
+ * Append the freestream of each turbine, as last computed, to a time-series log
+ *
+ * Each call writes one line per turbine with the level, time, turbine index, number of
+ * sampling cells and the averaged velocity magnitude and direction.
+ *
+ * @param filename Name of the log, created with a header line if it does not exist
+ * @param lev Level of the last advance
+ * @param time Time at the start of the last advance
+ */
+void
+SimpleAD::write_freestream_log (const std::string& filename, int lev, const Real& time)
+{
+    if (!ParallelDescriptor::IOProcessor()) return;
+
+    const bool new_file = !FileExists(filename);
+    std::ofstream log(filename, std::ios::app);
+    if (!log.good()) {
+        FileOpenFailed(filename);
+    }
+    if (new_file) {
+        log << "# lev time turbine ncells freestream_velocity freestream_phi\n";
+    }
+
+    log << std::setprecision(12);
+    for (int it = 0; it < freestream_velocity.size(); ++it) {
+        log << lev << " " << time << " " << it << " "
+            << disk_cell_count[it] << " "
+            << freestream_velocity[it]/(disk_cell_count[it] + 1e-10) << " "
+            << freestream_phi[it]/(disk_cell_count[it] + 1e-10) << "\n";
+    }
 }
 
 void
@@ -173,7 +334,16 @@ SimpleAD::source_terms_cellcentered (const Geometry& geom,
     Real ny = -std::sin(turb_disk_angle);
     Real d_turb_disk_angle = turb_disk_angle;
 
+    const TurbineIndex& index = find_turb_index(mf_SMark, geom, true);
+
     for ( MFIter mfi(cons_in,TilingIfNotGPU()); mfi.isValid(); ++mfi) {
+        BoxCostTimer box_timer(m_box_cost, mfi);
+
+        // Only the disks binned with this box can mark its cells; without any
+        // the source terms keep the zero they were set to
+        const int n_box_turb = index.count(mfi.LocalIndex());
+        if (n_box_turb == 0) continue;
+        const int* box_turb = index.ids(mfi.LocalIndex());
 
         const Box& gbx      = mfi.growntilebox(1);
         auto SMark_array    = mf_SMark.array(mfi);
@@ -189,7 +359,8 @@ SimpleAD::source_terms_cellcentered (const Geometry& geom,
             Real source_x = 0.0;
             Real source_y = 0.0;
 
-            for(long unsigned int it=0;it<nturbs;it++) {
+            for(int m=0;m<n_box_turb;m++) {
+                const int it = box_turb[m];
                 Real avg_vel  = d_freestream_velocity_ptr[it]/(d_disk_cell_count_ptr[it] + 1e-10);
                 Real phi      = d_freestream_phi_ptr[it]/(d_disk_cell_count_ptr[it] + 1e-10);
 